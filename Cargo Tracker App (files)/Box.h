@@ -41,8 +41,8 @@ public:
     }
 
     // This override method calculates the volume of the box.
-    int volume() const override {
-        return m_length * m_breadth * height();
+    qint64 volume() const override {
+        return qint64(m_length) * m_breadth * height();
     }
 
     // This override method returns the type name of the container as a string.
@@ -1,10 +1,32 @@
 #include "CodeGenerator.h"
 #include <QString>
 
+// Returns an empty code once the month's serials are used up, rather than handing out one twice.
 QString CodeGenerator::nextCode(ContainerKind kind, const QDate& date){
     const int y=date.year(); const int m=date.month();
     if (y!=m_year || m!=m_month){ m_year=y; m_month=m; m_serial=0; }
-    m_serial = qMin(m_serial+1, 9999);
+    if (m_serial >= MaxSerial) return QString();
+    ++m_serial;
     const QChar typeChar = (kind==ContainerKind::Box? QChar('B'): QChar('C'));
     return QString::number(m_year).rightJustified(4, '0') + "/" + QString::number(m_month).rightJustified(2,'0') + "/" + typeChar + QString::number(m_serial);
 }
+
+// Same codes as count calls to nextCode, but the year/month/type prefix is only formatted once.
+// Returns fewer than count codes if the month runs out; remaining() tells how many are left.
+QStringList CodeGenerator::nextCodes(ContainerKind kind, int count, const QDate& date){
+    QStringList codes;
+    count = qMin(count, remaining(date));
+    if (count <= 0) return codes;
+    codes.reserve(count);
+    const QString first = nextCode(kind, date);
+    codes << first;
+    const QString prefix = first.left(9);
+    for (int i = 1; i < count; ++i){ ++m_serial; codes << prefix + QString::number(m_serial); }
+    return codes;
+}
+
+// Box and cylinder codes share the serials, so this is the number of containers of either kind.
+int CodeGenerator::remaining(const QDate& date) const{
+    if (date.year()!=m_year || date.month()!=m_month) return MaxSerial;
+    return MaxSerial - m_serial;
+}
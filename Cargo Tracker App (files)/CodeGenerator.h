@@ -2,14 +2,18 @@
 #define CODEGENERATOR_H
 #include <QObject>
 #include <QDate>
+#include <QStringList>
 
 enum class ContainerKind{ Box, Cylinder };
 
 class CodeGenerator : public QObject{
     Q_OBJECT
 public:
+    static constexpr int MaxSerial = 9999;
     explicit CodeGenerator(QObject* parent=nullptr): QObject(parent) {}
     QString nextCode(ContainerKind kind, const QDate& date=QDate::currentDate());
+    QStringList nextCodes(ContainerKind kind, int count, const QDate& date=QDate::currentDate());
+    int remaining(const QDate& date=QDate::currentDate()) const;
 private:
     int m_year{0}; int m_month{0}; int m_serial{0};
 };
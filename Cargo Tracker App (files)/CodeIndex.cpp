@@ -0,0 +1,143 @@
+#include "CodeIndex.h"
+#include "Container.h"
+#include "ContainerCode.h"
+
+namespace {
+
+// This helper packs the fields of a code the way ContainerCode::pack does.
+quint32 packFields(int year, int month, quint32 type, int serial, quint32 digits){
+    return (quint32(year - 2000) << 21) | (quint32(month) << 17) | (type << 16) | (quint32(serial) << 2) | digits;
+}
+
+// This helper reads the digits of text[from, from + count); digits past the end of the text read as 0 in
+// low and 9 in high. It returns false if a present character is not a digit.
+bool readDigits(QStringView text, int from, int count, int& low, int& high){
+    low = high = 0;
+    for(int i = from; i < from + count; ++i){
+        if(i < text.size()){
+            const char16_t u = text[i].unicode();
+            if(u < u'0' || u > u'9') return false;
+            low = low * 10 + int(u - u'0');
+            high = high * 10 + int(u - u'0');
+        } else {
+            low = low * 10;
+            high = high * 10 + 9;
+        }
+    }
+    return true;
+}
+
+// This helper finds the lowest and highest packed code that can start with a prefix of a code's text.
+// Every code between the two starts with the prefix, except when the prefix ends within the serial: then
+// "C1" also spans C2 to C9, C20 to C99 and so on, which the caller filters out by text.
+bool prefixBounds(QStringView prefix, quint32& low, quint32& high){
+    const int n = int(prefix.size());
+    int yearLow, yearHigh;
+    if(!readDigits(prefix, 0, 4, yearLow, yearHigh)) return false;
+    yearLow = qMax(yearLow, 2000);
+    yearHigh = qMin(yearHigh, 2127);
+    if(yearLow > yearHigh) return false;
+
+    int monthLow = 1, monthHigh = 12;
+    quint32 typeLow = 0, typeHigh = 1;
+    int serialLow = 0, serialHigh = 0x3FFF;
+    quint32 digitsLow = 0, digitsHigh = 3;
+    if(n > 4 && prefix[4] != QLatin1Char('/')) return false;
+    if(n > 5){
+        if(!readDigits(prefix, 5, 2, monthLow, monthHigh)) return false;
+        monthLow = qMax(monthLow, 1);
+        monthHigh = qMin(monthHigh, 12);
+        if(monthLow > monthHigh) return false;
+    }
+    if(n > 7 && prefix[7] != QLatin1Char('/')) return false;
+    if(n > 8){
+        if(prefix[8] == QLatin1Char('B')) typeLow = typeHigh = 0;
+        else if(prefix[8] == QLatin1Char('C')) typeLow = typeHigh = 1;
+        else return false;
+    }
+    if(n > 9){
+        // A serial that starts with k given digits has at least k digits and lies in [s, (s+1)*10^(4-k)).
+        const int given = n - 9;
+        int unused;
+        if(given > 4 || !readDigits(prefix, 9, given, serialLow, unused)) return false;
+        serialHigh = serialLow + 1;
+        for(int i = given; i < 4; ++i) serialHigh *= 10;
+        serialHigh -= 1;
+        digitsLow = quint32(given - 1);
+    }
+    low = packFields(yearLow, monthLow, typeLow, serialLow, digitsLow);
+    high = packFields(yearHigh, monthHigh, typeHigh, serialHigh, digitsHigh);
+    return true;
+}
+
+} // namespace
+
+// This method indexes one container.
+void CodeIndex::insert(Container* c){
+    if(!c) return;
+    const quint32 code = ContainerCode::pack(c->code());
+    if(code != 0) m_codes.insert(code, c);
+}
+
+// This method indexes a batch of containers.
+void CodeIndex::insert(const QVector<Container*>& batch){
+    for(auto* c: batch) insert(c);
+}
+
+// This method drops one container from the index.
+void CodeIndex::remove(Container* c){
+    if(!c) return;
+    const quint32 code = ContainerCode::pack(c->code());
+    if(code != 0) m_codes.remove(code, c);
+}
+
+// This method drops a batch of containers from the index.
+void CodeIndex::remove(const QVector<Container*>& batch){
+    for(auto* c: batch) remove(c);
+}
+
+// This method reads the query, finds its lowest and highest packed code and walks the codes between.
+CodeIndex::Matches CodeIndex::find(const QString& query, int limit) const{
+    Matches out;
+    const QString text = query.trimmed().toUpper();
+    if(text.isEmpty()){
+        out.valid = false;
+        return out;
+    }
+
+    quint32 low = 0, high = 0;
+    QString prefix;     // Set when the matches must also start with this text.
+    const int dots = int(text.indexOf(QLatin1String("..")));
+    if(dots >= 0){
+        // A complete code as the upper end stops at that code; only a prefix takes in all that start with it.
+        // Serials are compared by value: the digit-count bits, which sort last, are cleared in the lower
+        // bound and set in the upper one, so B0150 and B150 both lie in B100..B199 and B0199 does too.
+        quint32 unused;
+        QString from = text.left(dots).trimmed(), to = text.mid(dots + 2).trimmed();
+        if(from.endsWith(QLatin1Char('*'))) from.chop(1);
+        const quint32 exactTo = to.endsWith(QLatin1Char('*')) ? 0 : ContainerCode::pack(to);
+        if(to.endsWith(QLatin1Char('*'))) to.chop(1);
+        out.valid = prefixBounds(from, low, unused) && prefixBounds(to, unused, high);
+        if(exactTo != 0) high = exactTo;
+        low &= ~quint32(3);
+        high |= 3;
+    } else if(!text.endsWith(QLatin1Char('*')) && (low = ContainerCode::pack(text)) != 0){
+        high = low;
+    } else {
+        prefix = text;
+        if(prefix.endsWith(QLatin1Char('*'))) prefix.chop(1);
+        out.valid = prefixBounds(prefix, low, high);
+        if(prefix.size() <= 9) prefix.clear();
+    }
+    if(!out.valid || low > high) return out;
+
+    for(auto it = m_codes.lowerBound(low); it != m_codes.cend() && it.key() <= high; ++it){
+        if(!prefix.isEmpty() && !it.value()->code().startsWith(prefix)) continue;
+        if(out.containers.size() == limit){
+            out.more = true;
+            break;
+        }
+        out.containers.push_back(it.value());
+    }
+    return out;
+}
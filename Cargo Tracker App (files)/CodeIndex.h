@@ -0,0 +1,49 @@
+#ifndef CODEINDEX_H
+#define CODEINDEX_H
+#include <QMultiMap>
+#include <QString>
+#include <QVector>
+class Container;
+
+// The CodeIndex class finds containers by code, whether they are unallocated or on a pallet. It keeps
+// the containers ordered by packed code (see ContainerCode), which sorts by year, month, type and serial,
+// so every query is a lookup of its lowest code followed by a walk to its highest: O(log n + matches).
+// Queries are
+// - a complete code, such as "2026/10/C12", which finds that code only;
+// - a prefix, such as "2026", "2026/1*" or "2026/10/C1*" (the '*' is optional unless the text is a
+//   complete code);
+// - a range of codes or prefixes, such as "2026/01..2026/06" or "2026/10/B100..2026/10/B199". Serials
+//   in a range are compared by value, so zero-padded codes such as B0150 fall in that range too.
+// The index is kept up to date by ManageTab as containers are created, imported, restored and deleted;
+// moving a container to a pallet does not change it, since the owner is the container's parent.
+// Codes are set before a container is indexed and never change afterwards. Containers whose code is not
+// a valid code are not indexed.
+class CodeIndex{
+public:
+    // The Matches struct is the answer to a query, in code order.
+    struct Matches{
+        QVector<Container*> containers;
+        bool more{false};       // Whether there were more matches than the limit.
+        bool valid{true};       // Whether the query could be read at all.
+    };
+
+    // These methods add containers to the index.
+    void insert(Container* c);
+    void insert(const QVector<Container*>& batch);
+    // These methods remove containers from the index.
+    void remove(Container* c);
+    void remove(const QVector<Container*>& batch);
+
+    // This method returns the number of indexed containers.
+    int size() const { return int(m_codes.size()); }
+
+    // This method returns the first limit containers that match a query.
+    Matches find(const QString& query, int limit) const;
+
+private:
+    // The indexed containers by packed code. Codes are unique in practice, but a restored backup briefly
+    // shares its codes with the containers it replaces, so equal codes are allowed.
+    QMultiMap<quint32, Container*> m_codes;
+};
+
+#endif // CODEINDEX_H
@@ -3,9 +3,11 @@
 
 #include <QObject>
 #include <QString>
+#include "MemoryAccounting.h"
 
 // The Container is an abstract base class that defines the common interface for all types of containers.
-class Container : public QObject {
+// Container objects are counted under Memory::Domain::Containers when memory accounting is on.
+class Container : public QObject, public Memory::Tracked<Memory::Domain::Containers> {
     Q_OBJECT
     // The Q_PROPERTY macro declares properties for the class, enabling them to be used with the Qt Meta-Object System.
     // The NOTIFY signal is emitted when the property's value changes.
@@ -49,7 +51,8 @@ public:
     }
 
     // A pure virtual function to calculate the volume of the container. Derived classes must implement this.
-    virtual int volume() const = 0;
+    // It is 64-bit because the largest boxes the spin boxes allow exceed an int.
+    virtual qint64 volume() const = 0;
     // A pure virtual function to get the type name of the container. Derived classes must implement this.
     virtual QString typeName() const = 0;
     // A pure virtual function to create a clone of the container. Derived classes must implement this.
@@ -0,0 +1,281 @@
+#include "ContainerImporter.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QThreadPool>
+#include <algorithm>
+#include <string_view>
+#include "Trace.h"
+
+namespace {
+
+// The result of one chunk. Problem lines count from the chunk's start and are fixed up when joining.
+struct Chunk{
+    qint64 begin{0};
+    qint64 end{0};
+    QVector<ImportedContainer> containers;
+    qint64 rejected{0};
+    int newlines{0};
+    QVector<QPair<int, QString>> problems;
+};
+
+// How often, in entries, a parser checks for cancellation.
+constexpr int CancelCheckInterval = 4096;
+
+// This helper removes spaces, tabs and carriage returns from both ends.
+std::string_view trimmed(std::string_view s){
+    while(!s.empty() && (s.front() == ' ' || s.front() == '\t' || s.front() == '\r')) s.remove_prefix(1);
+    while(!s.empty() && (s.back() == ' ' || s.back() == '\t' || s.back() == '\r')) s.remove_suffix(1);
+    return s;
+}
+
+// This helper reads a non-negative decimal number of at most nine digits.
+bool readNumber(std::string_view s, int& value){
+    s = trimmed(s);
+    if(s.empty() || s.size() > 9) return false;
+    int v = 0;
+    for(const char ch: s){
+        if(ch < '0' || ch > '9') return false;
+        v = v * 10 + (ch - '0');
+    }
+    value = v;
+    return true;
+}
+
+// This helper compares ASCII text ignoring case.
+bool sameText(std::string_view a, std::string_view b){
+    if(a.size() != b.size()) return false;
+    for(size_t i = 0; i < a.size(); ++i){
+        if((a[i] | 0x20) != (b[i] | 0x20)) return false;
+    }
+    return true;
+}
+
+// This helper checks the ranges of a parsed container and returns an empty string if it is acceptable.
+QString checkLimits(const ImportedContainer& c, const ImportLimits& limits){
+    auto dimension = [&](const char* name, int v) -> QString{
+        if(v >= limits.minDimension && v <= limits.maxDimension) return {};
+        return QString("%1 %2 is outside %3-%4").arg(name).arg(v).arg(limits.minDimension).arg(limits.maxDimension);
+    };
+    QString problem;
+    if(c.kind == ContainerKind::Box){
+        problem = dimension("length", c.length);
+        if(problem.isEmpty()) problem = dimension("breadth", c.breadth);
+    } else {
+        problem = dimension("diameter", c.diameter);
+    }
+    if(problem.isEmpty()) problem = dimension("height", c.height);
+    if(problem.isEmpty() && (c.weight < limits.minWeight || c.weight > limits.maxWeight)){
+        problem = QString("weight %1 is outside %2-%3").arg(c.weight).arg(limits.minWeight).arg(limits.maxWeight);
+    }
+    return problem;
+}
+
+// This helper files a parsed container, or a rejection if it is malformed or out of range.
+void accept(Chunk& out, int line, const ImportedContainer& c, QString problem, const ImportLimits& limits){
+    if(problem.isEmpty()) problem = checkLimits(c, limits);
+    if(problem.isEmpty()){
+        out.containers.push_back(c);
+        return;
+    }
+    ++out.rejected;
+    if(out.problems.size() < ContainerImporter::MaxProblems) out.problems.push_back({line, problem});
+}
+
+// This helper parses one CSV line, which has no line break.
+void parseCsvLine(std::string_view text, int line, const ImportLimits& limits, Chunk& out){
+    text = trimmed(text);
+    if(text.empty() || text.front() == '#') return;
+
+    std::string_view fields[6];
+    int count = 0;
+    while(count < 6){
+        const size_t cut = text.find_first_of(",;\t");
+        fields[count++] = trimmed(text.substr(0, cut));
+        if(cut == std::string_view::npos) break;
+        text.remove_prefix(cut + 1);
+    }
+
+    ImportedContainer c;
+    int* values[4];
+    int expected = 0;
+    if(sameText(fields[0], "box") || sameText(fields[0], "b")){
+        c.kind = ContainerKind::Box;
+        values[0] = &c.length; values[1] = &c.breadth; values[2] = &c.height; values[3] = &c.weight;
+        expected = 4;
+    } else if(sameText(fields[0], "cylinder") || sameText(fields[0], "c")){
+        c.kind = ContainerKind::Cylinder;
+        values[0] = &c.diameter; values[1] = &c.height; values[2] = &c.weight;
+        expected = 3;
+    } else if(sameText(fields[0], "type") || sameText(fields[0], "kind")){
+        return; // A header line.
+    } else {
+        accept(out, line, c, QString("unknown container type \"%1\"")
+                                 .arg(QString::fromUtf8(fields[0].data(), int(fields[0].size()))), limits);
+        return;
+    }
+
+    QString problem;
+    if(count != expected + 1){
+        problem = QString("expected %1 values after the type, found %2").arg(expected).arg(count - 1);
+    } else {
+        for(int i = 0; i < expected && problem.isEmpty(); ++i){
+            if(!readNumber(fields[i + 1], *values[i])) problem = QString("value %1 is not a whole number").arg(i + 1);
+        }
+    }
+    accept(out, line, c, problem, limits);
+}
+
+// This helper parses the CSV lines of a chunk, which starts at the beginning of a line.
+void parseCsv(std::string_view text, const ImportLimits& limits, const std::atomic<bool>& cancel, Chunk& out){
+    int line = 0;
+    while(!text.empty()){
+        if(line % CancelCheckInterval == 0 && cancel.load(std::memory_order_relaxed)) return;
+        const size_t eol = text.find('\n');
+        parseCsvLine(text.substr(0, eol), ++line, limits, out);
+        if(eol == std::string_view::npos) break;
+        ++out.newlines;
+        text.remove_prefix(eol + 1);
+    }
+}
+
+// This helper tells whether an element of the given name starts at text[pos], which is a '<'.
+bool startsElement(std::string_view text, size_t pos, std::string_view name){
+    if(text.compare(pos + 1, name.size(), name) != 0) return false;
+    const size_t next = pos + 1 + name.size();
+    return next < text.size() && (text[next] == '>' || text[next] == ' ' || text[next] == '\t'
+                                  || text[next] == '\r' || text[next] == '\n');
+}
+
+// This helper finds the next <Box> or <Cylinder> start tag at or after pos; it returns npos if none.
+size_t findElement(std::string_view text, size_t pos){
+    while((pos = text.find('<', pos)) != std::string_view::npos){
+        if(startsElement(text, pos, "Box") || startsElement(text, pos, "Cylinder")) return pos;
+        ++pos;
+    }
+    return std::string_view::npos;
+}
+
+// This helper reads the number in a child element such as <height>120</height>.
+bool childValue(std::string_view body, std::string_view name, int& value){
+    for(size_t at = body.find(name); at != std::string_view::npos; at = body.find(name, at + 1)){
+        const size_t first = at + name.size() + 1;
+        if(at == 0 || body[at - 1] != '<' || first > body.size() || body[first - 1] != '>') continue;
+        const size_t close = body.find('<', first);
+        return close != std::string_view::npos && readNumber(body.substr(first, close - first), value);
+    }
+    return false;
+}
+
+// This helper parses the <Box> and <Cylinder> elements of a chunk, which starts at an element or at the
+// beginning of the file.
+void parseXml(std::string_view text, const ImportLimits& limits, const std::atomic<bool>& cancel, Chunk& out){
+    size_t pos = 0;
+    size_t counted = 0;     // Newlines before text[counted] are in out.newlines.
+    int elements = 0;
+    while((pos = findElement(text, pos)) != std::string_view::npos){
+        if(++elements % CancelCheckInterval == 0 && cancel.load(std::memory_order_relaxed)) return;
+        out.newlines += int(std::count(text.begin() + counted, text.begin() + pos, '\n'));
+        counted = pos;
+        const int line = out.newlines + 1;
+
+        ImportedContainer c;
+        c.kind = text[pos + 1] == 'B' ? ContainerKind::Box : ContainerKind::Cylinder;
+        const std::string_view closeTag = c.kind == ContainerKind::Box ? "</Box>" : "</Cylinder>";
+        const size_t end = text.find(closeTag, pos);
+        if(end == std::string_view::npos){
+            accept(out, line, c, "the element is not closed", limits);
+            break;
+        }
+        const std::string_view body = text.substr(pos, end - pos);
+        bool ok = childValue(body, "height", c.height) && childValue(body, "weight", c.weight);
+        if(c.kind == ContainerKind::Box){
+            ok = ok && childValue(body, "length", c.length) && childValue(body, "breadth", c.breadth);
+        } else {
+            ok = ok && childValue(body, "diameter", c.diameter);
+        }
+        accept(out, line, c, ok ? QString() : QString("missing or invalid dimension or weight"), limits);
+        pos = end + closeTag.size();
+    }
+    out.newlines += int(std::count(text.begin() + counted, text.end(), '\n'));
+}
+
+// This helper moves a chunk boundary forward to the next line (CSV) or element (XML).
+qint64 nextBoundary(std::string_view text, qint64 cut, bool xml){
+    if(cut >= qint64(text.size())) return qint64(text.size());
+    const size_t at = xml ? findElement(text, size_t(cut)) : text.find('\n', size_t(cut));
+    if(at == std::string_view::npos) return qint64(text.size());
+    return xml ? qint64(at) : qint64(at) + 1;
+}
+
+} // namespace
+
+// This slot maps the file, parses its chunks on a thread pool and joins them in file order.
+void ContainerImporter::run(const QString& path){
+    TRACE_SPAN("import");
+    m_result = ImportResult();
+    QFile file(path);
+    if(!file.open(QIODevice::ReadOnly)){
+        m_result.error = QString("Cannot read %1: %2").arg(path, file.errorString());
+        emit finished();
+        return;
+    }
+
+    // Files that cannot be mapped (empty ones, or some special files) are read instead.
+    QByteArray copy;
+    qint64 size = file.size();
+    const char* data = size > 0 ? reinterpret_cast<const char*>(file.map(0, size)) : nullptr;
+    if(!data){
+        copy = file.readAll();
+        data = copy.constData();
+        size = copy.size();
+    }
+    std::string_view text(data, size_t(size));
+    if(text.substr(0, 3) == "\xEF\xBB\xBF") text.remove_prefix(3);
+
+    const QString suffix = QFileInfo(path).suffix().toLower();
+    const size_t firstChar = text.find_first_not_of(" \t\r\n");
+    const bool xml = suffix == "xml" || (firstChar != std::string_view::npos && text[firstChar] == '<');
+
+    // Cuts the text into chunks, several per thread so the threads finish at about the same time.
+    QThreadPool pool;
+    const qint64 target = qMax(MinChunkBytes, qint64(text.size()) / (pool.maxThreadCount() * 8) + 1);
+    QVector<Chunk> chunks;
+    for(qint64 begin = 0; begin < qint64(text.size());){
+        Chunk c;
+        c.begin = begin;
+        c.end = nextBoundary(text, begin + target, xml);
+        begin = c.end;
+        chunks.push_back(std::move(c));
+    }
+
+    std::atomic<qint64> done{0};
+    for(Chunk& c: chunks){
+        pool.start([this, &c, &done, text, xml]{
+            TRACE_SPAN("importChunk");
+            const std::string_view part = text.substr(size_t(c.begin), size_t(c.end - c.begin));
+            if(xml) parseXml(part, m_limits, m_cancel, c);
+            else parseCsv(part, m_limits, m_cancel, c);
+            const qint64 total = done.fetch_add(c.end - c.begin) + (c.end - c.begin);
+            emit progress(int(total * 100 / qMax<qint64>(1, qint64(text.size()))));
+        });
+    }
+    pool.waitForDone();
+
+    // Joins the chunks in order; problem lines become file lines by counting the lines of earlier chunks.
+    m_result.cancelled = m_cancel.load(std::memory_order_relaxed);
+    if(!m_result.cancelled){
+        qsizetype total = 0;
+        for(const Chunk& c: chunks) total += c.containers.size();
+        m_result.containers.reserve(total);
+        int lines = 0;
+        for(const Chunk& c: chunks){
+            m_result.containers += c.containers;
+            m_result.rejected += c.rejected;
+            for(const auto& p: c.problems){
+                if(m_result.problems.size() < MaxProblems) m_result.problems << QString("Line %1: %2").arg(lines + p.first).arg(p.second);
+            }
+            lines += c.newlines;
+        }
+    }
+    emit finished();
+}
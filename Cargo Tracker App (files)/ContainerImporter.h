@@ -0,0 +1,80 @@
+#ifndef CONTAINERIMPORTER_H
+#define CONTAINERIMPORTER_H
+
+#include <QObject>
+#include <QStringList>
+#include <QVector>
+#include <atomic>
+#include "CodeGenerator.h"
+
+// The ImportedContainer struct is one container read from an import file, before it becomes a Box or a
+// Cylinder. Fields that do not apply to its kind are zero.
+struct ImportedContainer{
+    ContainerKind kind{ContainerKind::Box};
+    int length{0};
+    int breadth{0};
+    int diameter{0};
+    int height{0};
+    int weight{0};
+};
+
+// The ImportLimits struct holds the accepted ranges, the same as the spin boxes of the Containers tab.
+struct ImportLimits{
+    int minDimension{1};
+    int maxDimension{10000};
+    int minWeight{1};
+    int maxWeight{100000};
+};
+
+// The ImportResult struct is the outcome of an import, with the containers in file order.
+struct ImportResult{
+    QVector<ImportedContainer> containers;
+    qint64 rejected{0};         // Entries that were skipped because they were malformed or out of range.
+    QStringList problems;       // The first few rejections, with their line numbers.
+    bool cancelled{false};
+    QString error;              // Set if the file could not be read at all.
+};
+
+// The ContainerImporter class reads containers from a CSV or XML file. It is designed to run in a
+// separate thread, like SerializationWorker.
+// The file is memory-mapped and cut into chunks at line (CSV) or element (XML) boundaries; the chunks are
+// parsed in parallel on a thread pool and joined in file order, so even files of hundreds of thousands of
+// entries are read in a fraction of a second without being copied into memory first.
+// CSV lines are "box,length,breadth,height,weight" or "cylinder,diameter,height,weight" (commas,
+// semicolons or tabs; "b" and "c" also work; empty lines, "#" comments and a header line are skipped).
+// XML files hold <Box> and <Cylinder> elements as the client posts them; pallets and codes are ignored,
+// since imported containers are unallocated and get new codes.
+class ContainerImporter : public QObject{
+    Q_OBJECT
+public:
+    // The most rejections described in ImportResult::problems.
+    static constexpr int MaxProblems = 20;
+    // The smallest chunk handed to a parser thread.
+    static constexpr qint64 MinChunkBytes = 256 * 1024;
+
+    // This is the constructor. Entries outside the limits are rejected.
+    explicit ContainerImporter(const ImportLimits& limits, QObject* parent = nullptr): QObject(parent), m_limits(limits) {}
+
+    // This method asks a running import to stop soon. It can be called from any thread.
+    void cancel() { m_cancel.store(true, std::memory_order_relaxed); }
+
+    // This method hands over the result once finished() was emitted.
+    ImportResult takeResult() { return std::move(m_result); }
+
+public slots:
+    // This public slot is the entry point for the worker's task: it imports one file.
+    void run(const QString& path);
+
+signals:
+    // This signal is emitted as chunks are parsed, with the share of the file done in percent.
+    void progress(int percent);
+    // This signal is emitted when the import is complete, cancelled or failed; see takeResult().
+    void finished();
+
+private:
+    ImportLimits m_limits;
+    std::atomic<bool> m_cancel{false};
+    ImportResult m_result;
+};
+
+#endif // CONTAINERIMPORTER_H
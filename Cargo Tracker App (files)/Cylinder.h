@@ -27,10 +27,10 @@ public:
     }
 
     // This override method calculates the volume of the cylinder.
-    int volume() const override {
+    qint64 volume() const override {
         const double r = m_diameter / 2.0;
         const double v = 3.14159265358979323846 * r * r * height();
-        return static_cast<int>(qRound(v));
+        return qRound64(v);
     }
 
     // This override method returns the type name of the container as a string.
@@ -1,5 +1,7 @@
 #include "MainClient.h"
 #include <QAction>
+#include <QLabel>
+#include <QTimer>
 #include <QCloseEvent>
 #include <QMenu>
 #include <QMenuBar>
@@ -7,8 +9,12 @@
 #include <QStatusBar>
 #include <QToolBar>
 #include <QTabWidget>
+#include <QTreeView>
 #include "ManageTab.h"
 #include "SerializeTab.h"
+#include "QueryTab.h"
+#include "PalletTreeModel.h"
+#include "MemoryAccounting.h"
 
 // Constructor for the MainClient class. It initializes the main application window.
 MainClient::MainClient(QWidget* parent) : QMainWindow(parent) {
@@ -25,6 +31,16 @@ MainClient::MainClient(QWidget* parent) : QMainWindow(parent) {
     // Sets the window title and initial status bar message.
     setWindowTitle("Container Client");
     statusBar()->showMessage("Ready");
+
+    // With memory accounting on, keeps the per-subsystem figures in the status bar, refreshed every second.
+    if(Memory::enabled()){
+        memoryLabel = new QLabel(this);
+        statusBar()->addPermanentWidget(memoryLabel);
+        auto* memoryTimer = new QTimer(this);
+        connect(memoryTimer, &QTimer::timeout, this, &MainClient::showMemory);
+        memoryTimer->start(1000);
+        showMemory();
+    }
     // Sets the application icon.
     setWindowIcon(QIcon(":/info.png"));
 }
@@ -83,10 +99,18 @@ void MainClient::setupCentral(){
     // Creates instances of custom tab widgets.
     manage = new ManageTab(this);
     serialize = new SerializeTab(this);
+    query = new QueryTab(this);
+    // Every row is one line of text, so the view can place rows without measuring them; with millions of
+    // containers that is what keeps scrolling smooth.
+    palletView = new QTreeView(this);
+    palletView->setUniformRowHeights(true);
+    palletView->setModel(manage->palletModel());
 
     // Adds the custom tabs to the QTabWidget with icons and titles.
     tabs->addTab(manage, QIcon(":/images/box_icon.ico"), tr("Containers"));
+    tabs->addTab(palletView, QIcon(":/images/box_icon.ico"), tr("Pallets"));
     tabs->addTab(serialize, QIcon(":/images/server_icon.ico"), tr("Post XML"));
+    tabs->addTab(query, QIcon(":/images/server_icon.ico"), tr("Server"));
     // Sets the tab widget as the central widget of the main window.
     setCentralWidget(tabs);
 }
@@ -111,6 +135,10 @@ void MainClient::wire(){
             [this](const QString &msg) {
                 statusBar()->showMessage(msg, 5000); // Message displayed for 5 seconds.
             });
+    connect(query, &QueryTab::statusMessage, this,
+            [this](const QString &msg) {
+                statusBar()->showMessage(msg, 5000);
+            });
 }
 
 // Updates the state of various UI elements based on application data.
@@ -168,3 +196,10 @@ void MainClient::showHelp(){
     // Shows an information message box with instructions.
     QMessageBox::information(this, tr("Help"), tr("Use the Containers tab to create Boxes/Cylinders, move to pallets, and Backup/Restore. Use Post XML to send pallets to the server."));
 }
+
+// Shows the live and peak bytes of each subsystem and its allocations per second since the last refresh.
+void MainClient::showMemory(){
+    const Memory::Snapshot now = Memory::snapshot();
+    memoryLabel->setText(Memory::summary(now, shownMemory));
+    shownMemory = now;
+}
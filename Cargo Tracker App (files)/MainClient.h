@@ -2,14 +2,18 @@
 #define MAINCLIENT_H
 
 #include <QMainWindow>
+#include "MemoryAccounting.h"
 // Forward declarations to reduce compile time dependencies.
 // This is a good practice to avoid including full header files when only a pointer or reference is needed.
 class QAction;
+class QLabel;
 class QMenu;
 class QToolBar;
 class QTabWidget;
+class QTreeView;
 class ManageTab;
 class SerializeTab;
+class QueryTab;
 
 // The MainClient class serves as the main application window.
 // It inherits from QMainWindow, which provides a framework for building a standard application UI
@@ -47,6 +51,8 @@ private:
     void wire();
     // This function is for updating the UI state, such as enabling/disabling actions.
     void updateUi();
+    // This function shows the memory accounted per subsystem in the status bar (see MemoryAccounting.h).
+    void showMemory();
 
 private:
     // Pointers to QAction objects. QActions are abstract commands that can be added to menus and toolbars.
@@ -57,9 +63,16 @@ private:
     QToolBar* toolbar{};
     // A pointer to a QTabWidget, a container for organizing multiple pages of widgets.
     QTabWidget* tabs{};
-    // Pointers to the custom tabs for managing and serializing data.
+    // Pointers to the custom tabs for managing, serializing and querying data.
     ManageTab* manage{};
     SerializeTab* serialize{};
+    QueryTab* query{};
+    // The view of the pallets and their containers, over ManageTab's pallet model.
+    QTreeView* palletView{};
+    // The permanent status bar label with the accounted memory, present only when accounting is on.
+    QLabel* memoryLabel{};
+    // The counters shown last, for the allocation rates.
+    Memory::Snapshot shownMemory;
 };
 
 #endif // MAINCLIENT_H
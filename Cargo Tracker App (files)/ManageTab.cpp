@@ -5,32 +5,56 @@
 #include <QPushButton>
 #include <QLabel>
 #include <QListView>
-#include <QStringListModel>
 #include <QMessageBox>
+#include <QFileDialog>
+#include <QProgressDialog>
+#include <QThread>
+#include <QThreadPool>
+#include <QCheckBox>
+#include <QHash>
+#include <QMap>
+#include <QLineEdit>
+#include <QListWidget>
 #include "Box.h"
 #include "Cylinder.h"
 #include "Pallet.h"
 #include "CodeGenerator.h"
 #include "Memento.h"
+#include "UnallocatedListModel.h"
+#include "PalletTreeModel.h"
+#include "ContainerImporter.h"
+#include "PalletAllocator.h"
+#include "PalletLayout.h"
+#include "CodeIndex.h"
 
 // The constructor initializes the class members and sets up the UI and connections.
-ManageTab::ManageTab(QWidget* parent): QWidget(parent), m_codes(new CodeGenerator(this)), m_caretaker(new Caretaker()){
-    // Calls helper functions to build the UI, connect signals, and refresh the model.
+ManageTab::ManageTab(QWidget* parent): QWidget(parent), m_codes(new CodeGenerator(this)), m_caretaker(new Caretaker()), m_index(new CodeIndex()){
+    // Calls helper functions to build the UI and connect signals.
     buildUi();
     wire();
-    refreshUnallocatedModel();
 }
 
 // The destructor ensures proper memory management by deleting dynamically allocated objects.
 ManageTab::~ManageTab(){
+    // Stops a running import; its parser threads check for cancellation often.
+    if(importThread){
+        importer->cancel();
+        importThread->quit();
+        importThread->wait();
+        delete importer;
+        importer = nullptr;
+    }
     // qDeleteAll is a Qt convenience function that deletes all pointers in a container.
-    qDeleteAll(m_unallocated);
-    m_unallocated.clear();
+    qDeleteAll(m_unallocModel->replace({}));
+    // Empties the pallet tree first, so no view reads a pallet being deleted.
+    m_palletModel->clear();
     qDeleteAll(m_pallets);
     m_pallets.clear();
     // Deletes the caretaker object, which is responsible for managing backups.
     delete m_caretaker;
     m_caretaker = nullptr;
+    delete m_index;
+    m_index = nullptr;
 }
 
 // A public method to check if a restore operation is possible.
@@ -77,13 +101,54 @@ void ManageTab::buildUi(){
 
     // Creates UI elements for the unallocated list and pallet management.
     lvUnallocated = new QListView(this);
-    m_unallocModel = new QStringListModel(this);
+    m_unallocModel = new UnallocatedListModel(this);
     lvUnallocated->setModel(m_unallocModel);
+    // Every row is one line of text, so the view need not measure each row to lay out the list.
+    lvUnallocated->setUniformItemSizes(true);
+    m_palletModel = new PalletTreeModel(this);
 
     sbPallet = new QSpinBox(this); sbPallet->setRange(1, 99999);
     btnMove  = new QPushButton(tr("Move to pallet"), this);
     btnBackup= new QPushButton(tr("Backup"), this);
     btnRestore=new QPushButton(tr("Restore"), this); btnRestore->setEnabled(false);
+    btnImport= new QPushButton(tr("Import containers..."), this);
+
+    // Creates a group box for allocating every unallocated container automatically.
+    auto* gbAlloc = new QGroupBox(tr("Automatic allocation"), this);
+    auto* gla = new QGridLayout(gbAlloc);
+    sbMaxWeight = new QSpinBox(gbAlloc); sbMaxWeight->setRange(0, 2000000000); sbMaxWeight->setValue(20000);
+    sbMaxWeight->setSpecialValueText(tr("No limit"));
+    sbMaxVolume = new QSpinBox(gbAlloc); sbMaxVolume->setRange(0, 2000000000);
+    sbMaxVolume->setSpecialValueText(tr("No limit"));
+    cbRefine = new QCheckBox(tr("Try to free the lightest pallets"), gbAlloc); cbRefine->setChecked(true);
+    btnAllocate = new QPushButton(tr("Allocate all"), gbAlloc);
+    gla->addWidget(new QLabel("Pallet max weight"),0,0); gla->addWidget(sbMaxWeight,0,1);
+    gla->addWidget(new QLabel("Pallet max volume"),1,0); gla->addWidget(sbMaxVolume,1,1);
+    gla->addWidget(cbRefine,2,0,1,2);
+    gla->addWidget(btnAllocate,3,0,1,2);
+
+    // Creates a group box for the pallet size, which every move is checked against.
+    auto* gbSize = new QGroupBox(tr("Pallet size"), this);
+    auto* gls = new QGridLayout(gbSize);
+    const LayoutLimits limits;
+    sbPalLen = new QSpinBox(gbSize); sbPalLen->setRange(1,100000); sbPalLen->setValue(limits.length);
+    sbPalBr  = new QSpinBox(gbSize); sbPalBr->setRange(1,100000);  sbPalBr->setValue(limits.breadth);
+    sbPalHt  = new QSpinBox(gbSize); sbPalHt->setRange(1,100000);  sbPalHt->setValue(limits.height);
+    lblLayout = new QLabel(gbSize); lblLayout->setWordWrap(true);
+    gls->addWidget(new QLabel("Length"),0,0);      gls->addWidget(sbPalLen,0,1);
+    gls->addWidget(new QLabel("Breadth"),1,0);     gls->addWidget(sbPalBr,1,1);
+    gls->addWidget(new QLabel("Load height"),2,0); gls->addWidget(sbPalHt,2,1);
+    gls->addWidget(lblLayout,3,0,1,2);
+
+    // Creates a group box for finding containers by code.
+    auto* gbFind = new QGroupBox(tr("Find container"), this);
+    auto* glf = new QGridLayout(gbFind);
+    leFind = new QLineEdit(gbFind); leFind->setPlaceholderText(tr("2026/10/C12, 2026/10/C* or 2026/01..2026/06"));
+    lwFound = new QListWidget(gbFind); lwFound->setUniformItemSizes(true);
+    lblFound = new QLabel(gbFind);
+    glf->addWidget(leFind,0,0);
+    glf->addWidget(lwFound,1,0);
+    glf->addWidget(lblFound,2,0);
 
     // Adds all the group boxes and other widgets to the main layout.
     layout->addWidget(gbBox,0,0);
@@ -91,12 +156,16 @@ void ManageTab::buildUi(){
 
     layout->addWidget(new QLabel(tr("List of unallocated containers")),1,0);
     layout->addWidget(lvUnallocated,2,0,3,1);
+    layout->addWidget(gbFind,5,0,4,1);
 
     layout->addWidget(new QLabel(tr("Choose pallet number and move selected container")),1,1);
     layout->addWidget(sbPallet,2,1);
     layout->addWidget(btnMove,3,1);
     layout->addWidget(btnBackup,4,1);
     layout->addWidget(btnRestore,5,1);
+    layout->addWidget(btnImport,6,1);
+    layout->addWidget(gbAlloc,7,1);
+    layout->addWidget(gbSize,8,1);
 
     // Sets the grid layout as the main layout for the widget.
     setLayout(layout);
@@ -109,17 +178,12 @@ void ManageTab::wire(){
     connect(btnMove,   &QPushButton::clicked, this, &ManageTab::moveSelectedToPallet);
     connect(btnBackup, &QPushButton::clicked, this, &ManageTab::backupUnallocated);
     connect(btnRestore,&QPushButton::clicked, this, &ManageTab::restoreUnallocated);
-}
-
-// This function updates the list view model and the state of the restore button.
-void ManageTab::refreshUnallocatedModel(){
-    QStringList codes;
-    codes.reserve(m_unallocated.size());
-    for(auto* c: m_unallocated) {
-        codes << c->code();
-    }
-    m_unallocModel->setStringList(codes);
-    btnRestore->setEnabled(canRestore());
+    connect(btnImport, &QPushButton::clicked, this, &ManageTab::importContainers);
+    connect(btnAllocate, &QPushButton::clicked, this, &ManageTab::allocateAll);
+    connect(leFind, &QLineEdit::textChanged, this, &ManageTab::findContainers);
+    connect(lwFound, &QListWidget::itemActivated, this, &ManageTab::showFound);
+    // Moves change where a found container is, so the results are listed again.
+    connect(this, &ManageTab::dataChanged, this, &ManageTab::findContainers);
 }
 
 // Ensures that a pallet with the given number exists, creating a new one if necessary.
@@ -132,30 +196,43 @@ void ManageTab::ensurePallet(int number){
     // Creates a new pallet and adds it to the list.
     auto* p = new Pallet(number, this);
     m_pallets.push_back(p);
+    m_palletModel->addPallets({p});
     emit dataChanged();
 }
 
 // Slot to handle the creation of a new Box container.
 void ManageTab::addBox(){
+    const QString code = m_codes->nextCode(ContainerKind::Box);
+    if(code.isEmpty()){
+        QMessageBox::warning(this, tr("Add box"), tr("All container codes of this month are in use."));
+        return;
+    }
     auto* b = new Box(this);
-    b->setCode(m_codes->nextCode(ContainerKind::Box));
+    b->setCode(code);
     b->setBreadth(sbBoxBr->value());
     b->setLength(sbBoxLen->value());
     b->setHeight(sbBoxHt->value());
     b->setWeight(sbBoxWt->value());
-    m_unallocated.push_back(b);
-    refreshUnallocatedModel();
+    m_unallocModel->append(b);
+    m_index->insert(b);
+    findContainers();
 }
 
 // Slot to handle the creation of a new Cylinder container.
 void ManageTab::addCylinder(){
+    const QString code = m_codes->nextCode(ContainerKind::Cylinder);
+    if(code.isEmpty()){
+        QMessageBox::warning(this, tr("Add cylinder"), tr("All container codes of this month are in use."));
+        return;
+    }
     auto* c = new Cylinder(this);
-    c->setCode(m_codes->nextCode(ContainerKind::Cylinder));
+    c->setCode(code);
     c->setDiameter(sbCylDia->value());
     c->setHeight(sbCylHt->value());
     c->setWeight(sbCylWt->value());
-    m_unallocated.push_back(c);
-    refreshUnallocatedModel();
+    m_unallocModel->append(c);
+    m_index->insert(c);
+    findContainers();
 }
 
 // Slot to move a selected container from the unallocated list to a pallet.
@@ -167,7 +244,7 @@ void ManageTab::moveSelectedToPallet(){
     }
     const int row = idx.row();
     // Takes the container from the unallocated list without deleting it.
-    auto* c = m_unallocated.takeAt(row);
+    auto* c = m_unallocModel->take(row);
     c->setParent(nullptr); // Unparents the container before reparenting.
     const int palNum = sbPallet->value();
     ensurePallet(palNum);
@@ -176,33 +253,321 @@ void ManageTab::moveSelectedToPallet(){
             // Reparents the container to the pallet.
             c->setParent(p);
             p->add(c);
+            showLayout(p);
             break;
         }
     }
-    refreshUnallocatedModel();
     emit dataChanged();
 }
 
+namespace {
+
+// This helper describes the containers of a pallet to the layout check.
+QVector<LayoutItem> layoutItems(const Pallet* pallet){
+    QVector<LayoutItem> items;
+    items.reserve(pallet->items().size());
+    for(auto* c: pallet->items()){
+        LayoutItem item;
+        item.height = c->height();
+        item.weight = c->weight();
+        if(auto* b = qobject_cast<Box*>(c)){
+            item.length = b->length();
+            item.breadth = b->breadth();
+        } else if(auto* y = qobject_cast<Cylinder*>(c)){
+            item.length = item.breadth = y->diameter();
+            item.cylinder = true;
+        }
+        items.push_back(item);
+    }
+    return items;
+}
+
+} // namespace
+
+// This helper returns the pallet size entered below the allocation limits.
+LayoutLimits ManageTab::layoutLimits() const{
+    LayoutLimits limits;
+    limits.length = sbPalLen->value();
+    limits.breadth = sbPalBr->value();
+    limits.height = sbPalHt->value();
+    return limits;
+}
+
+// Checks that the containers of a pallet can be stacked on it and shows the outcome below the pallet size.
+void ManageTab::showLayout(const Pallet* pallet){
+    const QVector<LayoutItem> items = layoutItems(pallet);
+    const LayoutLimits limits = layoutLimits();
+    const LayoutResult r = PalletLayout(limits).place(items);
+    if(!r.feasible){
+        lblLayout->setText(tr("Pallet %1 does not fit: %2 of %3 containers cannot be placed.")
+                               .arg(pallet->number()).arg(r.unplaced.size()).arg(items.size()));
+        return;
+    }
+    const double space = 100.0 * r.usedVolume / (double(limits.length) * limits.breadth * limits.height);
+    lblLayout->setText(tr("Pallet %1: %2 containers fit, %3% of the space, %4 high; centre of gravity at (%5, %6, %7).")
+                           .arg(pallet->number()).arg(items.size()).arg(space, 0, 'f', 1).arg(r.loadHeight)
+                           .arg(r.cogX, 0, 'f', 0).arg(r.cogY, 0, 'f', 0).arg(r.cogZ, 0, 'f', 0));
+}
+
 // Slot to back up the current state of unallocated containers using the Memento pattern.
 void ManageTab::backupUnallocated(){
     if(m_caretaker){
-        m_caretaker->save(m_unallocated);
+        m_caretaker->save(m_unallocModel->containers());
     }
-    refreshUnallocatedModel();
+    btnRestore->setEnabled(canRestore());
 }
 
 // Slot to restore the unallocated containers from the last backup.
 void ManageTab::restoreUnallocated(){
     if(!m_caretaker || !m_caretaker->hasBackup())
         return;
-    // Deletes the existing unallocated containers before restoring.
-    qDeleteAll(m_unallocated);
-    m_unallocated.clear();
     // Retrieves the backup from the caretaker.
-    m_unallocated = m_caretaker->restore();
+    const QVector<Container*> restored = m_caretaker->restore();
     // Reparents the restored containers to this tab.
-    for(auto* c: m_unallocated) {
+    for(auto* c: restored) {
         c->setParent(this);
     }
-    refreshUnallocatedModel();
+    // Shows the backup in place of the current list, then deletes the containers it replaced.
+    const QVector<Container*> replaced = m_unallocModel->replace(restored);
+    m_index->remove(replaced);
+    m_index->insert(restored);
+    findContainers();
+    qDeleteAll(replaced);
+    btnRestore->setEnabled(canRestore());
+}
+
+// Slot to import containers from a CSV or XML file. The file is parsed on a worker thread while a
+// progress dialog offers to cancel; finishImport() adds the containers.
+void ManageTab::importContainers(){
+    if(importThread)
+        return;
+    const QString path = QFileDialog::getOpenFileName(this, tr("Import containers"), QString(),
+                                                      tr("Container lists (*.csv *.txt *.xml);;All files (*)"));
+    if(path.isEmpty())
+        return;
+
+    // Accepts the same values as the spin boxes.
+    ImportLimits limits;
+    limits.minDimension = sbBoxLen->minimum();
+    limits.maxDimension = sbBoxLen->maximum();
+    limits.minWeight = sbBoxWt->minimum();
+    limits.maxWeight = sbBoxWt->maximum();
+
+    importThread = new QThread(this);
+    importThread->setObjectName("import");
+    importer = new ContainerImporter(limits);
+    importer->moveToThread(importThread);
+    importProgress = new QProgressDialog(tr("Importing containers..."), tr("Cancel"), 0, 100, this);
+    importProgress->setWindowModality(Qt::WindowModal);
+    importProgress->setMinimumDuration(500);
+    btnImport->setEnabled(false);
+
+    // The worker is the context of the started connection, so run() executes on the import thread.
+    connect(importThread, &QThread::started, importer, [worker = importer, path]{ worker->run(path); });
+    connect(importer, &ContainerImporter::progress, importProgress, &QProgressDialog::setValue);
+    connect(importProgress, &QProgressDialog::canceled, this, [worker = importer]{ worker->cancel(); });
+    connect(importer, &ContainerImporter::finished, this, &ManageTab::finishImport);
+    importThread->start();
+}
+
+// Slot to add the imported containers once the worker is done. Codes are assigned in bulk and the
+// whole batch goes into the list with a single model update. An import that needs more codes than the
+// month has left is refused as a whole, so no container is added without a code of its own.
+void ManageTab::finishImport(){
+    const ImportResult result = importer->takeResult();
+    importThread->quit();
+    importThread->wait();
+    delete importer;
+    importer = nullptr;
+    delete importThread;
+    importThread = nullptr;
+    delete importProgress;
+    importProgress = nullptr;
+    btnImport->setEnabled(true);
+
+    if(result.cancelled)
+        return;
+    if(!result.error.isEmpty()){
+        QMessageBox::warning(this, tr("Import"), result.error);
+        return;
+    }
+
+    const QDate today = QDate::currentDate();
+    const int left = m_codes->remaining(today);
+    if(result.containers.size() > left){
+        QMessageBox::warning(this, tr("Import"), tr("The file holds %1 containers, but only %2 container codes are left this month. "
+                                                    "Nothing was imported.").arg(result.containers.size()).arg(left));
+        return;
+    }
+
+    int boxes = 0;
+    for(const ImportedContainer& ic: result.containers){
+        if(ic.kind == ContainerKind::Box) ++boxes;
+    }
+    const int cylinders = int(result.containers.size()) - boxes;
+    const QStringList boxCodes = m_codes->nextCodes(ContainerKind::Box, boxes, today);
+    const QStringList cylinderCodes = m_codes->nextCodes(ContainerKind::Cylinder, cylinders, today);
+
+    QVector<Container*> batch;
+    batch.reserve(result.containers.size());
+    int nextBox = 0, nextCylinder = 0;
+    for(const ImportedContainer& ic: result.containers){
+        Container* c;
+        if(ic.kind == ContainerKind::Box){
+            auto* b = new Box(this);
+            b->setCode(boxCodes.at(nextBox++));
+            b->setLength(ic.length);
+            b->setBreadth(ic.breadth);
+            c = b;
+        } else {
+            auto* cy = new Cylinder(this);
+            cy->setCode(cylinderCodes.at(nextCylinder++));
+            cy->setDiameter(ic.diameter);
+            c = cy;
+        }
+        c->setHeight(ic.height);
+        c->setWeight(ic.weight);
+        batch.push_back(c);
+    }
+    m_unallocModel->append(batch);
+    m_index->insert(batch);
+    findContainers();
+
+    QString summary = tr("Imported %1 boxes and %2 cylinders.").arg(boxes).arg(cylinders);
+    if(result.rejected > 0){
+        summary += tr("\n%1 entries were skipped:\n").arg(result.rejected) + result.problems.join('\n');
+        if(result.rejected > result.problems.size()) summary += tr("\n...");
+    }
+    QMessageBox::information(this, tr("Import"), summary);
+}
+
+// Slot to put every unallocated container on a pallet within the weight and volume limits. Existing
+// pallets are filled first and new ones are numbered after the highest; the plan is applied as one
+// batch move: the list is updated once and each pallet receives its containers at once.
+void ManageTab::allocateAll(){
+    const QVector<Container*> containers = m_unallocModel->containers();
+    if(containers.isEmpty()){
+        QMessageBox::information(this, tr("Allocate"), tr("There are no unallocated containers."));
+        return;
+    }
+
+    QVector<AllocationItem> items;
+    items.reserve(containers.size());
+    for(auto* c: containers) items.push_back({c->weight(), c->volume()});
+    QVector<AllocationPallet> existing;
+    existing.reserve(m_pallets.size());
+    for(auto* p: m_pallets) existing.push_back({p->number(), p->totalWeight(), p->totalVolume()});
+
+    AllocationOptions options;
+    options.maxWeight = sbMaxWeight->value();
+    options.maxVolume = sbMaxVolume->value();
+    options.refine = cbRefine->isChecked();
+    const AllocationPlan plan = PalletAllocator(options).plan(items, existing);
+
+    QMap<int, QVector<Container*>> batches;
+    QVector<Container*> left;
+    for(int i = 0; i < containers.size(); ++i){
+        if(plan.palletOf.at(i) == 0) left.push_back(containers.at(i));
+        else batches[plan.palletOf.at(i)].push_back(containers.at(i));
+    }
+    m_unallocModel->replace(left);
+    QHash<int, Pallet*> byNumber;
+    for(auto* p: m_pallets) byNumber.insert(p->number(), p);
+    QVector<Pallet*> created;
+    QVector<Pallet*> filled;
+    for(auto it = batches.cbegin(); it != batches.cend(); ++it){
+        Pallet* p = byNumber.value(it.key());
+        if(!p){
+            p = new Pallet(it.key(), this);
+            m_pallets.push_back(p);
+            created.push_back(p);
+        }
+        p->add(it.value());
+        filled.push_back(p);
+    }
+    // The new pallets join the tree already loaded, so their totals are counted once.
+    m_palletModel->addPallets(created);
+    emit dataChanged();
+
+    // Weight and volume limits do not guarantee that a pallet's containers can be stacked, so every
+    // pallet the plan filled gets the same layout check as a manual move. The pallets are independent,
+    // so they are checked on all cores.
+    QVector<QVector<LayoutItem>> loads;
+    loads.reserve(filled.size());
+    for(auto* p: filled) loads.push_back(layoutItems(p));
+    const PalletLayout layout(layoutLimits());
+    QVector<char> fits(loads.size(), 1);
+    {
+        const int workers = qMax(1, QThread::idealThreadCount());
+        QThreadPool pool;
+        for(int w = 0; w < workers; ++w){
+            pool.start([&, w]{
+                for(int i = w; i < loads.size(); i += workers) fits[i] = layout.place(loads.at(i)).feasible;
+            });
+        }
+        pool.waitForDone();
+    }
+    QStringList unstackable;
+    for(int i = 0; i < filled.size(); ++i){
+        if(!fits.at(i)) unstackable.push_back(QString::number(filled.at(i)->number()));
+    }
+
+    QString summary = tr("Placed %1 containers: %2 new pallets, %3 existing pallets topped up (%4, %5 ms).")
+                          .arg(plan.placed).arg(plan.newPallets).arg(plan.existingPallets)
+                          .arg(plan.strategy).arg(plan.elapsedMs);
+    if(options.maxWeight > 0) summary += tr("\nWeight utilisation: %1%").arg(plan.weightUse * 100, 0, 'f', 1);
+    if(options.maxVolume > 0) summary += tr("\nVolume utilisation: %1%").arg(plan.volumeUse * 100, 0, 'f', 1);
+    if(plan.unplaced > 0) summary += tr("\n%1 containers are heavier or larger than a pallet and stay unallocated.").arg(plan.unplaced);
+    if(!unstackable.isEmpty()){
+        const int shown = qMin(int(unstackable.size()), MaxUnstackableListed);
+        summary += tr("\n%1 pallets are within the limits but their containers cannot be stacked within the pallet size: %2%3")
+                       .arg(unstackable.size()).arg(unstackable.mid(0, shown).join(QLatin1String(", ")))
+                       .arg(unstackable.size() > shown ? QStringLiteral(", ...") : QString());
+        QMessageBox::warning(this, tr("Allocate"), summary);
+        return;
+    }
+    QMessageBox::information(this, tr("Allocate"), summary);
+}
+
+// Slot to list the containers whose code matches the search text, with where each one is. It runs on
+// every keystroke and after every change, which the index answers in microseconds.
+void ManageTab::findContainers(){
+    lwFound->clear();
+    m_found.clear();
+    if(leFind->text().trimmed().isEmpty()){
+        lblFound->clear();
+        return;
+    }
+    const CodeIndex::Matches matches = m_index->find(leFind->text(), MaxFound);
+    if(!matches.valid){
+        lblFound->setText(tr("Enter a code, a prefix such as 2026/10/C* or a range such as 2026/01..2026/06."));
+        return;
+    }
+    m_found = matches.containers;
+    for(auto* c: m_found){
+        const auto* p = qobject_cast<const Pallet*>(c->parent());
+        lwFound->addItem(p ? tr("%1  (pallet %2)").arg(c->code()).arg(p->number()) : tr("%1  (unallocated)").arg(c->code()));
+    }
+    if(matches.more) lblFound->setText(tr("The first %1 matches are shown.").arg(MaxFound));
+    else lblFound->setText(tr("%1 matches.").arg(m_found.size()));
+}
+
+// Slot to jump to a found container: a container on a pallet selects that pallet and shows its layout,
+// an unallocated one is selected in the list.
+void ManageTab::showFound(QListWidgetItem* item){
+    const int row = lwFound->row(item);
+    if(row < 0 || row >= m_found.size())
+        return;
+    Container* c = m_found.at(row);
+    if(const auto* p = qobject_cast<const Pallet*>(c->parent())){
+        sbPallet->setValue(p->number());
+        showLayout(p);
+        return;
+    }
+    const int unallocatedRow = int(m_unallocModel->containers().indexOf(c));
+    if(unallocatedRow >= 0){
+        const QModelIndex index = m_unallocModel->index(unallocatedRow);
+        lvUnallocated->setCurrentIndex(index);
+        lvUnallocated->scrollTo(index);
+    }
 }
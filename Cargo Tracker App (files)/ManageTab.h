@@ -5,8 +5,10 @@
 #include <QMap>
 
 // Forward declarations to minimize dependencies and improve compile times.
-class QSpinBox; class QPushButton; class QListView; class QStringListModel; class QGroupBox; class QLabel;
-class Container; class Box; class Cylinder; class Pallet; class CodeGenerator; class Caretaker;
+class QSpinBox; class QPushButton; class QListView; class QGroupBox; class QLabel; class QProgressDialog; class QThread;
+class QCheckBox; class QLineEdit; class QListWidget; class QListWidgetItem;
+class UnallocatedListModel; class PalletTreeModel; class ContainerImporter; class Container; class Box; class Cylinder; class Pallet; class CodeGenerator; class Caretaker; class CodeIndex;
+struct LayoutLimits;
 
 // The UIType enum is used to distinguish between different types of containers in the user interface.
 enum class UIType { Box, Cylinder };
@@ -23,6 +25,8 @@ public:
 
     // Public methods for data exposure to other parts of the application.
     const QVector<Pallet*>& pallets() const { return m_pallets; }
+    // This method returns the tree of pallets and their containers, for a view elsewhere in the window.
+    PalletTreeModel* palletModel() const { return m_palletModel; }
     bool hasAnyPallets() const {
         return !m_pallets.isEmpty();
     }
@@ -42,15 +46,26 @@ private slots:
     void addBox();
     void addCylinder();
     void moveSelectedToPallet();
+    void importContainers();
+    void finishImport();
+    void allocateAll();
+    void findContainers();
+    void showFound(QListWidgetItem* item);
 
 private:
     // Private helper functions for setting up the UI and managing data.
     void buildUi();
     void wire();
-    void refreshUnallocatedModel();
     void ensurePallet(int number);
+    void showLayout(const Pallet* pallet);
+    LayoutLimits layoutLimits() const;
 
 private:
+    // The most search matches listed at once.
+    static constexpr int MaxFound = 200;
+    // The most pallet numbers the allocation summary lists as not stackable.
+    static constexpr int MaxUnstackableListed = 20;
+
     // UI elements for creating and managing containers.
     QSpinBox *sbBoxLen{}, *sbBoxBr{}, *sbBoxHt{}, *sbBoxWt{};
     QPushButton *btnAddBox{};
@@ -59,21 +74,47 @@ private:
 
     // UI elements for the unallocated containers list and controls.
     QListView* lvUnallocated{};
-    QStringListModel* m_unallocModel{};
+    // m_unallocModel stores the containers not yet assigned to a pallet and shows their codes.
+    UnallocatedListModel* m_unallocModel{};
     QSpinBox* sbPallet{};
     QPushButton* btnMove{};
     QPushButton* btnBackup{};
     QPushButton* btnRestore{};
+    QPushButton* btnImport{};
+
+    // UI elements for the automatic allocation of every unallocated container.
+    QSpinBox* sbMaxWeight{};
+    QSpinBox* sbMaxVolume{};
+    QCheckBox* cbRefine{};
+    QPushButton* btnAllocate{};
+
+    // UI elements for the pallet size and the layout check of the last pallet moved to.
+    QSpinBox *sbPalLen{}, *sbPalBr{}, *sbPalHt{};
+    QLabel* lblLayout{};
+
+    // UI elements for finding containers by code.
+    QLineEdit* leFind{};
+    QListWidget* lwFound{};
+    QLabel* lblFound{};
+    QProgressDialog* importProgress{};
+
+    // The thread and worker of a running import; both are null when no import is running.
+    QThread* importThread{};
+    ContainerImporter* importer{};
 
     // Data members that store and manage the application's state.
-    // m_unallocated stores containers not yet assigned to a pallet.
-    QVector<Container*> m_unallocated;
     // m_pallets stores all the pallets.
     QVector<Pallet*> m_pallets;
+    // m_palletModel shows the pallets and their containers.
+    PalletTreeModel* m_palletModel{};
     // m_codes is a utility for generating unique container codes.
     CodeGenerator* m_codes{};
     // m_caretaker is used to manage mementos for the backup and restore functionality.
     Caretaker* m_caretaker{};
+    // m_index finds every container, unallocated or on a pallet, by code.
+    CodeIndex* m_index{};
+    // m_found holds the containers listed in lwFound, row by row.
+    QVector<Container*> m_found;
 };
 
 #endif // MANAGETAB_H
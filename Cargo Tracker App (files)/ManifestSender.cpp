@@ -0,0 +1,299 @@
+#include "ManifestSender.h"
+#include <QCryptographicHash>
+#include <QElapsedTimer>
+#include <QLocalSocket>
+#include <QTcpSocket>
+#include <QThread>
+#include <algorithm>
+#include "SharedRing.h"
+#include "Trace.h"
+
+namespace {
+
+// This helper tells whether a socket of either kind is still connected.
+bool isConnected(QIODevice* sock){
+    if(auto* tcp = qobject_cast<QTcpSocket*>(sock)) return tcp->state() == QAbstractSocket::ConnectedState;
+    if(auto* local = qobject_cast<QLocalSocket*>(sock)) return local->state() == QLocalSocket::ConnectedState;
+    return false;
+}
+
+// This helper closes a socket of either kind, giving the last writes a moment to leave.
+void closeSocket(QIODevice* sock){
+    if(auto* tcp = qobject_cast<QTcpSocket*>(sock)){
+        tcp->disconnectFromHost();
+        if(tcp->state() != QAbstractSocket::UnconnectedState) tcp->waitForDisconnected(1000);
+    } else if(auto* local = qobject_cast<QLocalSocket*>(sock)){
+        local->disconnectFromServer();
+        if(local->state() != QLocalSocket::UnconnectedState) local->waitForDisconnected(1000);
+    }
+}
+
+// This helper derives the upload id from the manifest's contents and the chunk size, so posting the same
+// manifest again in the same chunks continues the server's unfinished upload of it, while a different
+// chunk size never mixes its chunk numbers with those of the stored upload. The id is never 0.
+quint64 uploadId(const QByteArray& manifest, qint64 chunkBytes){
+    char size[8];
+    qToLittleEndian(quint64(chunkBytes), size);
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(QByteArray(size, sizeof size));
+    hash.addData(manifest);
+    return qFromLittleEndian<quint64>(hash.result().constData()) | 1;
+}
+
+} // namespace
+
+// This method sets the chunk size, keeping a chunk and its header within one frame.
+void ManifestSender::setChunkBytes(qint64 bytes){
+    m_chunkBytes = std::clamp<qint64>(bytes, 1024, Wire::MaxPayloadBytes - Wire::ChunkHeaderBytes);
+}
+
+// This function reads CARGO_CHUNK_KB, a size in kilobytes; setChunkBytes() keeps it within bounds.
+qint64 ManifestSender::chunkBytesFromEnvironment(){
+    bool ok = false;
+    const qint64 kb = qEnvironmentVariable("CARGO_CHUNK_KB").toLongLong(&ok);
+    return ok && kb > 0 ? kb * 1024 : Wire::DefaultChunkBytes;
+}
+
+// This method runs rounds until every manifest is acknowledged, permanently rejected or out of attempts.
+QVector<ManifestSender::Outcome> ManifestSender::send(const QVector<QByteArray>& manifests){
+    QVector<Outcome> out(manifests.size());
+    QVector<int> todo(manifests.size());
+    for(int i = 0; i < todo.size(); ++i) todo[i] = i;
+    QHash<int, Upload> uploads;
+
+    for(int attempt = 1; attempt <= m_maxAttempts && !todo.isEmpty(); ++attempt){
+        // Waits a little longer before each retry so a restarting server has time to come back.
+        if(attempt > 1) QThread::msleep(250 * (attempt - 1));
+        sendRound(todo, manifests, out, uploads);
+
+        // Resending is safe: the server keys containers by code, so a manifest applied twice changes nothing.
+        QVector<int> retry;
+        for(int i: todo){
+            if(!out[i].acked && Wire::isRetryable(out[i].reason)) retry.push_back(i);
+        }
+        todo.swap(retry);
+    }
+    return out;
+}
+
+// This private helper function prefers the local socket for this host. Connecting to a local socket
+// nobody listens on fails at once, so trying it first costs nothing when the server is elsewhere.
+// The name is derived from the port, so it reaches the server listening on that port and no other.
+std::unique_ptr<QIODevice> ManifestSender::openConnection(QString* error) const{
+    TRACE_SPAN("connect");
+    if(m_host.isLoopback() && !m_localName.isEmpty()){
+        auto local = std::make_unique<QLocalSocket>();
+        local->connectToServer(m_localName);
+        if(local->waitForConnected(ConnectTimeoutMs)) return local;
+    }
+    auto tcp = std::make_unique<QTcpSocket>();
+    tcp->connectToHost(m_host, m_port);
+    if(tcp->waitForConnected(ConnectTimeoutMs)) return tcp;
+    if(error) *error = tcp->errorString();
+    return nullptr;
+}
+
+// This private helper function pipelines one round of manifests and collects the replies.
+void ManifestSender::sendRound(const QVector<int>& indexes, const QVector<QByteArray>& manifests, QVector<Outcome>& out,
+                               QHash<int, Upload>& uploads){
+    TRACE_SPAN("sendRound");
+    QString connectError;
+    const std::unique_ptr<QIODevice> conn = openConnection(&connectError);
+    if(!conn){
+        for(int i: indexes){
+            out[i].reason = Wire::NackReason::ServerError;
+            out[i].message = QString("Cannot connect to server: %1").arg(connectError);
+        }
+        return;
+    }
+    QIODevice& sock = *conn;
+
+    // Announces framed manifests. Over a local socket, also offers a shared memory ring; small manifests
+    // wait for the server's answer to that before they are written, to the ring or to the socket.
+    sock.write(Wire::ManifestMagic, sizeof Wire::ManifestMagic);
+    SharedRing ring;
+    quint32 ringSeq = 0;
+    enum class RingState{ Off, Offered, On } ringState = RingState::Off;
+    if(qobject_cast<QLocalSocket*>(conn.get()) && ring.create(RingBytes, nullptr)){
+        ringSeq = m_nextSeq++;
+        sock.write(Wire::frame(Wire::Frame::AttachRing, ringSeq, ring.key().toUtf8()));
+        ringState = RingState::Offered;
+    }
+    QVector<quint32> waiting;          // Small manifests not yet written, in order.
+    QHash<quint32, qint64> inRing;     // Where each manifest written to the ring lies.
+    QElapsedTimer clock;
+    clock.start();
+    QHash<quint32, int> inFlight;
+    QHash<quint32, qint64> sentAt;
+    QVector<quint32> chunked;
+    qint64 roundBytes = 0;
+    // Manifests still in flight when the connection fails count as unanswered, which is retryable.
+    auto failInFlight = [&](const QString& message){
+        for(int i: inFlight){
+            out[i].reason = Wire::NackReason::ServerError;
+            out[i].message = message;
+        }
+        inFlight.clear();
+    };
+    for(int i: indexes){
+        const quint32 seq = m_nextSeq++;
+        inFlight.insert(seq, i);
+        sentAt.insert(seq, clock.elapsed());
+        ++out[i].attempts;
+        const QByteArray& manifest = manifests.at(i);
+        roundBytes += manifest.size();
+        if(manifest.size() <= m_chunkBytes){
+            waiting.push_back(seq);
+            continue;
+        }
+        // Large manifests resume from the server's last acknowledged chunk. A first round does not know
+        // it yet; the server's reply to the first chunk tells it.
+        Upload& u = uploads[i];
+        if(u.id == 0){
+            u.id = uploadId(manifest, m_chunkBytes);
+            u.count = quint32((manifest.size() + m_chunkBytes - 1) / m_chunkBytes);
+        }
+        // Every chunk was acknowledged but the verdict got lost; the server has moved on, so start over.
+        if(u.acked >= u.count) u.acked = 0;
+        u.sendPos = u.acked;
+        u.inFlight = 0;
+        u.stale = 0;
+        chunked.push_back(seq);
+    }
+
+    // This lambda tops up every unfinished upload to ChunkWindow chunks in flight.
+    auto writeChunks = [&]{
+        TRACE_SPAN("writeChunks");
+        for(quint32 seq: chunked){
+            if(!inFlight.contains(seq)) continue;
+            const int i = inFlight.value(seq);
+            Upload& u = uploads[i];
+            const QByteArray& manifest = manifests.at(i);
+            for(; u.inFlight < ChunkWindow && u.sendPos < u.count; ++u.sendPos, ++u.inFlight){
+                Wire::ChunkHeader h;
+                h.upload = u.id;
+                h.totalBytes = quint64(manifest.size());
+                h.index = u.sendPos;
+                h.count = u.count;
+                const qint64 from = qint64(u.sendPos) * m_chunkBytes;
+                const qint64 len = std::min<qint64>(m_chunkBytes, manifest.size() - from);
+                sock.write(Wire::frame(Wire::Frame::ManifestChunk, seq,
+                                       Wire::writeChunk(h, manifest.constData() + from, len)));
+            }
+        }
+    };
+
+    // This lambda writes waiting manifests in order: into the ring while it has room, else to the socket.
+    auto writeWaiting = [&]{
+        if(ringState == RingState::Offered) return;
+        TRACE_SPAN("write");
+        int written = 0;
+        for(; written < waiting.size(); ++written){
+            const quint32 seq = waiting.at(written);
+            if(!inFlight.contains(seq)) continue;
+            const QByteArray& manifest = manifests.at(inFlight.value(seq));
+            if(ringState == RingState::On && manifest.size() <= ring.capacity()){
+                const qint64 offset = ring.write(manifest);
+                // A full ring frees up as the server answers; the rest wait until then.
+                if(offset < 0) break;
+                inRing.insert(seq, offset);
+                QByteArray where;
+                Wire::Writer w(where);
+                w.u32(quint32(offset));
+                w.u32(quint32(manifest.size()));
+                sock.write(Wire::frame(Wire::Frame::RingManifest, seq, where));
+            } else {
+                sock.write(Wire::frame(Wire::Frame::Manifest, seq, manifest));
+            }
+        }
+        waiting.remove(0, written);
+    };
+    writeWaiting();
+    writeChunks();
+
+    // The server parses a whole manifest before answering, so large rounds get more time (100 ms per MB).
+    const int replyTimeoutMs = ReplyTimeoutMs + int(std::min<qint64>(roundBytes / 10000, 600000));
+
+    // Replies arrive in the order the server finishes parsing, which need not be the sending order.
+    QByteArray inbox;
+    while(!inFlight.isEmpty()){
+        bool ready = false;
+        {
+            TRACE_SPAN("waitReply");
+            ready = sock.waitForReadyRead(replyTimeoutMs);
+        }
+        if(!ready){
+            failInFlight(isConnected(conn.get()) ? QString("No reply from server") : sock.errorString());
+            break;
+        }
+        inbox.append(sock.readAll());
+
+        Wire::Frame type;
+        quint32 seq = 0;
+        QByteArray payload;
+        Wire::TakeResult result;
+        while((result = Wire::takeFrame(inbox, type, seq, payload)) == Wire::TakeResult::Frame){
+            Wire::Reader in(payload);
+            if(type == Wire::Frame::Nack && seq == 0){
+                // A connection-level rejection (an oversized frame): the server closes the connection.
+                const Wire::NackReason reason = Wire::NackReason(in.u8());
+                for(int i: inFlight){
+                    out[i].reason = reason;
+                    out[i].message = QString::fromUtf8(payload.mid(1));
+                }
+                inFlight.clear();
+                break;
+            }
+            if(seq == ringSeq && ringState == RingState::Offered){
+                // Without the ring, everything goes through the socket as over TCP.
+                ringState = type == Wire::Frame::Ack ? RingState::On : RingState::Off;
+                continue;
+            }
+            const auto it = inFlight.constFind(seq);
+            if(it == inFlight.cend()) continue;
+            if(type == Wire::Frame::ChunkAck){
+                // Chunk acknowledgements come back in the order the chunks were written.
+                Upload& u = uploads[it.value()];
+                const quint32 index = in.u32();
+                const quint32 next = in.u32();
+                --u.inFlight;
+                u.acked = next;
+                if(u.stale > 0){
+                    --u.stale;
+                } else if(next <= index){
+                    // The chunk was refused (damaged, out of order, or the server lost the upload):
+                    // writes again from the chunk the server expects, ignoring replies to the chunks
+                    // already on their way.
+                    u.sendPos = next;
+                    u.stale = u.inFlight;
+                } else if(next > u.sendPos){
+                    // The server already has the chunks up to next from an earlier post of this manifest.
+                    u.sendPos = next;
+                }
+                continue;
+            }
+            // The server has finished reading a manifest once it answers, so its ring space is free again.
+            if(inRing.contains(seq)) ring.release(inRing.take(seq));
+            Outcome& o = out[it.value()];
+            if(type == Wire::Frame::Ack){
+                o.acked = true;
+                o.containers = in.u32();
+                o.latencyMs = clock.elapsed() - sentAt.value(seq);
+                o.message.clear();
+                uploads.remove(it.value());
+            } else {
+                o.reason = Wire::NackReason(in.u8());
+                o.message = QString::fromUtf8(payload.mid(1));
+            }
+            inFlight.erase(it);
+        }
+        if(result == Wire::TakeResult::Malformed){
+            failInFlight("Malformed reply from server");
+            break;
+        }
+        writeWaiting();
+        writeChunks();
+    }
+
+    closeSocket(conn.get());
+}
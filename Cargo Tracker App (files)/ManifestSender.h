@@ -0,0 +1,91 @@
+#ifndef MANIFESTSENDER_H
+#define MANIFESTSENDER_H
+#include <QByteArray>
+#include <QHash>
+#include <QHostAddress>
+#include <QString>
+#include <QVector>
+#include <memory>
+#include "WireProtocol.h"
+
+class QIODevice;
+
+// The ManifestSender class posts XML manifests to the server and waits for the server's verdict on each.
+// All manifests are written on one connection without waiting in between (pipelining), each framed with
+// its own sequence number; the server answers every sequence number with an Ack or a Nack. Manifests
+// that got no answer, or a Nack the server marks as retryable, are sent again on a new connection.
+// Manifests larger than the chunk size are uploaded as numbered, checksummed chunks, at most ChunkWindow
+// of them unacknowledged at a time. Small manifests are written before any chunk, so an interactive post
+// is not stuck behind a bulk upload. An upload's id is derived from the manifest and the chunk size, so
+// when a connection drops, any later post of the same manifest in the same chunks (the next round, or the
+// spool's retry of it) resumes from the last chunk the server acknowledged, for as long as the server
+// keeps the unfinished upload; a different chunk size starts a new upload.
+// When the server is on this host, the sender connects over its local socket instead of TCP and puts
+// manifests into a shared memory ring (see SharedRing), sending only their position; the server parses
+// them where they lie. Without the local socket it falls back to TCP automatically.
+// It blocks, so it is meant for a worker thread such as SerializationWorker's.
+class ManifestSender{
+public:
+    // How often a manifest is offered before giving up, and how long to wait for a connection or reply.
+    static constexpr int MaxAttempts = 3;
+    static constexpr int ConnectTimeoutMs = 2000;
+    static constexpr int ReplyTimeoutMs = 10000;
+    // The most chunks of one upload sent ahead of the server's acknowledgements.
+    static constexpr int ChunkWindow = 4;
+    // The size of the shared memory ring used over a local connection.
+    static constexpr qint64 RingBytes = 16 * 1024 * 1024;
+
+    // The result of posting one manifest.
+    struct Outcome{
+        bool acked{false};                                      // True once the server acknowledged it.
+        Wire::NackReason reason{Wire::NackReason::ServerError}; // Why it failed, when it did.
+        QString message;                                        // The server's or the socket's error text.
+        quint32 containers{0};                                  // The containers the server accepted.
+        qint64 latencyMs{-1};                                   // From writing the manifest to its Ack.
+        int attempts{0};                                        // How many times it was sent.
+    };
+
+    // This is the constructor. It only records where manifests are sent and how often each is offered.
+    ManifestSender(const QHostAddress& host, quint16 port, int maxAttempts = MaxAttempts)
+        : m_host(host), m_port(port), m_maxAttempts(maxAttempts), m_localName(Wire::localName(port)) {}
+
+    // This method sets the chunk size; manifests larger than it are uploaded in chunks. Smaller chunks
+    // lose less on a dropped connection and let other posts through sooner; larger ones cost fewer round trips.
+    void setChunkBytes(qint64 bytes);
+    // This function returns the chunk size set with CARGO_CHUNK_KB, or Wire::DefaultChunkBytes without it.
+    static qint64 chunkBytesFromEnvironment();
+    // This method sets the local socket name tried before TCP when the host is this machine, in place of
+    // the one derived from the port (see Wire::localName); an empty name always uses TCP.
+    void setLocalName(const QString& name){ m_localName = name; }
+
+    // This method posts every manifest and returns one outcome per manifest, in the same order.
+    QVector<Outcome> send(const QVector<QByteArray>& manifests);
+
+private:
+    // The progress of one chunked upload. It outlives a connection so the next round can resume it.
+    struct Upload{
+        quint64 id{0};          // The id the server files the chunks under.
+        quint32 count{0};       // The number of chunks.
+        quint32 acked{0};       // The next chunk the server expects, as last reported.
+        quint32 sendPos{0};     // The next chunk to write on the current connection.
+        int inFlight{0};        // Chunks written but not yet acknowledged.
+        int stale{0};           // Acknowledgements still due for chunks written before a rewind.
+    };
+
+    // This private helper function connects over the local socket if possible, else over TCP. It returns
+    // null and sets error if neither works.
+    std::unique_ptr<QIODevice> openConnection(QString* error) const;
+    // This private helper function sends the given manifests over one connection and records the replies.
+    void sendRound(const QVector<int>& indexes, const QVector<QByteArray>& manifests, QVector<Outcome>& out,
+                   QHash<int, Upload>& uploads);
+
+private:
+    QHostAddress m_host;
+    quint16 m_port;
+    int m_maxAttempts;
+    qint64 m_chunkBytes{Wire::DefaultChunkBytes};
+    QString m_localName;
+    quint32 m_nextSeq{1};   // Sequence numbers are never reused, not even for a retry.
+};
+
+#endif // MANIFESTSENDER_H
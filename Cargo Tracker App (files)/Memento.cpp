@@ -19,8 +19,10 @@ void Caretaker::save(const QVector<Container*>& list){
     m_memento = std::make_unique<UnallocatedListMemento>();
     // Reserves memory in the snapshot vector to prevent reallocations.
     m_memento->snapshot.reserve(list.size());
+    m_memento->storage.set(m_memento->snapshot.capacity() * qint64(sizeof(Container*)));
     // Iterates through the original list and creates a deep copy (clone) of each container.
-    // The clones are then added to the memento's snapshot.
+    // The clones are then added to the memento's snapshot, and counted as snapshot memory.
+    Memory::Scope scope(Memory::Domain::Snapshots);
     for(auto* c: list){
         m_memento->snapshot.push_back(c->clone(nullptr));
     }
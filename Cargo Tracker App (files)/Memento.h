@@ -2,9 +2,15 @@
 #define MEMENTO_H
 #include <QVector>
 #include <memory>
+#include "MemoryAccounting.h"
 class Container;
 
-struct UnallocatedListMemento{ QVector<Container*> snapshot; ~UnallocatedListMemento(); };
+// The snapshot's clones and its list are counted under Memory::Domain::Snapshots.
+struct UnallocatedListMemento{
+    QVector<Container*> snapshot;
+    Memory::Charge storage{Memory::Domain::Snapshots};
+    ~UnallocatedListMemento();
+};
 
 class Caretaker{
 public:
@@ -8,11 +8,21 @@ void Pallet::add(Container* c){
     m_items.push_back(c);
     emit changed();
 }
-int Pallet::totalWeight() const { int t=0;
+void Pallet::add(const QVector<Container*>& batch){
+    if(batch.isEmpty())
+        return;
+    m_items.reserve(m_items.size() + batch.size());
+    for(auto* c: batch){
+        c->setParent(this);
+        m_items.push_back(c);
+    }
+    emit changed();
+}
+qint64 Pallet::totalWeight() const { qint64 t=0;
     for(auto* c: m_items) t+=c->weight();
     return t;
 }
-int Pallet::totalVolume() const { int t=0;
+qint64 Pallet::totalVolume() const { qint64 t=0;
     for(auto* c: m_items) t+=c->volume();
     return t;
 }
@@ -31,11 +31,14 @@ public:
     // This method adds a new container to the pallet. The pallet takes ownership of the container.
     void add(Container* c);
 
+    // This method adds many containers at once and emits 'changed' a single time.
+    void add(const QVector<Container*>& batch);
+
     // This method calculates and returns the total weight of all containers on the pallet.
-    int totalWeight() const;
+    qint64 totalWeight() const;
 
     // This method calculates and returns the total volume of all containers on the pallet.
-    int totalVolume() const;
+    qint64 totalVolume() const;
 
 signals:
     // A signal that is emitted whenever a property of the pallet changes, such as its number or contents.
@@ -0,0 +1,374 @@
+#include "PalletAllocator.h"
+#include <QElapsedTimer>
+#include <QThreadPool>
+#include <algorithm>
+#include <limits>
+#include <set>
+#include <utility>
+#include "Trace.h"
+
+namespace {
+
+// The capacity used for a limit that was left at 0; no sum of int weights or volumes gets near it.
+constexpr qint64 Unlimited = std::numeric_limits<qint64>::max() / 4;
+
+// The shared input of every heuristic. Bins 0..existing-1 are the existing pallets; new pallets follow.
+struct Problem{
+    const QVector<AllocationItem>* items{};
+    QVector<int> order;                 // The items that fit on an empty pallet, largest first.
+    qint64 maxWeight{Unlimited};
+    qint64 maxVolume{Unlimited};
+    QVector<qint64> existingWeight;     // The free weight of each existing pallet.
+    QVector<qint64> existingVolume;
+
+    // This method measures weight and volume as one number, each relative to a pallet's capacity.
+    double size(qint64 weight, qint64 volume) const{
+        return double(weight) / double(maxWeight) + double(volume) / double(maxVolume);
+    }
+    // This method returns the number of existing pallets.
+    int existing() const{ return int(existingWeight.size()); }
+};
+
+// The Packing struct is one heuristic's assignment of items to bins.
+struct Packing{
+    QString strategy;
+    QVector<qint64> freeWeight;         // The room left in each bin.
+    QVector<qint64> freeVolume;
+    QVector<int> binOf;                 // The bin of each item, or -1 if it was not placed.
+    int opened{0};                      // New bins opened, so bins 0..existing+opened-1 are in use.
+
+    // This method puts an item into a bin.
+    void place(const Problem& p, int item, int bin){
+        const AllocationItem& it = p.items->at(item);
+        freeWeight[bin] -= it.weight;
+        freeVolume[bin] -= it.volume;
+        binOf[item] = bin;
+        opened = qMax(opened, bin - p.existing() + 1);
+    }
+};
+
+// This helper prepares a packing with the existing pallets' room and `extra` empty new bins.
+Packing startPacking(const Problem& p, const QString& strategy, int extra){
+    Packing k;
+    k.strategy = strategy;
+    k.freeWeight = p.existingWeight;
+    k.freeVolume = p.existingVolume;
+    k.freeWeight.reserve(p.existing() + extra);
+    k.freeVolume.reserve(p.existing() + extra);
+    for(int i = 0; i < extra; ++i){
+        k.freeWeight.push_back(p.maxWeight);
+        k.freeVolume.push_back(p.maxVolume);
+    }
+    k.binOf.fill(-1, p.items->size());
+    return k;
+}
+
+// The RoomIndex class finds the open bin with the least room that still takes an item. Bins are grouped
+// into Levels by free weight; within a level they are ordered by free volume. Every bin on a higher
+// level than the item's weight has enough weight room, and a tree over the levels' largest free volume
+// finds the lowest such level with enough volume room in O(log Levels). Only the item's own level needs
+// a scan, since it holds bins with a little less as well as a little more weight room than needed.
+class RoomIndex{
+public:
+    // The number of free weight levels.
+    static constexpr int Levels = 1024;
+    // The bins of the item's own level that a search may reject before moving to higher levels.
+    static constexpr int ScanBudget = 64;
+
+    // This is the constructor. The index starts out empty.
+    explicit RoomIndex(const Problem& p): m_problem(p), m_levels(Levels), m_volume(2 * Levels, -1) {}
+
+    // This method adds a bin with its current free room.
+    void insert(const Packing& k, int bin){
+        const int l = level(k.freeWeight.at(bin));
+        m_levels[l].insert({k.freeVolume.at(bin), bin});
+        refresh(l);
+    }
+    // This method removes a bin; its free room must not have changed since it was inserted.
+    void erase(const Packing& k, int bin){
+        const int l = level(k.freeWeight.at(bin));
+        m_levels[l].erase({k.freeVolume.at(bin), bin});
+        refresh(l);
+    }
+    // This method returns the bin with the least weight room, then the least volume room, that takes the
+    // item, or -1 if no bin in the index has room.
+    int bestFit(const Packing& k, const AllocationItem& item) const{
+        const int own = level(item.weight);
+        int budget = ScanBudget;
+        const auto& bins = m_levels.at(own);
+        for(auto it = bins.lower_bound({item.volume, -1}); it != bins.end() && budget-- > 0; ++it){
+            if(k.freeWeight.at(it->second) >= item.weight) return it->second;
+        }
+        const int higher = own + 1 < Levels ? firstLevel(1, 0, Levels - 1, own + 1, item.volume) : -1;
+        return higher < 0 ? -1 : m_levels.at(higher).lower_bound({item.volume, -1})->second;
+    }
+
+private:
+    // This helper maps free weight to a level; more room never gives a lower level.
+    int level(qint64 weight) const{
+        if(weight <= 0) return 0;
+        return int(qMin(double(Levels - 1), double(weight) / double(m_problem.maxWeight) * (Levels - 1)));
+    }
+    // This helper updates the tree after a level changed.
+    void refresh(int l){
+        int n = Levels + l;
+        m_volume[n] = m_levels.at(l).empty() ? -1 : m_levels.at(l).rbegin()->first;
+        for(n /= 2; n >= 1; n /= 2) m_volume[n] = qMax(m_volume.at(2 * n), m_volume.at(2 * n + 1));
+    }
+    // This helper returns the lowest level from `from` on that has a bin with the given volume room.
+    int firstLevel(int n, int lo, int hi, int from, qint64 volume) const{
+        if(hi < from || m_volume.at(n) < volume) return -1;
+        if(lo == hi) return lo;
+        const int mid = (lo + hi) / 2;
+        const int left = firstLevel(2 * n, lo, mid, from, volume);
+        return left >= 0 ? left : firstLevel(2 * n + 1, mid + 1, hi, from, volume);
+    }
+
+    const Problem& m_problem;
+    QVector<std::set<std::pair<qint64, int>>> m_levels;    // (free volume, bin) of the bins on each level.
+    QVector<qint64> m_volume;                              // The tree of each level's largest free volume.
+};
+
+// The FitTree class finds the lowest-numbered bin with room for an item. Each node holds the most free
+// weight and the most free volume among the bins below it, so subtrees without room are skipped.
+// Those two maxima may come from different bins, so a search can still wander into subtrees where no
+// single bin has room; it gives up after SearchBudget nodes.
+class FitTree{
+public:
+    // The nodes a search may visit.
+    static constexpr int SearchBudget = 64;
+
+    // This is the constructor. It builds the tree over the free room of every bin.
+    FitTree(const QVector<qint64>& weight, const QVector<qint64>& volume){
+        while(m_leaves < weight.size()) m_leaves *= 2;
+        m_weight.fill(-1, 2 * m_leaves);
+        m_volume.fill(-1, 2 * m_leaves);
+        for(int i = 0; i < weight.size(); ++i){
+            m_weight[m_leaves + i] = weight.at(i);
+            m_volume[m_leaves + i] = volume.at(i);
+        }
+        for(int n = m_leaves - 1; n >= 1; --n) pull(n);
+    }
+
+    // This method returns the lowest bin with at least the given room, -1 if there is none, or -2 if
+    // the search ran out of budget.
+    int first(qint64 weight, qint64 volume) const{
+        int budget = SearchBudget;
+        return first(1, weight, volume, budget);
+    }
+
+    // This method records a bin's new free room.
+    void update(int bin, qint64 weight, qint64 volume){
+        int n = m_leaves + bin;
+        m_weight[n] = weight;
+        m_volume[n] = volume;
+        for(n /= 2; n >= 1; n /= 2) pull(n);
+    }
+
+private:
+    // This helper recomputes a node from its children.
+    void pull(int n){
+        m_weight[n] = qMax(m_weight.at(2 * n), m_weight.at(2 * n + 1));
+        m_volume[n] = qMax(m_volume.at(2 * n), m_volume.at(2 * n + 1));
+    }
+    // This helper searches a subtree, left first.
+    int first(int n, qint64 weight, qint64 volume, int& budget) const{
+        if(m_weight.at(n) < weight || m_volume.at(n) < volume) return -1;
+        if(n >= m_leaves) return n - m_leaves;
+        if(--budget < 0) return -2;
+        const int left = first(2 * n, weight, volume, budget);
+        return left != -1 ? left : first(2 * n + 1, weight, volume, budget);
+    }
+
+    int m_leaves{1};
+    QVector<qint64> m_weight;
+    QVector<qint64> m_volume;
+};
+
+// This heuristic puts each item on the lowest-numbered bin with room. When that bin is hard to find, the
+// item goes to the best fit among the open bins instead.
+Packing firstFit(const Problem& p){
+    TRACE_SPAN("firstFit");
+    Packing k = startPacking(p, "first fit decreasing", int(p.order.size()));
+    FitTree tree(k.freeWeight, k.freeVolume);
+    RoomIndex room(p);
+    for(int b = 0; b < p.existing(); ++b) room.insert(k, b);
+    for(const int i: p.order){
+        const AllocationItem& item = p.items->at(i);
+        // An unopened bin is empty and every ordered item fits an empty pallet, so a bin is always found.
+        int bin = tree.first(item.weight, item.volume);
+        if(bin == -2){
+            bin = room.bestFit(k, item);
+            if(bin < 0) bin = p.existing() + k.opened;
+        }
+        if(bin < p.existing() + k.opened) room.erase(k, bin);
+        k.place(p, i, bin);
+        room.insert(k, bin);
+        tree.update(bin, k.freeWeight.at(bin), k.freeVolume.at(bin));
+    }
+    return k;
+}
+
+// This heuristic puts each item on the open bin it leaves with the least room, opening a bin if none has room.
+Packing bestFit(const Problem& p){
+    TRACE_SPAN("bestFit");
+    Packing k = startPacking(p, "best fit decreasing", int(p.order.size()));
+    RoomIndex room(p);
+    for(int b = 0; b < p.existing(); ++b) room.insert(k, b);
+    for(const int i: p.order){
+        int bin = room.bestFit(k, p.items->at(i));
+        if(bin >= 0) room.erase(k, bin);
+        else bin = p.existing() + k.opened;
+        k.place(p, i, bin);
+        room.insert(k, bin);
+    }
+    return k;
+}
+
+// This local search takes the new bins from the emptiest up and tries to move all of a bin's items into
+// the other bins (best fit); if they all fit the bin is no longer needed, otherwise the moves are undone.
+void refine(const Problem& p, Packing& k, const QElapsedTimer& clock, int budgetMs){
+    TRACE_SPAN("refine");
+    const int bins = p.existing() + k.opened;
+    QVector<QVector<int>> itemsOf(bins);
+    for(const int i: p.order){
+        if(k.binOf.at(i) >= 0) itemsOf[k.binOf.at(i)].push_back(i);
+    }
+    RoomIndex room(p);
+    QVector<int> candidates;
+    for(int b = 0; b < bins; ++b){
+        room.insert(k, b);
+        if(b >= p.existing()) candidates.push_back(b);
+    }
+    std::sort(candidates.begin(), candidates.end(), [&](int a, int b){
+        return p.size(k.freeWeight.at(a), k.freeVolume.at(a)) > p.size(k.freeWeight.at(b), k.freeVolume.at(b));
+    });
+
+    QVector<QPair<int, int>> moves;     // (item, bin) of the moves made for the current candidate.
+    for(const int b: candidates){
+        if(clock.elapsed() > budgetMs) break;
+        room.erase(k, b);
+        moves.clear();
+        bool emptied = true;
+        for(const int i: itemsOf.at(b)){
+            const AllocationItem& item = p.items->at(i);
+            const int to = room.bestFit(k, item);
+            if(to < 0){
+                emptied = false;
+                break;
+            }
+            room.erase(k, to);
+            k.freeWeight[to] -= item.weight;
+            k.freeVolume[to] -= item.volume;
+            room.insert(k, to);
+            moves.push_back({i, to});
+        }
+        if(!emptied){
+            for(auto m = moves.crbegin(); m != moves.crend(); ++m){
+                const AllocationItem& item = p.items->at(m->first);
+                room.erase(k, m->second);
+                k.freeWeight[m->second] += item.weight;
+                k.freeVolume[m->second] += item.volume;
+                room.insert(k, m->second);
+            }
+            room.insert(k, b);
+            continue;
+        }
+        // The emptied bin stays out of the index, so nothing is moved back into it.
+        for(const auto& m: moves){
+            k.binOf[m.first] = m.second;
+            itemsOf[m.second].push_back(m.first);
+        }
+        itemsOf[b].clear();
+        k.freeWeight[b] = p.maxWeight;
+        k.freeVolume[b] = p.maxVolume;
+    }
+}
+
+// This helper numbers the new bins that hold items after the existing pallets and measures the plan.
+AllocationPlan finish(const Problem& p, const Packing& k, const QVector<AllocationPallet>& existing){
+    AllocationPlan plan;
+    plan.strategy = k.strategy;
+    const int bins = p.existing() + k.opened;
+    QVector<int> count(bins, 0);
+    for(const int bin: k.binOf){
+        if(bin >= 0) ++count[bin];
+    }
+
+    int next = 1;
+    for(const AllocationPallet& e: existing) next = qMax(next, e.number + 1);
+    QVector<int> numberOf(bins, 0);
+    qint64 weight = 0, volume = 0;
+    int loaded = 0;
+    for(int b = 0; b < bins; ++b){
+        const bool isExisting = b < p.existing();
+        if(isExisting) numberOf[b] = existing.at(b).number;
+        else if(count.at(b) > 0) numberOf[b] = next++;
+        if(count.at(b) > 0) (isExisting ? plan.existingPallets : plan.newPallets)++;
+        // Utilisation covers every pallet that carries anything, including loads that were already there.
+        const qint64 w = p.maxWeight - k.freeWeight.at(b), v = p.maxVolume - k.freeVolume.at(b);
+        if(count.at(b) > 0 || (isExisting && (w > 0 || v > 0))){
+            ++loaded;
+            weight += w;
+            volume += v;
+        }
+    }
+
+    plan.palletOf.fill(0, k.binOf.size());
+    for(int i = 0; i < k.binOf.size(); ++i){
+        if(k.binOf.at(i) >= 0){
+            plan.palletOf[i] = numberOf.at(k.binOf.at(i));
+            ++plan.placed;
+        } else {
+            ++plan.unplaced;
+        }
+    }
+    if(loaded > 0 && p.maxWeight != Unlimited) plan.weightUse = double(weight) / (double(p.maxWeight) * loaded);
+    if(loaded > 0 && p.maxVolume != Unlimited) plan.volumeUse = double(volume) / (double(p.maxVolume) * loaded);
+    return plan;
+}
+
+} // namespace
+
+// This method runs both heuristics (and their refinement) in parallel and keeps the better plan.
+AllocationPlan PalletAllocator::plan(const QVector<AllocationItem>& items, const QVector<AllocationPallet>& existing) const{
+    TRACE_SPAN("allocate");
+    QElapsedTimer clock;
+    clock.start();
+
+    Problem p;
+    p.items = &items;
+    if(m_options.maxWeight > 0) p.maxWeight = m_options.maxWeight;
+    if(m_options.maxVolume > 0) p.maxVolume = m_options.maxVolume;
+    for(const AllocationPallet& e: existing){
+        p.existingWeight.push_back(p.maxWeight - e.weight);
+        p.existingVolume.push_back(p.maxVolume - e.volume);
+    }
+    // Items larger than an empty pallet can never be placed and are left out of the order.
+    QVector<double> size(items.size());
+    for(int i = 0; i < items.size(); ++i){
+        const AllocationItem& item = items.at(i);
+        if(item.weight > p.maxWeight || item.volume > p.maxVolume) continue;
+        size[i] = p.size(item.weight, item.volume);
+        p.order.push_back(i);
+    }
+    std::stable_sort(p.order.begin(), p.order.end(), [&](int a, int b){ return size.at(a) > size.at(b); });
+
+    Packing first, best;
+    QThreadPool pool;
+    pool.start([&]{
+        first = firstFit(p);
+        if(m_options.refine) refine(p, first, clock, m_options.refineBudgetMs);
+    });
+    pool.start([&]{
+        best = bestFit(p);
+        if(m_options.refine) refine(p, best, clock, m_options.refineBudgetMs);
+    });
+    pool.waitForDone();
+
+    const AllocationPlan a = finish(p, first, existing);
+    const AllocationPlan b = finish(p, best, existing);
+    AllocationPlan plan = b.newPallets < a.newPallets ? b : a;
+    plan.elapsedMs = clock.elapsed();
+    return plan;
+}
@@ -0,0 +1,63 @@
+#ifndef PALLETALLOCATOR_H
+#define PALLETALLOCATOR_H
+
+#include <QString>
+#include <QVector>
+
+// The AllocationItem struct is what the allocator needs to know about a container.
+struct AllocationItem{
+    qint64 weight{0};
+    qint64 volume{0};
+};
+
+// The AllocationPallet struct is an existing pallet with the load it already carries.
+struct AllocationPallet{
+    int number{0};
+    qint64 weight{0};
+    qint64 volume{0};
+};
+
+// The AllocationOptions struct holds the limits of one pallet and how hard to try.
+struct AllocationOptions{
+    qint64 maxWeight{0};        // The most weight a pallet may carry; 0 means no limit.
+    qint64 maxVolume{0};        // The most volume a pallet may carry; 0 means no limit.
+    bool refine{true};          // Whether to try to empty the lightest new pallets into the others.
+    int refineBudgetMs{300};    // The time the refinement may take.
+};
+
+// The AllocationPlan struct is the outcome: where each container goes and how full the pallets are.
+struct AllocationPlan{
+    QVector<int> palletOf;      // The pallet number of each item, or 0 if it fits on no pallet.
+    QString strategy;           // The heuristic that produced the plan.
+    int placed{0};
+    int unplaced{0};            // Items that are heavier or larger than an empty pallet.
+    int newPallets{0};          // Pallets opened for the plan, numbered after the highest existing one.
+    int existingPallets{0};     // Existing pallets that received containers.
+    double weightUse{0};        // Load over capacity of every pallet holding containers, 0-1 (0 without a limit).
+    double volumeUse{0};
+    qint64 elapsedMs{0};
+};
+
+// The PalletAllocator class assigns unallocated containers to pallets so that no pallet exceeds its
+// weight and volume limits and as few pallets as possible are used. It is a two-dimensional bin packing
+// problem, solved with two heuristics over the items sorted by decreasing size:
+// - first fit decreasing puts each item on the lowest-numbered pallet with room, found with a tree of
+//   the largest free weight and volume below each node;
+// - best fit decreasing puts each item on the pallet with the least weight room, then the least volume
+//   room, that takes it, found in O(log n) with pallets grouped by free weight and ordered by free volume.
+// Both run in parallel, each followed by a refinement that tries to empty the lightest new pallets into
+// the others, and the plan with the fewest pallets wins. Existing pallets are filled before new ones are
+// opened. 100000 containers take well under a second.
+class PalletAllocator{
+public:
+    // This is the constructor. It stores the limits.
+    explicit PalletAllocator(const AllocationOptions& options): m_options(options) {}
+
+    // This method plans the allocation of the items onto the existing pallets and new ones.
+    AllocationPlan plan(const QVector<AllocationItem>& items, const QVector<AllocationPallet>& existing) const;
+
+private:
+    AllocationOptions m_options;
+};
+
+#endif // PALLETALLOCATOR_H
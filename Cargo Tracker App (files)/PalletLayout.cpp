@@ -0,0 +1,200 @@
+#include "PalletLayout.h"
+#include <algorithm>
+#include <numeric>
+#include <tuple>
+#include "Trace.h"
+
+namespace {
+
+// The Point struct is a candidate corner for the next container.
+struct Point{
+    int x{0}, y{0}, z{0};
+
+    // Points are tried lowest first, then rearmost, then leftmost.
+    bool operator<(const Point& o) const{ return std::tie(z, y, x) < std::tie(o.z, o.y, o.x); }
+    bool operator==(const Point& o) const{ return x == o.x && y == o.y && z == o.z; }
+};
+
+// The Grid class divides the footprint into Cells x Cells cells and lists the placed boxes over each, so
+// overlap and support checks only look at boxes near the one being placed.
+class Grid{
+public:
+    // The number of cells along each side of the footprint.
+    static constexpr int Cells = 16;
+
+    // This is the constructor. The grid refers to the boxes and starts out empty.
+    Grid(const LayoutLimits& limits, const QVector<LayoutBox>& boxes):
+        m_boxes(boxes),
+        m_cellLength(qMax(1, (limits.length + Cells - 1) / Cells)),
+        m_cellBreadth(qMax(1, (limits.breadth + Cells - 1) / Cells)),
+        m_cells(Cells * Cells) {}
+
+    // This method files a placed box under every cell it covers.
+    void add(int index){
+        const LayoutBox& b = m_boxes.at(index);
+        forCells(b.x, b.y, b.x + b.length, b.y + b.breadth, [&](int cell){ m_cells[cell].push_back(index); });
+        m_seen.push_back(0);
+    }
+
+    // This method tells whether a box would overlap a placed one.
+    bool collides(const LayoutBox& c) const{
+        return forBoxes(c.x, c.y, c.x + c.length, c.y + c.breadth, [&](const LayoutBox& b){
+            return c.z < b.z + b.height && b.z < c.z + c.height;
+        });
+    }
+
+    // This method returns how much of a box's base rests on the tops of placed boxes.
+    qint64 supportedArea(const LayoutBox& c) const{
+        qint64 area = 0;
+        forBoxes(c.x, c.y, c.x + c.length, c.y + c.breadth, [&](const LayoutBox& b){
+            if(b.z + b.height == c.z){
+                const qint64 l = qMin(c.x + c.length, b.x + b.length) - qMax(c.x, b.x);
+                const qint64 w = qMin(c.y + c.breadth, b.y + b.breadth) - qMax(c.y, b.y);
+                area += l * w;
+            }
+            return false;
+        });
+        return area;
+    }
+
+    // This method returns the height of the highest top at or below z over the point (x, y), or 0.
+    int surfaceBelow(int x, int y, int z) const{
+        int top = 0;
+        forBoxes(x, y, x + 1, y + 1, [&](const LayoutBox& b){
+            if(b.z + b.height <= z) top = qMax(top, b.z + b.height);
+            return false;
+        });
+        return top;
+    }
+
+private:
+    // This helper calls f with every cell under the rectangle [x0, x1) x [y0, y1).
+    template<typename F>
+    void forCells(int x0, int y0, int x1, int y1, F f) const{
+        const int cx0 = qMin(Cells - 1, x0 / m_cellLength), cx1 = qMin(Cells - 1, (x1 - 1) / m_cellLength);
+        const int cy0 = qMin(Cells - 1, y0 / m_cellBreadth), cy1 = qMin(Cells - 1, (y1 - 1) / m_cellBreadth);
+        for(int cy = cy0; cy <= cy1; ++cy){
+            for(int cx = cx0; cx <= cx1; ++cx) f(cy * Cells + cx);
+        }
+    }
+    // This helper calls f once with every placed box whose footprint overlaps the rectangle, until f
+    // returns true; it returns whether one did.
+    template<typename F>
+    bool forBoxes(int x0, int y0, int x1, int y1, F f) const{
+        ++m_query;
+        bool stop = false;
+        forCells(x0, y0, x1, y1, [&](int cell){
+            for(const int index: m_cells.at(cell)){
+                if(stop) return;
+                if(m_seen.at(index) == m_query) continue;
+                m_seen[index] = m_query;
+                const LayoutBox& b = m_boxes.at(index);
+                if(b.x < x1 && x0 < b.x + b.length && b.y < y1 && y0 < b.y + b.breadth) stop = f(b);
+            }
+        });
+        return stop;
+    }
+
+    const QVector<LayoutBox>& m_boxes;
+    int m_cellLength;
+    int m_cellBreadth;
+    QVector<QVector<int>> m_cells;
+    mutable QVector<int> m_seen;    // The last query that visited each box, so a box spanning cells counts once.
+    mutable int m_query{0};
+};
+
+} // namespace
+
+// This method places the items one by one at the first candidate corner that takes them.
+LayoutResult PalletLayout::place(const QVector<LayoutItem>& items) const{
+    TRACE_SPAN("layout");
+    LayoutResult r;
+    QVector<int> order(items.size());
+    std::iota(order.begin(), order.end(), 0);
+    // Large footprints go first so they end up at the bottom, where they carry the smaller ones.
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b){
+        const LayoutItem& x = items.at(a);
+        const LayoutItem& y = items.at(b);
+        const qint64 ax = qint64(x.length) * x.breadth, ay = qint64(y.length) * y.breadth;
+        return ax != ay ? ax > ay : x.height > y.height;
+    });
+
+    Grid grid(m_limits, r.boxes);
+    QVector<Point> points{Point()};
+    QVector<LayoutItem> failed;     // Items that found no place since the last one that did.
+    for(const int i: order){
+        const LayoutItem& item = items.at(i);
+        const int turns = item.cylinder || item.length == item.breadth ? 1 : 2;
+        // An item at least as large as one that just failed cannot fit either, so it is not tried.
+        const bool larger = std::any_of(failed.cbegin(), failed.cend(), [&](const LayoutItem& f){
+            return item.height >= f.height && qMin(item.length, item.breadth) >= qMin(f.length, f.breadth)
+                   && qMax(item.length, item.breadth) >= qMax(f.length, f.breadth);
+        });
+        bool placed = false;
+        for(const Point& p: points){
+            if(larger) break;
+            for(int t = 0; t < turns && !placed; ++t){
+                LayoutBox b;
+                b.item = i;
+                b.x = p.x; b.y = p.y; b.z = p.z;
+                b.length = t ? item.breadth : item.length;
+                b.breadth = t ? item.length : item.breadth;
+                b.height = item.height;
+                if(b.x + b.length > m_limits.length || b.y + b.breadth > m_limits.breadth || b.z + b.height > m_limits.height) continue;
+                if(grid.collides(b)) continue;
+                if(b.z > 0 && grid.supportedArea(b) < qint64(b.length) * b.breadth) continue;
+                r.boxes.push_back(b);
+                grid.add(int(r.boxes.size()) - 1);
+                placed = true;
+            }
+            if(placed) break;
+        }
+        if(!placed){
+            r.feasible = false;
+            r.unplaced.push_back(i);
+            failed.push_back(item);
+            continue;
+        }
+        failed.clear();
+
+        // Drops the candidates the new box covers and adds its outer corners, and where those would fall.
+        const LayoutBox& b = r.boxes.constLast();
+        points.erase(std::remove_if(points.begin(), points.end(), [&](const Point& p){
+            return p.x >= b.x && p.x < b.x + b.length && p.y >= b.y && p.y < b.y + b.breadth
+                   && p.z >= b.z && p.z < b.z + b.height;
+        }), points.end());
+        const Point corners[] = {{b.x + b.length, b.y, b.z}, {b.x, b.y + b.breadth, b.z}, {b.x, b.y, b.z + b.height}};
+        for(const Point& c: corners){
+            if(c.x >= m_limits.length || c.y >= m_limits.breadth || c.z >= m_limits.height) continue;
+            points.push_back(c);
+            if(c.z > 0 && c.z == b.z) points.push_back({c.x, c.y, grid.surfaceBelow(c.x, c.y, c.z)});
+        }
+        std::sort(points.begin(), points.end());
+        points.erase(std::unique(points.begin(), points.end()), points.end());
+    }
+
+    // The centre of gravity weighs each container's centre by its weight (all alike if nothing weighs).
+    double weight = 0;
+    for(const LayoutBox& b: r.boxes){
+        const double w = qMax(0, items.at(b.item).weight);
+        weight += w;
+        r.cogX += w * (b.x + b.length / 2.0);
+        r.cogY += w * (b.y + b.breadth / 2.0);
+        r.cogZ += w * (b.z + b.height / 2.0);
+        r.usedVolume += qint64(b.length) * b.breadth * b.height;
+        r.loadHeight = qMax(r.loadHeight, b.z + b.height);
+    }
+    if(weight > 0){
+        r.cogX /= weight;
+        r.cogY /= weight;
+        r.cogZ /= weight;
+    } else if(!r.boxes.isEmpty()){
+        r.cogX = r.cogY = r.cogZ = 0;
+        for(const LayoutBox& b: r.boxes){
+            r.cogX += (b.x + b.length / 2.0) / r.boxes.size();
+            r.cogY += (b.y + b.breadth / 2.0) / r.boxes.size();
+            r.cogZ += (b.z + b.height / 2.0) / r.boxes.size();
+        }
+    }
+    return r;
+}
@@ -0,0 +1,190 @@
+#include "PalletTreeModel.h"
+#include "Container.h"
+#include "Pallet.h"
+
+// This function creates an index for a pallet row (internal id 0) or a container row (pallet row + 1).
+QModelIndex PalletTreeModel::index(int row, int column, const QModelIndex& parent) const{
+    if(!hasIndex(row, column, parent))
+        return {};
+    if(!parent.isValid())
+        return createIndex(row, column, quintptr(0));
+    return createIndex(row, column, quintptr(parent.row()) + 1);
+}
+
+// This function returns the pallet row of a container row, and nothing for a pallet row.
+QModelIndex PalletTreeModel::parent(const QModelIndex& child) const{
+    if(!child.isValid() || child.internalId() == 0)
+        return {};
+    return createIndex(int(child.internalId() - 1), 0, quintptr(0));
+}
+
+// This function returns the rows handed to the view so far, which may be fewer than there are.
+int PalletTreeModel::rowCount(const QModelIndex& parent) const{
+    if(!parent.isValid())
+        return m_shown;
+    if(parent.internalId() != 0 || parent.column() != 0)
+        return 0;
+    return m_nodes.at(parent.row()).shown;
+}
+
+// This function returns the number of columns.
+int PalletTreeModel::columnCount(const QModelIndex&) const{
+    return ColumnCount;
+}
+
+// This function tells the view which pallets can be expanded before any of their rows are fetched.
+bool PalletTreeModel::hasChildren(const QModelIndex& parent) const{
+    if(!parent.isValid())
+        return !m_nodes.isEmpty();
+    if(parent.internalId() != 0 || parent.column() != 0)
+        return false;
+    return m_nodes.at(parent.row()).counted > 0;
+}
+
+// This function shows a pallet's cached totals, or reads a container's values when its row is painted.
+QVariant PalletTreeModel::data(const QModelIndex& index, int role) const{
+    if(!index.isValid())
+        return {};
+    if(role == Qt::TextAlignmentRole)
+        return index.column() == NameColumn ? QVariant() : QVariant(int(Qt::AlignRight | Qt::AlignVCenter));
+    if(role != Qt::DisplayRole)
+        return {};
+
+    if(index.internalId() == 0){
+        const Node& node = m_nodes.at(index.row());
+        switch(index.column()){
+        case NameColumn: return tr("Pallet %1").arg(node.pallet->number());
+        case CountColumn: return node.counted;
+        case WeightColumn: return node.weight;
+        case VolumeColumn: return node.volume;
+        }
+        return {};
+    }
+    const Node& node = m_nodes.at(int(index.internalId() - 1));
+    const Container* c = node.pallet->items().at(index.row());
+    switch(index.column()){
+    case NameColumn: return c->code();
+    case CountColumn: return c->typeName();
+    case WeightColumn: return c->weight();
+    case VolumeColumn: return c->volume();
+    }
+    return {};
+}
+
+// This function names the columns, each of which means one thing for pallets and another for containers.
+QVariant PalletTreeModel::headerData(int section, Qt::Orientation orientation, int role) const{
+    if(orientation != Qt::Horizontal || role != Qt::DisplayRole)
+        return {};
+    switch(section){
+    case NameColumn: return tr("Pallet / code");
+    case CountColumn: return tr("Containers / type");
+    case WeightColumn: return tr("Weight");
+    case VolumeColumn: return tr("Volume");
+    }
+    return {};
+}
+
+// This function tells whether pallets, or containers of a pallet, are left to hand to the view.
+bool PalletTreeModel::canFetchMore(const QModelIndex& parent) const{
+    if(!parent.isValid())
+        return m_shown < m_nodes.size();
+    if(parent.internalId() != 0 || parent.column() != 0)
+        return false;
+    const Node& node = m_nodes.at(parent.row());
+    return node.shown < node.counted;
+}
+
+// This function hands the next batch of pallets, or of a pallet's containers, to the view.
+void PalletTreeModel::fetchMore(const QModelIndex& parent){
+    if(!canFetchMore(parent))
+        return;
+    if(!parent.isValid()){
+        const int n = qMin(FetchBatch, int(m_nodes.size()) - m_shown);
+        beginInsertRows(QModelIndex(), m_shown, m_shown + n - 1);
+        m_shown += n;
+        endInsertRows();
+        return;
+    }
+    Node& node = m_nodes[parent.row()];
+    const int n = qMin(FetchBatch, node.counted - node.shown);
+    beginInsertRows(parent, node.shown, node.shown + n - 1);
+    node.shown += n;
+    endInsertRows();
+}
+
+// This method appends the pallets. If the view had every pallet, the first batch of new ones is shown
+// at once; otherwise they wait for fetchMore() like the rest.
+void PalletTreeModel::addPallets(const QVector<Pallet*>& pallets){
+    if(pallets.isEmpty())
+        return;
+    const bool allShown = m_shown == m_nodes.size();
+    m_nodes.reserve(m_nodes.size() + pallets.size());
+    for(auto* p: pallets){
+        m_rows.insert(p, int(m_nodes.size()));
+        Node node;
+        node.pallet = p;
+        count(node, 0);
+        m_nodes.push_back(node);
+        connect(p, &Pallet::changed, this, [this, p]{ palletChanged(p); });
+    }
+    if(allShown){
+        const int n = qMin(FetchBatch, int(m_nodes.size()) - m_shown);
+        beginInsertRows(QModelIndex(), m_shown, m_shown + n - 1);
+        m_shown += n;
+        endInsertRows();
+    }
+}
+
+// This method resets the model and disconnects from the pallets.
+void PalletTreeModel::clear(){
+    beginResetModel();
+    for(const Node& node: m_nodes) disconnect(node.pallet, nullptr, this, nullptr);
+    m_nodes.clear();
+    m_rows.clear();
+    m_shown = 0;
+    endResetModel();
+}
+
+// This helper adds the weight and volume of the containers from position from on.
+void PalletTreeModel::count(Node& node, int from){
+    const QVector<Container*>& items = node.pallet->items();
+    for(int i = from; i < items.size(); ++i){
+        node.weight += items.at(i)->weight();
+        node.volume += items.at(i)->volume();
+    }
+    node.counted = int(items.size());
+}
+
+// This helper brings a pallet's totals up to date. Pallets only ever gain containers at the end, so only
+// the new ones are added; should a pallet ever shrink, its totals are counted again and its rows dropped.
+// New containers of a pallet whose rows were all shown (or that was empty, so the view learns it can now
+// be expanded) are shown at once, up to a batch.
+void PalletTreeModel::palletChanged(Pallet* pallet){
+    const int row = m_rows.value(pallet, -1);
+    if(row < 0)
+        return;
+    Node& node = m_nodes[row];
+    const int before = node.counted;
+    const QModelIndex parent = row < m_shown ? index(row, 0) : QModelIndex();
+    if(pallet->items().size() < before){
+        if(node.shown > 0 && parent.isValid()){
+            beginRemoveRows(parent, 0, node.shown - 1);
+            node.shown = 0;
+            endRemoveRows();
+        }
+        node.shown = 0;
+        node.weight = node.volume = 0;
+        count(node, 0);
+    } else {
+        count(node, before);
+    }
+    if(!parent.isValid())
+        return;
+    emit dataChanged(parent, index(row, ColumnCount - 1));
+    if(node.shown == before && node.counted > before){
+        const int n = qMin(FetchBatch, node.counted - node.shown);
+        beginInsertRows(parent, node.shown, node.shown + n - 1);
+        node.shown += n;
+        endInsertRows();
+    }
+}
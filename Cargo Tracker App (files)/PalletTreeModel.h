@@ -0,0 +1,65 @@
+#ifndef PALLETTREEMODEL_H
+#define PALLETTREEMODEL_H
+#include <QAbstractItemModel>
+#include <QHash>
+#include <QVector>
+class Pallet;
+
+// The PalletTreeModel class shows the pallets with their containers beneath them. It is built for tens of
+// thousands of pallets and millions of containers:
+// - rows are handed to the view in batches through canFetchMore()/fetchMore(), both the pallets and the
+//   containers of a pallet, so expanding a pallet of 100000 containers creates a thousand rows, not all;
+// - a container row is read from the container only when the view paints it;
+// - each pallet's count, weight and volume are cached and updated from Pallet::changed by adding up
+//   only the containers added since the last update, so the totals cost O(1) per container overall.
+// Indexes need no allocation: a pallet row has internal id 0 and a container row the row of its pallet
+// plus 1. The model does not own the pallets; ManageTab does, and calls clear() before deleting them.
+class PalletTreeModel : public QAbstractItemModel{
+    Q_OBJECT
+public:
+    // The columns. For a pallet they show its totals, for a container its own values.
+    enum Column{ NameColumn, CountColumn, WeightColumn, VolumeColumn, ColumnCount };
+    // The number of rows a fetchMore() call adds.
+    static constexpr int FetchBatch = 1000;
+
+    // This is the constructor. It initializes an empty tree.
+    explicit PalletTreeModel(QObject* parent=nullptr): QAbstractItemModel(parent) {}
+
+    // These override functions describe the tree to the view.
+    QModelIndex index(int row, int column, const QModelIndex& parent=QModelIndex()) const override;
+    QModelIndex parent(const QModelIndex& child) const override;
+    int rowCount(const QModelIndex& parent=QModelIndex()) const override;
+    int columnCount(const QModelIndex& parent=QModelIndex()) const override;
+    bool hasChildren(const QModelIndex& parent=QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role) const override;
+    // These override functions hand the pallets and their containers to the view batch by batch.
+    bool canFetchMore(const QModelIndex& parent) const override;
+    void fetchMore(const QModelIndex& parent) override;
+
+    // This method adds pallets at the end of the tree and follows their changes.
+    void addPallets(const QVector<Pallet*>& pallets);
+    // This method empties the tree and stops following the pallets.
+    void clear();
+
+private:
+    // The Node struct is what the model keeps per pallet.
+    struct Node{
+        Pallet* pallet{nullptr};
+        int shown{0};           // Containers handed to the view.
+        int counted{0};         // Containers included in the totals.
+        qint64 weight{0};
+        qint64 volume{0};
+    };
+
+    // This helper adds the containers from the given position on to a node's totals.
+    static void count(Node& node, int from);
+    // This helper updates a pallet's totals and rows after Pallet::changed.
+    void palletChanged(Pallet* pallet);
+
+    QVector<Node> m_nodes;
+    int m_shown{0};                     // Pallets handed to the view.
+    QHash<const Pallet*, int> m_rows;   // The row of each pallet.
+};
+
+#endif // PALLETTREEMODEL_H
@@ -0,0 +1,181 @@
+#include "PostSpool.h"
+#include <QDir>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QtEndian>
+#include <algorithm>
+#include <utility>
+#include "Crc32.h"
+#ifdef Q_OS_WIN
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+
+// On-disk layout. All integers are little-endian.
+// Record:  magic "CTS1" | length of the compressed manifest | CRC-32 of it | qCompress'd manifest
+// Cursor:  one line of text, "<segment> <offset>".
+constexpr char RecordMagic[4] = {'C', 'T', 'S', '1'};
+constexpr int RecordHeaderBytes = 12;
+
+// This function reads the record starting at offset. It returns the offset just after it, or -1 if
+// there is no complete, intact record there (the end of the segment, or a write torn by a crash).
+qint64 readRecord(QFile& f, qint64 offset, QByteArray* payload){
+    if(!f.seek(offset)) return -1;
+    const QByteArray header = f.read(RecordHeaderBytes);
+    if(header.size() != RecordHeaderBytes || !header.startsWith(QByteArray(RecordMagic, 4))) return -1;
+    const quint32 length = qFromLittleEndian<quint32>(header.constData() + 4);
+    const quint32 crc = qFromLittleEndian<quint32>(header.constData() + 8);
+    if(length > quint32(f.size() - offset - RecordHeaderBytes)) return -1;
+    QByteArray body = f.read(length);
+    if(body.size() != qsizetype(length) || Crc32::of(body.constData(), body.size()) != crc) return -1;
+    if(payload) *payload = std::move(body);
+    return offset + RecordHeaderBytes + length;
+}
+
+// This function forces written data onto the disk. QFile::flush() only empties Qt's own buffer.
+bool syncFile(QFile& f){
+    if(!f.flush()) return false;
+#ifdef Q_OS_WIN
+    return _commit(f.handle()) == 0;
+#else
+    return ::fsync(f.handle()) == 0;
+#endif
+}
+
+} // namespace
+
+// The constructor finds the segments, drops any already delivered, and counts what is left.
+PostSpool::PostSpool(const QString& directory): m_directory(directory){
+    QDir().mkpath(m_directory);
+
+    QFile cursor(m_directory + "/cursor");
+    if(cursor.open(QIODevice::ReadOnly)){
+        const QList<QByteArray> parts = cursor.readAll().simplified().split(' ');
+        if(parts.size() == 2){
+            m_head.segment = std::max(1u, parts.at(0).toUInt());
+            m_head.offset = std::max<qint64>(0, parts.at(1).toLongLong());
+        }
+    }
+
+    QVector<quint32> segments;
+    for(const QString& name: QDir(m_directory).entryList({"spool-*.seg"}, QDir::Files)){
+        bool ok = false;
+        const quint32 segment = name.mid(6, name.size() - 10).toUInt(&ok);
+        if(!ok) continue;
+        // Segments before the cursor were delivered; the crash came before they were deleted.
+        if(segment < m_head.segment) QFile::remove(segmentPath(segment));
+        else segments.push_back(segment);
+    }
+    std::sort(segments.begin(), segments.end());
+    if(segments.isEmpty() || segments.first() != m_head.segment){
+        m_head = {segments.isEmpty() ? m_head.segment : segments.first(), 0};
+    }
+    m_tailSegment = segments.isEmpty() ? m_head.segment : segments.last();
+
+    for(quint32 segment: segments){
+        QFile f(segmentPath(segment));
+        if(!f.open(QIODevice::ReadWrite)) continue;
+        qint64 offset = segment == m_head.segment ? m_head.offset : 0;
+        for(qint64 next; (next = readRecord(f, offset, nullptr)) >= 0; offset = next) ++m_pending;
+        // Only the newest segment can end in a torn record; cutting it off keeps appends readable.
+        if(segment == m_tailSegment && offset < f.size()) f.resize(offset);
+    }
+}
+
+// This private helper function returns the path of a segment file.
+QString PostSpool::segmentPath(quint32 segment) const{
+    return QString("%1/spool-%2.seg").arg(m_directory).arg(segment, 8, 10, QLatin1Char('0'));
+}
+
+// This private helper function writes the cursor file. QSaveFile renames a complete new file over the
+// old one, so a crash leaves either the old or the new cursor, never a mix.
+void PostSpool::saveCursor(){
+    QSaveFile f(m_directory + "/cursor");
+    if(!f.open(QIODevice::WriteOnly)) return;
+    f.write(QString("%1 %2\n").arg(m_head.segment).arg(m_head.offset).toLatin1());
+    f.commit();
+}
+
+// This method writes all the records with one write and one sync, and removes them again on failure.
+bool PostSpool::append(const QVector<QByteArray>& manifests, QString* error){
+    QByteArray records;
+    for(const QByteArray& manifest: manifests){
+        const QByteArray payload = qCompress(manifest);
+        char header[RecordHeaderBytes];
+        std::copy(RecordMagic, RecordMagic + 4, header);
+        qToLittleEndian(quint32(payload.size()), header + 4);
+        qToLittleEndian(Crc32::of(payload.constData(), payload.size()), header + 8);
+        records.append(header, RecordHeaderBytes);
+        records.append(payload);
+    }
+
+    QMutexLocker lock(&m_mutex);
+    if(m_tail.isOpen() && m_tail.size() >= SegmentBytes){
+        m_tail.close();
+        ++m_tailSegment;
+    }
+    if(!m_tail.isOpen()){
+        m_tail.setFileName(segmentPath(m_tailSegment));
+        if(!m_tail.open(QIODevice::WriteOnly | QIODevice::Append)){
+            if(error) *error = QString("Cannot open spool file %1: %2").arg(m_tail.fileName(), m_tail.errorString());
+            return false;
+        }
+    }
+    const qint64 before = m_tail.size();
+    if(m_tail.write(records) != records.size() || !syncFile(m_tail)){
+        if(error) *error = QString("Cannot write spool file %1: %2").arg(m_tail.fileName(), m_tail.errorString());
+        m_tail.resize(before);
+        return false;
+    }
+    m_pending += int(manifests.size());
+    return true;
+}
+
+// This method reads from the head onwards, moving to the next segment at the end of each one.
+QVector<PostSpool::Entry> PostSpool::peek(int maxCount) const{
+    QMutexLocker lock(&m_mutex);
+    QVector<Entry> out;
+    Cursor at = m_head;
+    QFile f;
+    while(out.size() < std::min(maxCount, m_pending)){
+        if(f.fileName() != segmentPath(at.segment)){
+            f.close();
+            f.setFileName(segmentPath(at.segment));
+            f.open(QIODevice::ReadOnly);
+        }
+        QByteArray payload;
+        const qint64 next = f.isOpen() ? readRecord(f, at.offset, &payload) : -1;
+        if(next < 0){
+            if(at.segment >= m_tailSegment) break;
+            at = {at.segment + 1, 0};
+            continue;
+        }
+        at.offset = next;
+        out.push_back({qUncompress(payload), at});
+    }
+    return out;
+}
+
+// This method moves the head past delivered manifests and deletes the segments left behind.
+void PostSpool::commit(const Cursor& next, int count){
+    QMutexLocker lock(&m_mutex);
+    for(quint32 segment = m_head.segment; segment < next.segment; ++segment) QFile::remove(segmentPath(segment));
+    m_head = next;
+    m_pending = std::max(0, m_pending - count);
+    // Once everything is delivered the tail segment goes too, and appends start a fresh one.
+    if(m_pending == 0){
+        m_tail.close();
+        for(quint32 segment = m_head.segment; segment <= m_tailSegment; ++segment) QFile::remove(segmentPath(segment));
+        m_head = {++m_tailSegment, 0};
+    }
+    saveCursor();
+}
+
+// This method returns the number of manifests waiting in the spool.
+int PostSpool::pending() const{
+    QMutexLocker lock(&m_mutex);
+    return m_pending;
+}
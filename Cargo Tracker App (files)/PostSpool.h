@@ -0,0 +1,64 @@
+#ifndef POSTSPOOL_H
+#define POSTSPOOL_H
+#include <QByteArray>
+#include <QFile>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+
+// The PostSpool class keeps manifests that could not be delivered on local disk until they can be.
+// Manifests are appended, zlib-compressed and checksummed, to numbered segment files
+// (spool-00000001.seg, ...); a small cursor file remembers the first manifest the server has not yet
+// acknowledged. Segments are deleted once every manifest in them is delivered, so the spool only ever
+// holds the backlog. Manifests come out in the order they went in.
+// The class is thread-safe: SerializationWorker appends while SpoolDrainer reads on another thread.
+class PostSpool{
+public:
+    // A position in the spool: segment number and byte offset within it.
+    struct Cursor{
+        quint32 segment{1};
+        qint64 offset{0};
+    };
+
+    // One spooled manifest and the position just after it, to hand to commit() once it is delivered.
+    struct Entry{
+        QByteArray manifest;
+        Cursor next;
+    };
+
+    // A new segment is started once the current one has grown past this size.
+    static constexpr qint64 SegmentBytes = 4 * 1024 * 1024;
+
+    // This is the constructor. It opens (or creates) the spool in the given directory and counts the
+    // manifests still waiting in it. A record torn by a crash at the end of the spool is cut off.
+    explicit PostSpool(const QString& directory);
+
+    // This method appends manifests at the end of the spool and forces them onto the disk.
+    // It returns false and sets error if they could not be written; nothing is appended then.
+    bool append(const QVector<QByteArray>& manifests, QString* error);
+
+    // This method reads up to maxCount manifests from the front of the spool without removing them.
+    QVector<Entry> peek(int maxCount) const;
+
+    // This method removes the first count manifests, which must end at the given position.
+    void commit(const Cursor& next, int count);
+
+    // This method returns the number of manifests waiting in the spool.
+    int pending() const;
+
+private:
+    // This private helper function returns the path of a segment file.
+    QString segmentPath(quint32 segment) const;
+    // This private helper function writes the cursor file, replacing the old one atomically.
+    void saveCursor();
+
+private:
+    QString m_directory;
+    mutable QMutex m_mutex;
+    Cursor m_head;            // The first manifest not yet delivered.
+    quint32 m_tailSegment{1}; // The segment appends go to.
+    QFile m_tail;             // The tail segment, opened on the first append.
+    int m_pending{0};         // The manifests between m_head and the end of the tail segment.
+};
+
+#endif // POSTSPOOL_H
@@ -0,0 +1,133 @@
+#include "QueryClient.h"
+#include <QTcpSocket>
+#include "ContainerCode.h"
+
+// This is the constructor. The socket is created now but only connected when the first query is sent.
+QueryClient::QueryClient(QObject* parent): QObject(parent){
+    sock = new QTcpSocket(this);
+    connect(sock, &QTcpSocket::connected, this, &QueryClient::onConnected);
+    connect(sock, &QTcpSocket::readyRead, this, &QueryClient::onReadyRead);
+    connect(sock, &QTcpSocket::errorOccurred, this, &QueryClient::onSocketError);
+}
+
+// This method changes the server address used by the next connection.
+void QueryClient::setServer(const QHostAddress& h, quint16 p){
+    host = h;
+    port = p;
+}
+
+// This method asks for every container on one pallet.
+quint32 QueryClient::queryPallet(int pallet){
+    QByteArray payload;
+    Wire::Writer(payload).i32(pallet);
+    return send(Wire::Frame::QueryPallet, payload);
+}
+
+// This method asks for the container with the given code. Codes are sent packed, as the server stores them.
+quint32 QueryClient::queryCode(const QString& code){
+    QByteArray payload;
+    Wire::Writer(payload).u32(ContainerCode::pack(code));
+    return send(Wire::Frame::QueryCode, payload);
+}
+
+// This method asks for the server's totals and its topCount heaviest pallets.
+quint32 QueryClient::queryAggregates(int topCount){
+    QByteArray payload;
+    Wire::Writer(payload).u32(quint32(qMax(0, topCount)));
+    return send(Wire::Frame::QueryAggregates, payload);
+}
+
+// This method asks for count rows starting at first, in the server's pallet order.
+quint32 QueryClient::queryPage(int first, int count){
+    QByteArray payload;
+    Wire::Writer w(payload);
+    w.u32(quint32(qMax(0, first)));
+    w.u32(quint32(qMax(0, count)));
+    return send(Wire::Frame::QueryPage, payload);
+}
+
+// This private helper function writes a request, or queues it until the connection is established.
+quint32 QueryClient::send(Wire::Frame type, const QByteArray& payload){
+    const quint32 id = nextId++;
+    pending.insert(id);
+    const QByteArray frame = Wire::frame(type, id, payload);
+    if(sock->state() == QAbstractSocket::ConnectedState){
+        sock->write(frame);
+    } else {
+        outbox.append(frame);
+        if(sock->state() == QAbstractSocket::UnconnectedState) sock->connectToHost(host, port);
+    }
+    return id;
+}
+
+// This slot sends the requests that were queued while connecting.
+void QueryClient::onConnected(){
+    sock->write(outbox);
+    outbox.clear();
+}
+
+// This slot handles every complete frame in the received bytes.
+void QueryClient::onReadyRead(){
+    inbox.append(sock->readAll());
+    Wire::Frame type;
+    quint32 id = 0;
+    QByteArray payload;
+    for(;;){
+        const Wire::TakeResult result = Wire::takeFrame(inbox, type, id, payload);
+        if(result == Wire::TakeResult::NeedMore) return;
+        if(result == Wire::TakeResult::Malformed){
+            // The stream is out of step, so every outstanding request is lost.
+            sock->abort();
+            onSocketError();
+            return;
+        }
+        handleFrame(type, id, payload);
+    }
+}
+
+// This private helper function decodes one answer and emits the matching signal.
+void QueryClient::handleFrame(Wire::Frame type, quint32 id, const QByteArray& payload){
+    if(!pending.contains(id)) return;
+    Wire::Reader in(payload);
+
+    if(type == Wire::Frame::Rows){
+        const quint32 total = in.u32();
+        in.u32(); // The position of this frame's rows within the result; frames arrive in order.
+        const bool last = in.u8() != 0;
+        const quint32 count = in.u32();
+        if(!in.ok() || quint64(count) * Wire::RowBytes > quint64(in.remaining())){
+            pending.remove(id);
+            partial.remove(id);
+            emit queryFailed(id, "Truncated answer");
+            return;
+        }
+        QVector<Wire::Row>& rows = partial[id];
+        if(rows.isEmpty()) rows.reserve(qMin(total, Wire::MaxPageRows));
+        for(quint32 i = 0; i < count; ++i) rows.push_back(in.row());
+        if(!last) return;
+
+        pending.remove(id);
+        const QVector<Wire::Row> result = partial.take(id);
+        emit rowsReceived(id, result, total);
+    } else if(type == Wire::Frame::Aggregates){
+        pending.remove(id);
+        Wire::Aggregates totals;
+        if(Wire::readAggregates(payload, totals)) emit aggregatesReceived(id, totals);
+        else emit queryFailed(id, "Truncated answer");
+    } else {
+        pending.remove(id);
+        partial.remove(id);
+        emit queryFailed(id, type == Wire::Frame::Error ? QString::fromUtf8(payload) : "Unexpected answer");
+    }
+}
+
+// This slot fails every outstanding request when the connection cannot be made or is lost.
+void QueryClient::onSocketError(){
+    const QString message = sock->errorString();
+    const QList<quint32> failed = pending.values();
+    pending.clear();
+    partial.clear();
+    outbox.clear();
+    inbox.clear();
+    for(quint32 id: failed) emit queryFailed(id, message);
+}
@@ -0,0 +1,64 @@
+#ifndef QUERYCLIENT_H
+#define QUERYCLIENT_H
+#include <QObject>
+#include <QByteArray>
+#include <QHash>
+#include <QHostAddress>
+#include <QSet>
+#include <QVector>
+#include "WireProtocol.h"
+
+// Forward declarations to minimize dependencies and improve compile times.
+class QTcpSocket;
+
+// The QueryClient class asks the server what it holds, using the binary query protocol in
+// WireProtocol.h. It is asynchronous: every query method returns a request id at once, and the answer
+// arrives later through a signal carrying the same id. Several queries may be in flight on the one
+// connection, which is opened on first use and kept open.
+class QueryClient : public QObject{
+    Q_OBJECT
+public:
+    // Explicit constructor to prevent implicit type conversions.
+    explicit QueryClient(QObject* parent = nullptr);
+
+    // This method sets where queries are sent. It takes effect on the next connection.
+    void setServer(const QHostAddress& host, quint16 port);
+
+    // These methods send one query each and return its request id.
+    quint32 queryPallet(int pallet);
+    quint32 queryCode(const QString& code);
+    quint32 queryAggregates(int topCount);
+    quint32 queryPage(int first, int count);
+
+signals:
+    // This signal is emitted once all rows of a pallet, code or page query have arrived.
+    void rowsReceived(quint32 id, const QVector<Wire::Row>& rows, quint32 total);
+    // This signal is emitted with the answer to an aggregates query.
+    void aggregatesReceived(quint32 id, const Wire::Aggregates& totals);
+    // This signal is emitted when a query fails, either on the server or because the connection failed.
+    void queryFailed(quint32 id, const QString& message);
+
+private slots:
+    // These slots handle the socket: sending queued requests, reading answers and reporting errors.
+    void onConnected();
+    void onReadyRead();
+    void onSocketError();
+
+private:
+    // This private helper function frames a request, queues it and opens the connection if needed.
+    quint32 send(Wire::Frame type, const QByteArray& payload);
+    // This private helper function handles one complete answer frame.
+    void handleFrame(Wire::Frame type, quint32 id, const QByteArray& payload);
+
+private:
+    QTcpSocket* sock{};                                 // The connection to the query port.
+    QHostAddress host{QHostAddress::LocalHost};         // The server address.
+    quint16 port{Wire::DefaultQueryPort};               // The server's query port.
+    quint32 nextId{1};                                  // The id of the next request.
+    QByteArray outbox;                                  // Requests written before the connection was up.
+    QByteArray inbox;                                   // Received bytes not yet forming a whole frame.
+    QSet<quint32> pending;                              // Requests still waiting for their answer.
+    QHash<quint32, QVector<Wire::Row>> partial;         // Rows received so far for streamed answers.
+};
+
+#endif // QUERYCLIENT_H
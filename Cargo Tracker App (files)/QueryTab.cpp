@@ -0,0 +1,94 @@
+#include "QueryTab.h"
+#include <QGridLayout>
+#include <QLabel>
+#include <QLineEdit>
+#include <QPlainTextEdit>
+#include <QPushButton>
+#include <QSpinBox>
+#include <limits>
+#include "ContainerCode.h"
+#include "QueryClient.h"
+
+// This is the constructor for the QueryTab class. It sets up the UI and connections.
+QueryTab::QueryTab(QWidget* parent): QWidget(parent){
+    client = new QueryClient(this);
+    buildUi();
+    wire();
+}
+
+// This private helper function builds the user interface for the tab.
+void QueryTab::buildUi(){
+    auto* lay = new QGridLayout(this);
+    sbPallet = new QSpinBox(this);
+    sbPallet->setRange(1, 1000000);
+    btnPallet = new QPushButton(tr("Show pallet"), this);
+    edCode = new QLineEdit(this);
+    edCode->setPlaceholderText("YYYY/MM/B1234");
+    btnCode = new QPushButton(tr("Find code"), this);
+    btnTotals = new QPushButton(tr("Server totals"), this);
+    btnPage = new QPushButton(tr("First page of rows"), this);
+    txtResult = new QPlainTextEdit(this);
+    txtResult->setReadOnly(true);
+
+    lay->addWidget(new QLabel(tr("Pallet"), this), 0, 0);
+    lay->addWidget(sbPallet, 0, 1);
+    lay->addWidget(btnPallet, 0, 2);
+    lay->addWidget(new QLabel(tr("Code"), this), 1, 0);
+    lay->addWidget(edCode, 1, 1);
+    lay->addWidget(btnCode, 1, 2);
+    lay->addWidget(btnTotals, 2, 1);
+    lay->addWidget(btnPage, 2, 2);
+    lay->addWidget(txtResult, 3, 0, 1, 3);
+    setLayout(lay);
+}
+
+// This private helper function connects the buttons to queries and the answers to the result area.
+void QueryTab::wire(){
+    connect(btnPallet, &QPushButton::clicked, this, [this]{ client->queryPallet(sbPallet->value()); });
+    connect(btnCode, &QPushButton::clicked, this, [this]{ client->queryCode(edCode->text().trimmed()); });
+    connect(btnTotals, &QPushButton::clicked, this, [this]{ client->queryAggregates(HeaviestPallets); });
+    connect(btnPage, &QPushButton::clicked, this, [this]{ client->queryPage(0, PageRows); });
+
+    connect(client, &QueryClient::rowsReceived, this, [this](quint32, const QVector<Wire::Row>& rows, quint32 total){
+        showRows(rows, total);
+    });
+    connect(client, &QueryClient::aggregatesReceived, this, [this](quint32, const Wire::Aggregates& totals){
+        showAggregates(totals);
+    });
+    connect(client, &QueryClient::queryFailed, this, [this](quint32, const QString& message){
+        emit statusMessage(tr("Query failed: %1").arg(message));
+    });
+}
+
+// This private helper function lists rows one per line.
+void QueryTab::showRows(const QVector<Wire::Row>& rows, quint32 total){
+    QString out = tr("%1 container(s)\n").arg(total);
+    for(const Wire::Row& r: rows){
+        // Fields the server marks as missing arrive as the smallest int and are left out.
+        auto num = [](qint32 v){ return v == std::numeric_limits<qint32>::min() ? QString("-") : QString::number(v); };
+        out += QString("Pallet %1  %2  %3  h=%4 w=%5 l=%6 b=%7 d=%8\n")
+                   .arg(r.pallet)
+                   .arg(r.type == 0 ? "Box" : r.type == 1 ? "Cylinder" : "?")
+                   .arg(ContainerCode::format(r.code))
+                   .arg(num(r.height), num(r.weight), num(r.length), num(r.breadth), num(r.diameter));
+    }
+    txtResult->setPlainText(out);
+    emit statusMessage(tr("Query answered."));
+}
+
+// This private helper function lists the server's totals.
+void QueryTab::showAggregates(const Wire::Aggregates& a){
+    QString out = tr("%1 containers on %2 pallets, total weight %3\n\n").arg(a.containers).arg(a.pallets).arg(a.weight);
+    out += tr("Boxes: %1 (volume %2)\n").arg(a.types[0].containers).arg(a.types[0].volume, 0, 'f', 0);
+    out += tr("Cylinders: %1 (volume %2)\n\n").arg(a.types[1].containers).arg(a.types[1].volume, 0, 'f', 0);
+    out += tr("Heaviest pallets:\n");
+    for(const Wire::PalletTotal& p: a.heaviest){
+        out += tr("  Pallet %1: %2 containers, weight %3\n").arg(p.pallet).arg(p.containers).arg(p.weight);
+    }
+    out += tr("\nContainers per month:\n");
+    for(const Wire::MonthCount& m: a.months){
+        out += QString("  %1/%2: %3\n").arg(m.year).arg(m.month, 2, 10, QLatin1Char('0')).arg(m.containers);
+    }
+    txtResult->setPlainText(out);
+    emit statusMessage(tr("Query answered."));
+}
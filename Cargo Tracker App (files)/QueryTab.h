@@ -0,0 +1,52 @@
+#ifndef QUERYTAB_H
+#define QUERYTAB_H
+#include <QWidget>
+#include <QVector>
+#include "WireProtocol.h"
+
+// Forward declarations to minimize dependencies and improve compile times.
+class QLineEdit;
+class QPlainTextEdit;
+class QPushButton;
+class QSpinBox;
+class QueryClient;
+
+// The QueryTab class lets the user look at what the server holds: the containers of a pallet, one
+// container by code, the server's totals or the first page of all rows. The answers come from the
+// server's query port through a QueryClient, so the client does not need its own copy of posted data.
+class QueryTab : public QWidget{
+    Q_OBJECT
+public:
+    // Explicit constructor to prevent implicit type conversions.
+    explicit QueryTab(QWidget* parent = nullptr);
+
+signals:
+    // This signal is emitted to provide status updates to the main application window's status bar.
+    void statusMessage(const QString& msg);
+
+private:
+    // Private helper functions to set up the UI and connect signals and slots.
+    void buildUi();
+    void wire();
+    // These private helper functions show an answer in the result area.
+    void showRows(const QVector<Wire::Row>& rows, quint32 total);
+    void showAggregates(const Wire::Aggregates& totals);
+
+private:
+    // The number of rows requested by "First page" and of pallets listed with the totals.
+    static constexpr int PageRows = 200;
+    static constexpr int HeaviestPallets = 10;
+
+    // UI elements for the query tab.
+    QSpinBox* sbPallet{};
+    QPushButton* btnPallet{};
+    QLineEdit* edCode{};
+    QPushButton* btnCode{};
+    QPushButton* btnTotals{};
+    QPushButton* btnPage{};
+    QPlainTextEdit* txtResult{};
+    // The connection to the server's query port.
+    QueryClient* client{};
+};
+
+#endif // QUERYTAB_H
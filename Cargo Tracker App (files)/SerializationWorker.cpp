@@ -4,10 +4,15 @@
 #include "Box.h"
 #include "Cylinder.h"
 #include <QXmlStreamWriter>
-#include <QTcpSocket>
+#include <algorithm>
+#include <stdexcept>
+#include "ManifestSender.h"
+#include "PostSpool.h"
+#include "Trace.h"
+#include "MemoryAccounting.h"
 
 // This private helper function builds an XML string from the provided list of pallets.
-QString SerializationWorker::buildXml(const QVector<Pallet*>& pallets) const{
+QString SerializationWorker::buildXml(const QVector<Pallet*>& pallets, quint64 traceId) const{
     QString s;
     s.reserve(4096); // Reserves memory to improve performance.
 
@@ -20,6 +25,7 @@ QString SerializationWorker::buildXml(const QVector<Pallet*>& pallets) const{
     w.writeStartElement("pallets");
     // Adds an attribute to the root element with the total number of pallets.
     w.writeAttribute("NumberOfPallets", QString::number(pallets.size()));
+    if(traceId != 0) w.writeAttribute("traceId", QString::number(traceId, 16));
 
     // Iterates through each pallet to write its data.
     for(const auto* p: pallets){
@@ -61,38 +67,103 @@ QString SerializationWorker::buildXml(const QVector<Pallet*>& pallets) const{
     return s;
 }
 
-// This private helper function handles the network communication to send the XML data.
-void SerializationWorker::sendToServer(const QString& xml){
-    QTcpSocket sock;
-    // Attempts to connect to the local host on port 6164.
-    sock.connectToHost(QHostAddress::LocalHost, 6164);
+// This private helper function posts the pallets in batches and waits until the server has answered each.
+void SerializationWorker::sendToServer(const QVector<Pallet*>& pallets){
+    // Splits the pallets into manifests so that one bad pallet only fails its own batch and the
+    // server can parse the batches in parallel.
+    // With tracing on, each manifest gets a trace id whose flow the server's trace picks up.
+    QVector<QByteArray> manifests;
+    for(int i = 0; i < pallets.size(); i += PalletsPerManifest){
+        const quint64 traceId = Trace::enabled() ? Trace::newId() : 0;
+        QString xml;
+        {
+            Trace::Span span("buildXml");
+            span.setTraceId(traceId);
+            xml = buildXml(pallets.mid(i, PalletsPerManifest), traceId);
+            Trace::flowStart(traceId);
+        }
+        const Memory::Charge xmlCharge(Memory::Domain::XmlBuffers, xml.capacity() * qint64(sizeof(QChar)));
+        TRACE_SPAN("toUtf8");
+        manifests.push_back(xml.toUtf8());
+    }
+    // The encoded manifests stay alive until they are acknowledged or spooled.
+    qint64 manifestBytes = 0;
+    for(const QByteArray& m: manifests) manifestBytes += m.capacity();
+    const Memory::Charge manifestCharge(Memory::Domain::XmlBuffers, manifestBytes);
 
-    // Waits for the connection to be established. Throws an exception on failure.
-    if(!sock.waitForConnected(2000)) {
-        throw std::runtime_error("Cannot connect to server");
+    // While older posts are still spooled, new ones queue behind them so the server sees them in order.
+    QString spoolError;
+    if(const int backlog = m_spool->pending()){
+        if(!m_spool->append(manifests, &spoolError)) throw std::runtime_error(spoolError.toStdString());
+        emit spooled();
+        emit finished(QString("%1 earlier manifest(s) still waiting for the server; spooled %2 more")
+                          .arg(backlog).arg(manifests.size()));
+        return;
     }
 
-    // Converts the XML string to UTF-8 encoded byte array.
-    QByteArray data = xml.toUtf8();
-    sock.write(data);
-    sock.flush();
-    // Waits for the data to be written to the socket.
-    sock.waitForBytesWritten(2000);
-    // Disconnects from the host.
-    sock.disconnectFromHost();
+    // One attempt only: whatever the server cannot take now is spooled rather than retried here.
+    ManifestSender sender(QHostAddress::LocalHost, Wire::DefaultManifestPort, 1);
+    sender.setChunkBytes(ManifestSender::chunkBytesFromEnvironment());
+    const QVector<ManifestSender::Outcome> outcomes = sender.send(manifests);
+
+    QVector<qint64> latencies;
+    QVector<QByteArray> retry;
+    quint32 containers = 0;
+    int rejected = 0;
+    QString firstError;
+    for(int i = 0; i < outcomes.size(); ++i){
+        const auto& o = outcomes.at(i);
+        if(o.acked){
+            latencies.push_back(o.latencyMs);
+            containers += o.containers;
+            continue;
+        }
+        if(Wire::isRetryable(o.reason)) retry.push_back(manifests.at(i));
+        else ++rejected;
+        if(firstError.isEmpty()) firstError = o.message;
+    }
+    if(!retry.isEmpty()){
+        if(!m_spool->append(retry, &spoolError)){
+            throw std::runtime_error(QString("%1 manifest(s) could not be posted (%2) nor spooled: %3")
+                                         .arg(retry.size()).arg(firstError).arg(spoolError).toStdString());
+        }
+        emit spooled();
+    }
+    if(rejected > 0){
+        throw std::runtime_error(QString("%1 of %2 manifest(s) were rejected by the server: %3")
+                                     .arg(rejected).arg(outcomes.size()).arg(firstError).toStdString());
+    }
+    if(latencies.isEmpty()){
+        emit finished(QString("Server unreachable (%1); spooled %2 manifest(s), they will be posted "
+                              "when it is back").arg(firstError).arg(retry.size()));
+        return;
+    }
+
+    // Reports the round trip the user actually waited for, from writing a manifest to its Ack.
+    std::sort(latencies.begin(), latencies.end());
+    QString status = QString("Posted %1 manifest(s), %2 container(s), to 127.0.0.1:%3; acknowledged "
+                             "(median %4 ms, slowest %5 ms)")
+                         .arg(latencies.size()).arg(containers).arg(Wire::DefaultManifestPort)
+                         .arg(latencies.at(latencies.size() / 2)).arg(latencies.last());
+    if(!retry.isEmpty()) status += QString("; %1 spooled for later").arg(retry.size());
+    emit finished(status);
 }
 
 // The main entry point for the worker's task.
 void SerializationWorker::doSerializeAndSend(const QVector<Pallet*>& pallets){
+    TRACE_SPAN("post");
     try{
         // Builds the XML string.
-        const QString xml = buildXml(pallets);
+        QString xml;
+        {
+            TRACE_SPAN("buildDisplayXml");
+            xml = buildXml(pallets);
+        }
+        const Memory::Charge xmlCharge(Memory::Domain::XmlBuffers, xml.capacity() * qint64(sizeof(QChar)));
         // Emits a signal to the main thread with the generated XML.
         emit xmlReady(xml);
-        // Sends the XML data to the server.
-        sendToServer(xml);
-        // Emits a signal to indicate the process finished successfully.
-        emit finished("XML posted to 127.0.0.1:6164");
+        // Sends the pallets to the server; this also emits finished once every manifest is acknowledged or spooled.
+        sendToServer(pallets);
     } catch(const std::exception& e){
         // Catches any exceptions and emits an error signal with the error message.
         emit error(QString::fromUtf8(e.what()));
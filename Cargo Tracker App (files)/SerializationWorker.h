@@ -5,15 +5,22 @@
 #include <QVector>
 
 class Pallet;
+class PostSpool;
 
 // The SerializationWorker class is designed to run in a separate thread.
 // Its purpose is to perform the serialization of pallet data into XML and send it to a server,
 // preventing the main application's UI from freezing during these long-running operations.
+// Pallets are posted as several manifests of at most PalletsPerManifest pallets, which are pipelined
+// and individually acknowledged by the server (see ManifestSender). Manifests the server cannot take
+// right now go to the PostSpool instead, and SpoolDrainer posts them once the server is back.
 class SerializationWorker : public QObject{
     Q_OBJECT
 public:
-    // This is the constructor for the SerializationWorker.
-    explicit SerializationWorker(QObject* parent = nullptr): QObject(parent) {}
+    // The most pallets put into one manifest.
+    static constexpr int PalletsPerManifest = 25;
+
+    // This is the constructor for the SerializationWorker. The spool must outlive the worker.
+    explicit SerializationWorker(PostSpool* spool, QObject* parent = nullptr): QObject(parent), m_spool(spool) {}
 
 public slots:
     // This public slot is the entry point for the worker's task.
@@ -27,12 +34,18 @@ signals:
     void finished(const QString& status);
     // This signal is emitted if an error occurs during the process.
     void error(const QString& message);
+    // This signal is emitted when manifests were added to the spool instead of being posted.
+    void spooled();
+
+private:
+    // A private helper function that takes pallet data and builds an XML string from it. A non-zero
+    // trace id is written into the root element, so the server's trace can be matched to this post.
+    QString buildXml(const QVector<Pallet*>& pallets, quint64 traceId = 0) const;
+    // A private helper function that posts the pallets as manifests and reports the server's verdict.
+    void sendToServer(const QVector<Pallet*>& pallets);
 
 private:
-    // A private helper function that takes pallet data and builds an XML string from it.
-    QString buildXml(const QVector<Pallet*>& pallets) const;
-    // A private helper function responsible for sending the generated XML data to a server.
-    void sendToServer(const QString& xml);
+    PostSpool* m_spool;
 };
 
 #endif // SERIALIZATIONWORKER_H
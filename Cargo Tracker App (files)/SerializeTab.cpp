@@ -4,13 +4,18 @@
 #include <QPushButton>
 #include <QThread>
 #include <QMessageBox>
+#include <QStandardPaths>
 #include "SerializationWorker.h"
+#include "PostSpool.h"
+#include "SpoolDrainer.h"
 #include "Pallet.h"
+#include "Trace.h"
 
 // This is the constructor for the SerializeTab class. It sets up the UI and connections.
 SerializeTab::SerializeTab(QWidget* parent): QWidget(parent){
     buildUi();
     wire();
+    startSpool();
 }
 
 // The destructor ensures proper cleanup of the worker thread to prevent memory leaks and crashes.
@@ -22,6 +27,10 @@ SerializeTab::~SerializeTab(){
         delete workerThread;
         workerThread = nullptr;
     }
+    // Stops the drainer before the spool it reads from is deleted.
+    drainThread->quit();
+    drainThread->wait();
+    delete spool;
 }
 
 // This private helper function builds the user interface for the tab.
@@ -50,8 +59,23 @@ void SerializeTab::wire(){
     });
 }
 
+// This private helper function opens the spool in the application's data directory and starts the
+// drainer thread. Posts spooled in an earlier session are sent as soon as the server answers.
+void SerializeTab::startSpool(){
+    spool = new PostSpool(QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation) + "/spool");
+    drainThread = new QThread(this);
+    drainThread->setObjectName("spool-drain");
+    drainer = new SpoolDrainer(spool);
+    drainer->moveToThread(drainThread);
+    connect(drainer, &SpoolDrainer::statusMessage, this, &SerializeTab::statusMessage);
+    connect(drainThread, &QThread::finished, drainer, &QObject::deleteLater);
+    drainThread->start();
+    QMetaObject::invokeMethod(drainer, &SpoolDrainer::wake, Qt::QueuedConnection);
+}
+
 // This public method is called to begin the serialization and network process.
 void SerializeTab::serializeAndSend(const QVector<Pallet*>& pallets){
+    TRACE_SPAN("serializeAndSend");
     // Checks if there are any pallets to serialize. If not, it shows a message and returns.
     if(pallets.isEmpty()){
         QMessageBox::information(this, tr("Post XML"), tr("No pallets to serialize."));
@@ -66,7 +90,8 @@ void SerializeTab::serializeAndSend(const QVector<Pallet*>& pallets){
     }
     // Creates a new worker thread and a SerializationWorker object.
     workerThread = new QThread(this);
-    auto* worker = new SerializationWorker();
+    workerThread->setObjectName("serialize");
+    auto* worker = new SerializationWorker(spool);
     // Moves the worker object to the new thread.
     worker->moveToThread(workerThread);
 
@@ -77,12 +102,15 @@ void SerializeTab::serializeAndSend(const QVector<Pallet*>& pallets){
     });
     // Connects signals from the worker to slots in this tab for UI updates.
     connect(worker, &SerializationWorker::xmlReady, this, [this](const QString& xml){
+        TRACE_SPAN("showXml");
         txtXml->setPlainText(xml);
         emit statusMessage("XML generated.");
     });
     connect(worker, &SerializationWorker::finished, this, [this](const QString& s){
         emit statusMessage(s);
     });
+    // Spooled manifests are handed to the drainer, which runs on its own thread.
+    connect(worker, &SerializationWorker::spooled, drainer, &SpoolDrainer::wake);
     connect(worker, &SerializationWorker::error, this, [this](const QString& e){
         QMessageBox::critical(this, tr("Error"), e);
         emit statusMessage(e);
@@ -8,9 +8,12 @@ class QPlainTextEdit;
 class QPushButton;
 class QThread;
 class Pallet;
+class PostSpool;
+class SpoolDrainer;
 
 // The SerializeTab class is a QWidget that provides a user interface
 // for serializing data and sending it to a server.
+// It also owns the spool of posts the server could not take yet, and the thread that drains it.
 class SerializeTab : public QWidget{
     Q_OBJECT
 public:
@@ -31,6 +34,8 @@ private:
     // Private helper functions to set up the UI and connect signals and slots.
     void buildUi();
     void wire();
+    // Private helper function that opens the spool and starts draining whatever it still holds.
+    void startSpool();
 
 private:
     // UI elements for the serialization tab.
@@ -40,6 +45,10 @@ private:
     QPushButton* btnPost{};
     // A separate thread to run the serialization and network operations without blocking the UI.
     QThread* workerThread{};
+    // The on-disk queue of manifests waiting for the server, and the drainer posting them on its own thread.
+    PostSpool* spool{};
+    SpoolDrainer* drainer{};
+    QThread* drainThread{};
 };
 
 #endif // SERIALIZETAB_H
@@ -0,0 +1,58 @@
+#include "SharedRing.h"
+#include <QCoreApplication>
+#include <QRandomGenerator>
+#include <cstring>
+
+// This method creates the shared memory. The key is unique per ring, so a server still parsing from an
+// older ring of this client is never affected by a new one.
+bool SharedRing::create(qint64 bytes, QString* error){
+    m_memory.setKey(QString("cargo-ring-%1-%2").arg(QCoreApplication::applicationPid())
+                        .arg(QRandomGenerator::global()->generate64(), 16, 16, QLatin1Char('0')));
+    if(!m_memory.create(qsizetype(bytes))){
+        if(error) *error = m_memory.errorString();
+        return false;
+    }
+    m_capacity = bytes;
+    m_regions.clear();
+    m_head = 0;
+    return true;
+}
+
+// This method finds room after the newest region, or else at the start of the ring before the oldest.
+qint64 SharedRing::write(const QByteArray& data){
+    const qint64 length = data.size();
+    if(length == 0 || length > m_capacity) return -1;
+
+    qint64 offset = -1;
+    if(m_regions.empty()){
+        offset = 0;
+    } else {
+        const qint64 tail = m_regions.front().offset;
+        if(m_head > tail){
+            // Not wrapped: the free space is after the head, and before the tail once we wrap.
+            if(length <= m_capacity - m_head) offset = m_head;
+            else if(length < tail) offset = 0;
+        } else if(length < tail - m_head){
+            // Wrapped: the free space is between the head and the tail.
+            offset = m_head;
+        }
+    }
+    if(offset < 0) return -1;
+
+    std::memcpy(static_cast<char*>(m_memory.data()) + offset, data.constData(), size_t(length));
+    m_regions.push_back({offset, length, false});
+    m_head = offset + length;
+    return offset;
+}
+
+// This method marks a region released and reclaims every released region at the tail.
+void SharedRing::release(qint64 offset){
+    for(Region& r: m_regions){
+        if(r.offset == offset && !r.released){
+            r.released = true;
+            break;
+        }
+    }
+    while(!m_regions.empty() && m_regions.front().released) m_regions.pop_front();
+    if(m_regions.empty()) m_head = 0;
+}
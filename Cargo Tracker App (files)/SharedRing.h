@@ -0,0 +1,45 @@
+#ifndef SHAREDRING_H
+#define SHAREDRING_H
+#include <QByteArray>
+#include <QSharedMemory>
+#include <QString>
+#include <deque>
+
+// The SharedRing class is a single-producer, single-consumer ring buffer in shared memory, used to hand
+// manifests to a server on the same host without copying them through a socket. The client writes a
+// manifest into the ring and tells the server its offset and length; the server parses it in place and
+// answers, after which the client releases the space. Every manifest occupies one contiguous region, so
+// the server can read it as a plain byte range; a region that does not fit before the end of the ring
+// starts again at the beginning. Space is reclaimed in write order, as in any ring.
+// The class belongs to one thread and one connection; the server only ever reads.
+class SharedRing{
+public:
+    // This method creates a ring of the given size under a new, unique key. It returns false and sets
+    // error if the shared memory cannot be created.
+    bool create(qint64 bytes, QString* error);
+
+    // This method returns the key the server attaches with.
+    QString key() const{ return m_memory.key(); }
+    // This method returns the ring's size in bytes.
+    qint64 capacity() const{ return m_capacity; }
+
+    // This method copies data into the ring and returns its offset, or -1 if there is no room right now.
+    qint64 write(const QByteArray& data);
+    // This method gives back the region starting at offset once the server has answered for it.
+    void release(qint64 offset);
+
+private:
+    // One written region, in write order.
+    struct Region{
+        qint64 offset;
+        qint64 length;
+        bool released;
+    };
+
+    QSharedMemory m_memory;
+    qint64 m_capacity{0};
+    std::deque<Region> m_regions;   // The regions not yet reclaimed, oldest first.
+    qint64 m_head{0};               // Where the next region would start if it fits.
+};
+
+#endif // SHAREDRING_H
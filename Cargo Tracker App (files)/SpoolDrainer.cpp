@@ -0,0 +1,74 @@
+#include "SpoolDrainer.h"
+#include <QHostAddress>
+#include <QTimer>
+#include <algorithm>
+#include "ManifestSender.h"
+#include "PostSpool.h"
+
+// This is the constructor. The timer is a child, so it moves to the drainer's thread with it.
+SpoolDrainer::SpoolDrainer(PostSpool* spool, QObject* parent): QObject(parent), m_spool(spool), m_timer(new QTimer(this)){
+    m_timer->setSingleShot(true);
+    connect(m_timer, &QTimer::timeout, this, &SpoolDrainer::drainBatch);
+}
+
+// This public slot drains now. While backing off it does nothing, so posts spooled during an outage
+// do not each cost a connection attempt.
+void SpoolDrainer::wake(){
+    if(!m_timer->isActive()) drainBatch();
+}
+
+// This private helper function sends one batch. Only the delivered front of the batch is removed from
+// the spool; resending the rest later is safe because the server keys containers by code.
+void SpoolDrainer::drainBatch(){
+    const QVector<PostSpool::Entry> batch = m_spool->peek(BatchSize);
+    if(batch.isEmpty()){
+        m_backoffMs = 0;
+        return;
+    }
+
+    QVector<QByteArray> manifests;
+    manifests.reserve(batch.size());
+    for(const auto& e: batch) manifests.push_back(e.manifest);
+    // One attempt only: the retry policy while the server is down is the backoff below.
+    ManifestSender sender(QHostAddress::LocalHost, Wire::DefaultManifestPort, 1);
+    sender.setChunkBytes(ManifestSender::chunkBytesFromEnvironment());
+    const QVector<ManifestSender::Outcome> outcomes = sender.send(manifests);
+
+    int done = 0;
+    int rejected = 0;
+    QString problem;
+    QString rejection;
+    for(; done < outcomes.size(); ++done){
+        const auto& o = outcomes.at(done);
+        if(o.acked) continue;
+        if(Wire::isRetryable(o.reason)){
+            problem = o.message;
+            break;
+        }
+        // The server will never accept this manifest, so keeping it would block everything behind it.
+        ++rejected;
+        rejection = o.message;
+    }
+    if(done > 0) m_spool->commit(batch.at(done - 1).next, done);
+    if(rejected > 0){
+        emit statusMessage(QString("%1 spooled manifest(s) rejected by the server and discarded: %2")
+                               .arg(rejected).arg(rejection));
+    }
+
+    const int pending = m_spool->pending();
+    if(done < outcomes.size()){
+        m_backoffMs = m_backoffMs == 0 ? MinBackoffMs : std::min(2 * m_backoffMs, MaxBackoffMs);
+        emit statusMessage(QString("Server unreachable (%1); %2 manifest(s) spooled, retrying in %3 s")
+                               .arg(problem).arg(pending).arg(m_backoffMs / 1000));
+        m_timer->start(m_backoffMs);
+        return;
+    }
+    m_backoffMs = 0;
+    if(pending > 0){
+        emit statusMessage(QString("Posting spooled manifests: %1 left").arg(pending));
+        // Returns to the event loop between batches so the thread can be stopped promptly.
+        m_timer->start(0);
+    } else {
+        emit statusMessage("All spooled manifests have been posted.");
+    }
+}
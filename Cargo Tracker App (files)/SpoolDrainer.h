@@ -0,0 +1,42 @@
+#ifndef SPOOLDRAINER_H
+#define SPOOLDRAINER_H
+#include <QObject>
+
+class PostSpool;
+class QTimer;
+
+// The SpoolDrainer class posts the manifests waiting in a PostSpool once the server can be reached.
+// It is designed to run in its own thread. Manifests are sent in spool order, BatchSize at a time over
+// one connection; the delivered front of each batch is removed from the spool. While the server stays
+// unreachable the drainer waits longer before each try, doubling from MinBackoffMs up to MaxBackoffMs.
+class SpoolDrainer : public QObject{
+    Q_OBJECT
+public:
+    // The most manifests sent over one connection, and the shortest and longest wait between tries.
+    static constexpr int BatchSize = 32;
+    static constexpr int MinBackoffMs = 1000;
+    static constexpr int MaxBackoffMs = 60000;
+
+    // This is the constructor. The spool must outlive the drainer.
+    explicit SpoolDrainer(PostSpool* spool, QObject* parent = nullptr);
+
+public slots:
+    // This public slot starts draining, unless a retry is already scheduled. Call it whenever
+    // manifests were added to the spool.
+    void wake();
+
+signals:
+    // This signal reports progress and problems for the status bar.
+    void statusMessage(const QString& msg);
+
+private:
+    // This private helper function sends one batch and schedules the next batch or a retry.
+    void drainBatch();
+
+private:
+    PostSpool* m_spool;
+    QTimer* m_timer;       // Fires the next batch, or the next retry while backing off.
+    int m_backoffMs{0};    // The current wait between tries; 0 while the server is answering.
+};
+
+#endif // SPOOLDRAINER_H
@@ -0,0 +1,53 @@
+#include "UnallocatedListModel.h"
+#include "Container.h"
+
+// This function reads the container only for the role the view asks for.
+QVariant UnallocatedListModel::data(const QModelIndex& index, int role) const{
+    if(!index.isValid() || index.row() >= m_items.size())
+        return {};
+    const Container* c = m_items.at(index.row());
+    if(role == Qt::DisplayRole)
+        return c->code();
+    if(role == Qt::ToolTipRole)
+        return QString("%1, weight %2, volume %3").arg(c->typeName()).arg(c->weight()).arg(c->volume());
+    return {};
+}
+
+// This method inserts one row at the end.
+void UnallocatedListModel::append(Container* c){
+    if(!c)
+        return;
+    const int row = int(m_items.size());
+    beginInsertRows(QModelIndex(), row, row);
+    m_items.push_back(c);
+    endInsertRows();
+}
+
+// This method inserts the whole batch as one range of rows.
+void UnallocatedListModel::append(const QVector<Container*>& batch){
+    if(batch.isEmpty())
+        return;
+    const int first = int(m_items.size());
+    beginInsertRows(QModelIndex(), first, first + int(batch.size()) - 1);
+    m_items += batch;
+    endInsertRows();
+}
+
+// This method removes one row.
+Container* UnallocatedListModel::take(int row){
+    if(row < 0 || row >= m_items.size())
+        return nullptr;
+    beginRemoveRows(QModelIndex(), row, row);
+    Container* c = m_items.takeAt(row);
+    endRemoveRows();
+    return c;
+}
+
+// This method resets the model, since every row may have changed.
+QVector<Container*> UnallocatedListModel::replace(const QVector<Container*>& list){
+    beginResetModel();
+    QVector<Container*> old = m_items;
+    m_items = list;
+    endResetModel();
+    return old;
+}
@@ -0,0 +1,44 @@
+#ifndef UNALLOCATEDLISTMODEL_H
+#define UNALLOCATEDLISTMODEL_H
+#include <QAbstractListModel>
+#include <QVector>
+class Container;
+
+// The UnallocatedListModel class is the list of containers not yet assigned to a pallet, in the order
+// they were created. It holds the containers themselves rather than a copy of their codes: data() asks a
+// container for its code only when the view paints that row, and adding or taking containers tells the
+// view exactly which rows changed, so creating N containers costs O(N) and keeps the view's selection.
+// The model does not own the containers; ManageTab does, through their QObject parent.
+class UnallocatedListModel : public QAbstractListModel{
+    Q_OBJECT
+public:
+    // This is the constructor. It initializes an empty list.
+    explicit UnallocatedListModel(QObject* parent=nullptr): QAbstractListModel(parent) {}
+
+    // This override function returns the number of unallocated containers.
+    int rowCount(const QModelIndex& parent=QModelIndex()) const override {
+        return parent.isValid() ? 0 : int(m_items.size());
+    }
+
+    // This override function returns a container's code for display and its details as a tooltip.
+    QVariant data(const QModelIndex& index, int role) const override;
+
+    // This method returns the containers in display order.
+    const QVector<Container*>& containers() const { return m_items; }
+    // This method returns the container shown in a row.
+    Container* at(int row) const { return m_items.at(row); }
+
+    // This method adds a container at the end of the list.
+    void append(Container* c);
+    // This method adds many containers at the end of the list with a single insertion.
+    void append(const QVector<Container*>& batch);
+    // This method removes a container from the list and returns it; the caller takes it over.
+    Container* take(int row);
+    // This method replaces the whole list, for example with a restored backup, and returns the old one.
+    QVector<Container*> replace(const QVector<Container*>& list);
+
+private:
+    QVector<Container*> m_items;
+};
+
+#endif // UNALLOCATEDLISTMODEL_H
@@ -27,6 +27,8 @@
 #include <QTimer>
 #include <QPixmap>
 #include "MainClient.h"
+#include "Trace.h"
+#include "MemoryAccounting.h"
 
 int main(int argc, char* argv[])
 {
@@ -34,6 +36,15 @@ int main(int argc, char* argv[])
     QApplication::setApplicationName("Container Client");
     QApplication::setOrganizationName("UNISA");
 
+    // With CARGO_MEMORY=1 set, counts memory per subsystem; the status bar shows the figures.
+    Memory::enableFromEnvironment();
+
+    // With CARGO_TRACE=<file> set, records trace spans and writes them to that file on exit.
+    const QString tracePath = Trace::enableFromEnvironment("Cargo Tracker client");
+    if(!tracePath.isEmpty()){
+        QObject::connect(&app, &QCoreApplication::aboutToQuit, [tracePath]{ Trace::dump(tracePath, nullptr); });
+    }
+
     // Load the original pixmap from the resource file
     QPixmap originalPixmap(":/images/splash.png");
 
@@ -0,0 +1,92 @@
+#ifndef CODEINDEX_H
+#define CODEINDEX_H
+#include <QVector>
+#include <QtGlobal>
+
+// The CodeIndex class maps packed container codes to slot numbers in ContainerStore.
+// It is an open-addressing hash table with linear probing: entries live in one flat array, so a lookup
+// touches one or two cache lines and never allocates. Code 0 (an invalid code) marks an empty entry,
+// which is why invalid codes can never be indexed. Erasing shifts the following entries back instead
+// of leaving tombstones, so the table never has to be rebuilt to stay fast.
+class CodeIndex{
+public:
+    // The value find() returns when the code is not indexed.
+    static constexpr qsizetype NotFound = -1;
+
+    // This method returns the slot stored for the code, or NotFound.
+    qsizetype find(quint32 code) const{
+        if(m_entries.isEmpty()) return NotFound;
+        for(quint32 i = home(code);; i = (i + 1) & m_mask){
+            const Entry& e = m_entries.at(i);
+            if(e.code == code) return e.slot;
+            if(e.code == 0) return NotFound;
+        }
+    }
+
+    // This method adds a code that is not indexed yet. The code must not be 0.
+    void insert(quint32 code, quint32 slot){
+        // Keeps the table at most three quarters full so probe sequences stay short.
+        if((m_count + 1) * 4 > m_entries.size() * 3) grow();
+        quint32 i = home(code);
+        while(m_entries.at(i).code != 0) i = (i + 1) & m_mask;
+        m_entries[i] = {code, slot};
+        ++m_count;
+    }
+
+    // This method removes a code. Codes that are not indexed are ignored.
+    void erase(quint32 code){
+        if(m_entries.isEmpty()) return;
+        quint32 i = home(code);
+        while(m_entries.at(i).code != code){
+            if(m_entries.at(i).code == 0) return;
+            i = (i + 1) & m_mask;
+        }
+        // Moves back every following entry whose probe sequence passed over the freed entry.
+        for(quint32 j = (i + 1) & m_mask; m_entries.at(j).code != 0; j = (j + 1) & m_mask){
+            const quint32 k = home(m_entries.at(j).code);
+            const bool between = i <= j ? (i < k && k <= j) : (i < k || k <= j);
+            if(between) continue;
+            m_entries[i] = m_entries.at(j);
+            i = j;
+        }
+        m_entries[i] = {};
+        --m_count;
+    }
+
+    // This method returns the number of indexed codes.
+    qsizetype size() const{ return m_count; }
+    // This method returns the bytes the table holds, for the memory accounting.
+    qint64 memoryBytes() const{ return m_entries.capacity() * qint64(sizeof(Entry)); }
+
+private:
+    // One table entry. An entry with code 0 is empty.
+    struct Entry{
+        quint32 code{0};
+        quint32 slot{0};
+    };
+
+    // This helper returns the preferred entry of a code. Packed codes of one month differ mostly in
+    // their middle bits, so they are mixed with a multiplicative hash before masking.
+    quint32 home(quint32 code) const{
+        const quint32 h = code * 0x9E3779B1u;
+        return (h ^ (h >> 15)) & m_mask;
+    }
+
+    // This helper doubles the table and reinserts every entry.
+    void grow(){
+        const QVector<Entry> old = std::move(m_entries);
+        const qsizetype capacity = old.isEmpty() ? 64 : old.size() * 2;
+        m_entries = QVector<Entry>(capacity);
+        m_mask = quint32(capacity - 1);
+        m_count = 0;
+        for(const Entry& e: old){
+            if(e.code != 0) insert(e.code, e.slot);
+        }
+    }
+
+    QVector<Entry> m_entries;   // The table itself; its size is always zero or a power of two.
+    quint32 m_mask{0};          // The table size minus one.
+    qsizetype m_count{0};       // The number of non-empty entries.
+};
+
+#endif // CODEINDEX_H
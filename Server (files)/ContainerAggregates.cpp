@@ -0,0 +1,85 @@
+#include "ContainerAggregates.h"
+#include <QtMath>
+
+namespace {
+
+// This helper reads a numeric field as a number, treating a missing value as zero.
+inline qint64 valueOf(qint32 v){
+    return v == ContainerRecord::NoValue ? 0 : v;
+}
+
+} // namespace
+
+// This method converts the exact sums into one volume.
+double VolumeSum::total() const{
+    return double(box) + M_PI / 4.0 * double(cylinderD2H);
+}
+
+// This method counts an added container.
+void ContainerAggregates::add(const ContainerRecord& r){
+    apply(r, +1);
+}
+
+// This method uncounts a removed container.
+void ContainerAggregates::remove(const ContainerRecord& r){
+    apply(r, -1);
+}
+
+// This helper updates the pallet, type, month and grand totals for one container.
+void ContainerAggregates::apply(const ContainerRecord& r, int sign){
+    const qint64 weight = valueOf(r.weight);
+    VolumeSum volume;
+    if(r.type == ContainerType::Box){
+        volume.box = valueOf(r.length) * valueOf(r.breadth) * valueOf(r.height);
+    } else if(r.type == ContainerType::Cylinder){
+        volume.cylinderD2H = valueOf(r.diameter) * valueOf(r.diameter) * valueOf(r.height);
+    }
+
+    // Re-files the pallet under its new weight so the weight order stays correct.
+    PalletTotals& p = m_pallets[r.pallet];
+    if(p.containers > 0) m_byWeight.erase({p.weight, r.pallet});
+    p.containers += sign;
+    p.weight += sign * weight;
+    p.volume.box += sign * volume.box;
+    p.volume.cylinderD2H += sign * volume.cylinderD2H;
+    if(p.containers > 0) m_byWeight.insert({p.weight, r.pallet});
+    else m_pallets.remove(r.pallet);
+
+    TypeTotals& t = m_types[size_t(r.type)];
+    t.containers += sign;
+    t.volume.box += sign * volume.box;
+    t.volume.cylinderD2H += sign * volume.cylinderD2H;
+
+    // Containers with an invalid code have no month to count them under.
+    if(r.code != 0){
+        m_months[size_t((ContainerCode::year(r.code) - 2000) * 12 + ContainerCode::month(r.code) - 1)] += sign;
+    }
+
+    m_containers += sign;
+    m_weight += sign * weight;
+    ++m_revision;
+}
+
+// This method looks up one month; months outside the range of a packed code have no containers.
+qint64 ContainerAggregates::month(int year, int month) const{
+    const int slot = (year - 2000) * 12 + month - 1;
+    if(month < 1 || month > 12 || slot < 0 || slot >= MonthSlots) return 0;
+    return m_months[size_t(slot)];
+}
+
+// This method builds a display copy. Its cost depends on topCount and the month table, not on the rows.
+AggregateSummary ContainerAggregates::summary(int topCount) const{
+    AggregateSummary s;
+    s.revision = m_revision;
+    s.containers = m_containers;
+    s.pallets = m_pallets.size();
+    s.weight = m_weight;
+    s.types = m_types;
+    for(int i = 0; i < MonthSlots; ++i){
+        if(m_months[size_t(i)] != 0) s.months.push_back({2000 + i / 12, i % 12 + 1, m_months[size_t(i)]});
+    }
+    for(auto it = m_byWeight.crbegin(); it != m_byWeight.crend() && s.heaviest.size() < topCount; ++it){
+        s.heaviest.push_back({it->second, m_pallets.value(it->second)});
+    }
+    return s;
+}
@@ -0,0 +1,91 @@
+#ifndef CONTAINERAGGREGATES_H
+#define CONTAINERAGGREGATES_H
+#include <QHash>
+#include <QPair>
+#include <QVector>
+#include <array>
+#include <set>
+#include <utility>
+#include "ContainerRecord.h"
+
+// The VolumeSum struct adds up container volumes without rounding drift.
+// Box volumes are exact integers; cylinders are summed as diameter squared times height and only
+// multiplied by pi/4 when read, so adding and later removing a container restores the exact total.
+struct VolumeSum{
+    qint64 box{0};
+    qint64 cylinderD2H{0};
+
+    // This method returns the total volume in cubic units of the posted dimensions.
+    double total() const;
+};
+
+// The PalletTotals struct holds the running totals of one pallet.
+struct PalletTotals{
+    qint64 containers{0};
+    qint64 weight{0};
+    VolumeSum volume;
+};
+
+// The TypeTotals struct holds the running totals of one container type.
+struct TypeTotals{
+    qint64 containers{0};
+    VolumeSum volume;
+};
+
+// The MonthCount struct is one row of the containers-per-month breakdown.
+struct MonthCount{
+    int year{0};
+    int month{0};
+    qint64 containers{0};
+};
+
+// The AggregateSummary struct is a small copy of every aggregate, taken for display.
+struct AggregateSummary{
+    quint64 revision{0};                              // Changes whenever any total changes.
+    qint64 containers{0};
+    qint64 pallets{0};
+    qint64 weight{0};
+    std::array<TypeTotals, 3> types;                  // Indexed by ContainerType.
+    QVector<MonthCount> months;                       // Months with at least one container, oldest first.
+    QVector<QPair<qint32, PalletTotals>> heaviest;    // The heaviest pallets, heaviest first.
+};
+
+// The ContainerAggregates class keeps per-pallet, per-type and per-month totals up to date as
+// containers are added to and removed from the store, so a summary never rescans the rows.
+// Pallets are also kept ordered by total weight, which makes the heaviest pallets an O(K) read and
+// each update O(log n). The class is not thread-safe; ContainerStore calls it under its own lock.
+class ContainerAggregates{
+public:
+    // This method counts a container that was added to the store.
+    void add(const ContainerRecord& r);
+    // This method uncounts a container that was removed from the store, or the old version of one
+    // that was updated.
+    void remove(const ContainerRecord& r);
+
+    // This method returns the totals of one pallet (all zero for an unknown pallet).
+    PalletTotals pallet(qint32 pallet) const{ return m_pallets.value(pallet); }
+    // This method returns the totals of one container type.
+    const TypeTotals& type(ContainerType t) const{ return m_types[size_t(t)]; }
+    // This method returns the number of containers whose code is from the given month.
+    qint64 month(int year, int month) const;
+
+    // This method copies every aggregate, including the topCount heaviest pallets.
+    AggregateSummary summary(int topCount) const;
+
+private:
+    // The covered code years (2000-2127, the range of a packed code) times twelve months.
+    static constexpr int MonthSlots = 128 * 12;
+
+    // This helper applies one container to every total; sign is +1 to add and -1 to remove.
+    void apply(const ContainerRecord& r, int sign);
+
+    QHash<qint32, PalletTotals> m_pallets;
+    std::set<std::pair<qint64, qint32>> m_byWeight;   // (total weight, pallet) of every pallet.
+    std::array<TypeTotals, 3> m_types;
+    std::array<qint64, MonthSlots> m_months{};
+    qint64 m_containers{0};
+    qint64 m_weight{0};
+    quint64 m_revision{0};
+};
+
+#endif // CONTAINERAGGREGATES_H
@@ -0,0 +1,159 @@
+#include "ContainerFilter.h"
+#include <QRegularExpression>
+#include <QStringList>
+
+namespace {
+
+// This helper applies a comparison to a column. The loop body is branch-free so it vectorizes;
+// invalid(x) tells which stored values never match (missing numbers, invalid codes).
+template<typename T, typename Invalid>
+void narrowColumn(ContainerFilter::Op op, T value, const T* col, qsizetype n, quint8* mask, Invalid invalid){
+    using Op = ContainerFilter::Op;
+    switch(op){
+    case Op::Less:
+        for(qsizetype i = 0; i < n; ++i) mask[i] &= quint8(!invalid(col[i]) & (col[i] < value));
+        break;
+    case Op::LessEqual:
+        for(qsizetype i = 0; i < n; ++i) mask[i] &= quint8(!invalid(col[i]) & (col[i] <= value));
+        break;
+    case Op::Equal:
+    case Op::Prefix:
+        for(qsizetype i = 0; i < n; ++i) mask[i] &= quint8(!invalid(col[i]) & (col[i] == value));
+        break;
+    case Op::NotEqual:
+        for(qsizetype i = 0; i < n; ++i) mask[i] &= quint8(!invalid(col[i]) & (col[i] != value));
+        break;
+    case Op::GreaterEqual:
+        for(qsizetype i = 0; i < n; ++i) mask[i] &= quint8(!invalid(col[i]) & (col[i] >= value));
+        break;
+    case Op::Greater:
+        for(qsizetype i = 0; i < n; ++i) mask[i] &= quint8(!invalid(col[i]) & (col[i] > value));
+        break;
+    }
+}
+
+// This helper parses a code prefix such as "2026", "2026/10" or "2026/10/B", or a complete code.
+bool parseCodePrefix(const QString& text, ContainerFilter::Condition& c){
+    if(const quint32 full = ContainerCode::pack(text)){
+        c.value = qint32(full);
+        c.mask = 0xFFFFFFFFu;
+        return true;
+    }
+    static const QRegularExpression rx("^(\\d{4})(?:/(\\d{1,2})(?:/([BC]))?)?/?$");
+    const QRegularExpressionMatch m = rx.match(text);
+    if(!m.hasMatch()) return false;
+
+    // Builds the same bit layout as ContainerCode::pack, covering only the given fields.
+    const int year = m.captured(1).toInt();
+    if(year < 2000 || year > 2127) return false;
+    quint32 value = quint32(year - 2000) << 21;
+    quint32 mask = 0x7Fu << 21;
+    if(m.hasCaptured(2)){
+        const int month = m.captured(2).toInt();
+        if(month < 1 || month > 12) return false;
+        value |= quint32(month) << 17;
+        mask |= 0xFu << 17;
+    }
+    if(m.hasCaptured(3)){
+        value |= (m.captured(3) == QLatin1String("C") ? 1u : 0u) << 16;
+        mask |= 1u << 16;
+    }
+    c.value = qint32(value);
+    c.mask = mask;
+    return true;
+}
+
+} // namespace
+
+// This function narrows a mask by a condition on one of the integer columns.
+void ContainerFilter::narrow(const Condition& c, const qint32* column, qsizetype n, quint8* mask){
+    narrowColumn(c.op, c.value, column, n, mask, [](qint32 v){ return v == ContainerRecord::NoValue; });
+}
+
+// This function narrows a mask by a condition on the packed code column.
+void ContainerFilter::narrow(const Condition& c, const quint32* codes, qsizetype n, quint8* mask){
+    if(c.op == Op::Prefix){
+        const quint32 value = quint32(c.value);
+        for(qsizetype i = 0; i < n; ++i){
+            mask[i] &= quint8((codes[i] != 0) & ((codes[i] & c.mask) == value));
+        }
+        return;
+    }
+    narrowColumn(c.op, quint32(c.value), codes, n, mask, [](quint32 v){ return v == 0; });
+}
+
+// This function narrows a mask by a condition on the type column.
+void ContainerFilter::narrow(const Condition& c, const ContainerType* types, qsizetype n, quint8* mask){
+    narrowColumn(c.op, ContainerType(c.value), types, n, mask, [](ContainerType){ return false; });
+}
+
+// This method tests one record by running each condition over a column of length one.
+bool ContainerFilter::matches(const ContainerRecord& r) const{
+    quint8 m = 1;
+    for(const Condition& c: conditions){
+        switch(c.field){
+        case Field::Type:     narrow(c, &r.type, 1, &m); break;
+        case Field::Code:     narrow(c, &r.code, 1, &m); break;
+        case Field::Pallet:   narrow(c, &r.pallet, 1, &m); break;
+        case Field::Height:   narrow(c, &r.height, 1, &m); break;
+        case Field::Weight:   narrow(c, &r.weight, 1, &m); break;
+        case Field::Length:   narrow(c, &r.length, 1, &m); break;
+        case Field::Breadth:  narrow(c, &r.breadth, 1, &m); break;
+        case Field::Diameter: narrow(c, &r.diameter, 1, &m); break;
+        }
+        if(!m) return false;
+    }
+    return true;
+}
+
+// This function turns filter text into conditions.
+bool ContainerFilter::parse(const QString& text, ContainerFilter& out, QString* error){
+    static const QRegularExpression rx("^([A-Za-z]+)\\s*(<=|>=|!=|==|=|<|>)?\\s*(\\S+)$");
+    static const QStringList fieldNames{"pallet","type","code","height","weight","length","breadth","diameter"};
+
+    ContainerFilter result;
+    for(const QString& part: text.split(QLatin1Char(','), Qt::SkipEmptyParts)){
+        const QString term = part.trimmed();
+        if(term.isEmpty()) continue;
+        const QRegularExpressionMatch m = rx.match(term);
+        const int field = m.hasMatch() ? int(fieldNames.indexOf(m.captured(1).toLower())) : -1;
+        if(field < 0){
+            if(error) *error = QString("Cannot understand filter condition \"%1\"").arg(term);
+            return false;
+        }
+
+        Condition c;
+        c.field = Field(field);
+        const QString op = m.captured(2);
+        const QString value = m.captured(3);
+        if(op == "<") c.op = Op::Less;
+        else if(op == "<=") c.op = Op::LessEqual;
+        else if(op == "!=") c.op = Op::NotEqual;
+        else if(op == ">=") c.op = Op::GreaterEqual;
+        else if(op == ">") c.op = Op::Greater;
+        else c.op = Op::Equal;
+
+        bool ok = false;
+        if(c.field == Field::Code){
+            // Codes are matched by prefix; a complete code is simply the longest prefix.
+            ok = (op.isEmpty() || c.op == Op::Equal) && parseCodePrefix(value, c);
+            c.op = Op::Prefix;
+        } else if(c.field == Field::Type){
+            const QString name = value.toLower();
+            ok = op.isEmpty() || c.op == Op::Equal || c.op == Op::NotEqual;
+            if(name == "box") c.value = qint32(ContainerType::Box);
+            else if(name == "cylinder") c.value = qint32(ContainerType::Cylinder);
+            else ok = false;
+        } else {
+            c.value = value.toInt(&ok);
+            ok = ok && !op.isEmpty();
+        }
+        if(!ok){
+            if(error) *error = QString("Invalid filter condition \"%1\"").arg(term);
+            return false;
+        }
+        result.conditions.push_back(c);
+    }
+    out = result;
+    return true;
+}
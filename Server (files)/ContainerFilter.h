@@ -0,0 +1,46 @@
+#ifndef CONTAINERFILTER_H
+#define CONTAINERFILTER_H
+#include <QString>
+#include <QVector>
+#include "ContainerRecord.h"
+
+// The ContainerFilter struct is a list of conditions that a container must all satisfy, such as
+// "weight > 500, code 2026/10/B". Conditions compare the typed values, so numbers compare as numbers
+// and a code prefix is a single masked integer comparison on the packed code.
+// Besides testing one record, a condition can be evaluated over a whole column at once; those loops
+// have no branches and no calls, so the compiler turns them into SIMD code.
+struct ContainerFilter{
+    // The fields a condition can test, in the same order as the server table's columns.
+    enum class Field : quint8 { Pallet, Type, Code, Height, Weight, Length, Breadth, Diameter };
+    // The comparisons. Prefix is only used with Field::Code.
+    enum class Op : quint8 { Less, LessEqual, Equal, NotEqual, GreaterEqual, Greater, Prefix };
+
+    // One condition. For Field::Code with Op::Prefix, a code matches if (code & mask) == value.
+    struct Condition{
+        Field field{Field::Pallet};
+        Op op{Op::Equal};
+        qint32 value{0};
+        quint32 mask{0};
+    };
+
+    QVector<Condition> conditions;
+
+    // This method returns true if the filter accepts every row.
+    bool isEmpty() const{ return conditions.isEmpty(); }
+
+    // This method tests one record against every condition.
+    bool matches(const ContainerRecord& r) const;
+
+    // These functions clear mask[i] for every row of a column that fails the condition.
+    // Missing values (NoValue) and invalid codes never satisfy a condition.
+    static void narrow(const Condition& c, const qint32* column, qsizetype n, quint8* mask);
+    static void narrow(const Condition& c, const quint32* codes, qsizetype n, quint8* mask);
+    static void narrow(const Condition& c, const ContainerType* types, qsizetype n, quint8* mask);
+
+    // This function parses filter text. Conditions are separated by commas and look like
+    // "weight >= 500", "pallet = 3", "type cylinder" or "code 2026/10/B"; a code may be given in full
+    // or as a year, year/month or year/month/type prefix. It returns false and sets error on bad input.
+    static bool parse(const QString& text, ContainerFilter& out, QString* error);
+};
+
+#endif // CONTAINERFILTER_H
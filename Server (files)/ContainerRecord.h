@@ -0,0 +1,45 @@
+#ifndef CONTAINERRECORD_H
+#define CONTAINERRECORD_H
+#include <QString>
+#include <QtGlobal>
+#include <limits>
+#include "ContainerCode.h"
+
+// The ContainerType enum stores the container element name in a single byte.
+enum class ContainerType : quint8 { Box, Cylinder, Unknown };
+
+// The ContainerRecord struct is the typed form of one container row received from a client.
+// Numbers are kept as 32-bit integers and the code is packed, so a row costs a few dozen bytes
+// instead of eight heap-allocated strings.
+struct ContainerRecord{
+    // The value stored in a numeric field that was missing from the manifest (e.g. diameter of a box).
+    static constexpr qint32 NoValue = std::numeric_limits<qint32>::min();
+
+    quint64 key{0};                           // The stable row identity assigned by ContainerStore.
+    qint32 pallet{0};                         // The pallet number the container was posted on.
+    ContainerType type{ContainerType::Unknown};
+    quint32 code{0};                          // The packed container code, or 0 when the code was invalid.
+    qint32 height{NoValue};
+    qint32 weight{NoValue};
+    qint32 length{NoValue};
+    qint32 breadth{NoValue};
+    qint32 diameter{NoValue};
+};
+
+// This helper compares the posted contents of two records, ignoring the store-assigned key.
+inline bool sameContents(const ContainerRecord& a, const ContainerRecord& b){
+    return a.pallet == b.pallet && a.type == b.type && a.code == b.code
+        && a.height == b.height && a.weight == b.weight && a.length == b.length
+        && a.breadth == b.breadth && a.diameter == b.diameter;
+}
+
+// This helper returns the element name used in the XML manifest for a container type.
+inline QString typeName(ContainerType t){
+    switch (t) {
+    case ContainerType::Box:      return QStringLiteral("Box");
+    case ContainerType::Cylinder: return QStringLiteral("Cylinder");
+    default:                      return QStringLiteral("Unknown");
+    }
+}
+
+#endif // CONTAINERRECORD_H
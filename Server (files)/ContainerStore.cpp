@@ -0,0 +1,301 @@
+#include "ContainerStore.h"
+#include <QMap>
+#include <QMutexLocker>
+#include <chrono>
+
+namespace {
+
+// This helper returns a monotonic clock reading in milliseconds, for snapshot ages.
+qint64 nowMs(){
+    using namespace std::chrono;
+    return duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+// The estimated size of one QHash or QMap entry with a small key and value, since neither reports
+// its node sizes, for the memory accounting.
+constexpr qint64 HashEntryBytes = 32;
+
+} // namespace
+
+// This method groups the manifest rows by pallet and replaces the contents of each pallet in turn.
+bool ContainerStore::mergeManifest(const QVector<ContainerRecord>& rows, quint64* logSeq){
+    // Groups the rows before taking the lock. The map keeps pallets in numeric order, so a container
+    // listed on two pallets of the same manifest always ends up on the higher-numbered one.
+    QMap<qint32, QVector<ContainerRecord>> grouped;
+    for(const auto& r: rows){
+        grouped[r.pallet].push_back(r);
+    }
+
+    QVector<StoreChange> changes;
+    bool refused = false;
+    if(logSeq) *logSeq = 0;
+    QMutexLocker locker(&m_lock);
+    for(auto it = grouped.cbegin(); it != grouped.cend(); ++it){
+        const qsizetype before = changes.size();
+        replacePallet(it.key(), it.value(), changes);
+
+        // Logs the pallet while still holding the lock, so replaying the log applies the pallets in
+        // the same order as the store did. A re-post that changed nothing is not logged at all.
+        // A broken log refuses the record; the caller then gets a sequence number that never becomes durable.
+        if(m_log && changes.size() != before){
+            const quint64 seq = m_log->append(it.key(), it.value());
+            refused = refused || seq == 0;
+            if(logSeq) *logSeq = refused ? WriteAheadLog::NeverDurable : seq;
+        }
+    }
+    if(changes.isEmpty()) return false;
+    rebuildBlocks();
+    updateMemory();
+    m_revision.fetch_add(1, std::memory_order_release);
+
+    // Publishes under the same lock, so the batches are queued in the order they were applied.
+    if(m_publish.load(std::memory_order_relaxed)) m_changes.push(std::move(changes));
+    return true;
+}
+
+// This helper upserts the posted containers of one pallet by code and drops the ones no longer listed.
+void ContainerStore::replacePallet(qint32 pallet, const QVector<ContainerRecord>& incoming, QVector<StoreChange>& changes){
+    // The generation marks which slots this call has listed, so no per-call set has to be built.
+    if(++m_generation == 0){
+        m_seen.fill(0);
+        m_generation = 1;
+    }
+    const quint32 generation = m_generation;
+    const qsizetype before = changes.size();
+    const QVector<quint32> previous = m_byPallet.take(pallet);
+
+    // Containers with an invalid code are matched by their order among the invalid codes of the pallet.
+    QVector<quint32> unnamed;
+    for(quint32 slot: previous){
+        if(m_records.at(slot).code == 0) unnamed.push_back(slot);
+    }
+    qsizetype nextUnnamed = 0;
+
+    QVector<quint32> members;
+    members.reserve(incoming.size());
+    for(ContainerRecord r: incoming){
+        r.pallet = pallet;
+        qsizetype slot = CodeIndex::NotFound;
+        if(r.code != 0) slot = m_byCode.find(r.code);
+        else if(nextUnnamed < unnamed.size()) slot = unnamed.at(nextUnnamed++);
+
+        if(slot == CodeIndex::NotFound){
+            const quint32 added = allocateSlot(r);
+            if(r.code != 0) m_byCode.insert(r.code, added);
+            m_seen[added] = generation;
+            members.push_back(added);
+            m_totals.add(m_records.at(added));
+            changes.push_back({m_records.at(added), false});
+            continue;
+        }
+
+        ContainerRecord& stored = m_records[slot];
+        if(m_seen.at(slot) != generation){
+            // A container still listed on another pallet is moved here rather than duplicated.
+            if(stored.pallet != pallet) unlinkFromPallet(stored.pallet, quint32(slot));
+            m_seen[slot] = generation;
+            members.push_back(quint32(slot));
+        }
+        // An unchanged container produces no change at all, which makes re-posting idempotent.
+        if(sameContents(stored, r)) continue;
+        r.key = stored.key;
+        m_totals.remove(stored);
+        m_totals.add(r);
+        stored = r;
+        changes.push_back({stored, false});
+    }
+
+    // Containers that were on this pallet but are not listed any more are removed.
+    for(quint32 slot: previous){
+        if(m_seen.at(slot) == generation) continue;
+        const ContainerRecord& gone = m_records.at(slot);
+        if(gone.code != 0) m_byCode.erase(gone.code);
+        m_totals.remove(gone);
+        changes.push_back({gone, true});
+        m_freeSlots.push_back(slot);
+    }
+
+    if(!members.isEmpty()) m_byPallet.insert(pallet, std::move(members));
+    if(changes.size() != before) m_touched.insert(pallet);
+}
+
+// This helper places a record in a free slot under a fresh key.
+quint32 ContainerStore::allocateSlot(const ContainerRecord& record){
+    quint32 slot;
+    if(!m_freeSlots.isEmpty()){
+        slot = m_freeSlots.takeLast();
+        m_records[slot] = record;
+    } else {
+        slot = quint32(m_records.size());
+        m_records.push_back(record);
+        m_seen.push_back(0);
+    }
+    m_records[slot].key = m_nextKey++;
+    return slot;
+}
+
+// This helper forgets that a slot belongs to a pallet, dropping the pallet once it is empty.
+void ContainerStore::unlinkFromPallet(qint32 pallet, quint32 slot){
+    auto it = m_byPallet.find(pallet);
+    if(it == m_byPallet.end()) return;
+    m_touched.insert(pallet);
+    it->removeOne(slot);
+    if(it->isEmpty()) m_byPallet.erase(it);
+}
+
+// This method replays the log into the store, then attaches it for new changes.
+bool ContainerStore::openLog(const WriteAheadLog::Options& options, QString* error){
+    auto wal = std::make_unique<WriteAheadLog>(options);
+    QVector<StoreChange> discarded;
+    const qint64 replayed = wal->replay([this, &discarded](qint32 pallet, QVector<ContainerRecord>&& rows){
+        // Replayed records are already in the log, so they are not appended a second time.
+        // The intermediate changes are not published either; the final contents are, below.
+        QMutexLocker locker(&m_lock);
+        replacePallet(pallet, rows, discarded);
+        rebuildBlocks();
+        discarded.clear();
+        m_revision.fetch_add(1, std::memory_order_release);
+    }, error);
+    if(replayed < 0) return false;
+    {
+        QMutexLocker locker(&m_lock);
+        updateMemory();
+    }
+
+    if(m_publish.load(std::memory_order_relaxed)){
+        QVector<StoreChange> restored;
+        for(const ContainerRecord& r: snapshot()){
+            restored.push_back({r, false});
+        }
+        if(!restored.isEmpty()) m_changes.push(std::move(restored));
+    }
+
+    if(!wal->open([this]{ return snapshot(); }, error)) return false;
+    QMutexLocker locker(&m_lock);
+    m_log = std::move(wal);
+    return true;
+}
+
+// This method waits for the log writer; the log is attached before any client can post.
+bool ContainerStore::waitDurable(quint64 seq){
+    return !m_log || seq == 0 || m_log->waitDurable(seq);
+}
+
+// This method pops one published batch of changes.
+bool ContainerStore::popChanges(QVector<StoreChange>& out){
+    return m_changes.tryPop(out);
+}
+
+// This method copies every stored record into one vector for display or a log snapshot. Only the list
+// of blocks is taken under the lock; the records are copied after it is released.
+QVector<ContainerRecord> ContainerStore::snapshot() const{
+    QVector<PalletBlock> blocks;
+    {
+        QMutexLocker locker(&m_lock);
+        blocks = blockList();
+    }
+    return concatenate(blocks);
+}
+
+// This helper lists the blocks in numeric pallet order so the table does not jump around between refreshes.
+QVector<ContainerStore::PalletBlock> ContainerStore::blockList() const{
+    QVector<PalletBlock> out;
+    out.reserve(m_blocks.size());
+    for(const PalletBlock& block: m_blocks) out.push_back(block);
+    return out;
+}
+
+// This helper copies the blocks' records one after another.
+QVector<ContainerRecord> ContainerStore::concatenate(const QVector<PalletBlock>& blocks){
+    qsizetype total = 0;
+    for(const PalletBlock& block: blocks) total += block->size();
+    QVector<ContainerRecord> out;
+    out.reserve(total);
+    for(const PalletBlock& block: blocks) out += *block;
+    return out;
+}
+
+// This helper builds a new block for every changed pallet from its slots, and drops the blocks of
+// pallets that were emptied. It costs time proportional to the changed pallets only.
+void ContainerStore::rebuildBlocks(){
+    for(qint32 pallet: m_touched){
+        const auto it = m_byPallet.constFind(pallet);
+        const PalletBlock old = m_blocks.take(pallet);
+        if(old) m_blockRecords -= old->size();
+        if(it == m_byPallet.cend()) continue;
+        auto block = std::make_shared<QVector<ContainerRecord>>();
+        block->reserve(it->size());
+        for(quint32 slot: *it) block->push_back(m_records.at(slot));
+        m_blockRecords += block->size();
+        m_blocks.insert(pallet, std::move(block));
+    }
+    m_touched.clear();
+}
+
+// This helper adds up the reserved storage. The pallet lists hold one slot per stored record and the
+// pallet hashes are estimated per entry; both are small next to the records.
+void ContainerStore::updateMemory(){
+    if(!Memory::enabled()) return;
+    const qint64 records = m_records.size() - m_freeSlots.size();
+    m_memory.set(m_records.capacity() * qint64(sizeof(ContainerRecord))
+                 + (m_seen.capacity() + m_freeSlots.capacity() + records) * qint64(sizeof(quint32))
+                 + m_byCode.memoryBytes()
+                 + (m_byPallet.size() + m_blocks.size()) * HashEntryBytes
+                 + m_blockRecords * qint64(sizeof(ContainerRecord)));
+}
+
+// This method returns the published snapshot, replacing it first if it is both outdated and old.
+std::shared_ptr<const StoreSnapshot> ContainerStore::readSnapshot() const{
+    auto current = std::atomic_load(&m_published);
+    auto fresh = [&]{
+        return current && (current->revision == m_revision.load(std::memory_order_acquire)
+                           || nowMs() - m_publishedAtMs.load(std::memory_order_relaxed) < SnapshotMaxAgeMs);
+    };
+    if(fresh()) return current;
+
+    // Only one reader rebuilds; the others wait here and then use its result.
+    QMutexLocker rebuild(&m_rebuildLock);
+    current = std::atomic_load(&m_published);
+    if(fresh()) return current;
+
+    // Takes the blocks and totals under the store lock, and copies the rows and builds the lookup
+    // tables after releasing it.
+    auto next = std::make_shared<StoreSnapshot>();
+    QVector<PalletBlock> blocks;
+    {
+        QMutexLocker locker(&m_lock);
+        next->revision = m_revision.load(std::memory_order_relaxed);
+        blocks = blockList();
+        next->totals = m_totals.summary(SnapshotHeaviest);
+    }
+    next->rows = concatenate(blocks);
+    for(int i = 0; i < next->rows.size();){
+        int j = i;
+        while(j < next->rows.size() && next->rows.at(j).pallet == next->rows.at(i).pallet) ++j;
+        next->pallets.insert(next->rows.at(i).pallet, {i, j - i});
+        i = j;
+    }
+    for(int i = 0; i < next->rows.size(); ++i){
+        if(next->rows.at(i).code != 0) next->byCode.insert(next->rows.at(i).code, quint32(i));
+    }
+    // The rows are the copy's own; the blocks they came from are counted with the store.
+    next->memory.set(next->rows.capacity() * qint64(sizeof(ContainerRecord)) + next->byCode.memoryBytes()
+                     + next->pallets.size() * HashEntryBytes);
+
+    current = std::move(next);
+    std::atomic_store(&m_published, current);
+    m_publishedAtMs.store(nowMs(), std::memory_order_relaxed);
+    return current;
+}
+
+// This method copies the running totals under the store lock.
+AggregateSummary ContainerStore::summary(int topCount) const{
+    QMutexLocker locker(&m_lock);
+    return m_totals.summary(topCount);
+}
+
+// This method looks up the totals of one pallet under the store lock.
+PalletTotals ContainerStore::palletTotals(qint32 pallet) const{
+    QMutexLocker locker(&m_lock);
+    return m_totals.pallet(pallet);
+}
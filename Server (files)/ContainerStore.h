@@ -0,0 +1,156 @@
+#ifndef CONTAINERSTORE_H
+#define CONTAINERSTORE_H
+#include <QHash>
+#include <QMap>
+#include <QMutex>
+#include <QSet>
+#include <QVector>
+#include <atomic>
+#include <memory>
+#include "CodeIndex.h"
+#include "ContainerAggregates.h"
+#include "ContainerRecord.h"
+#include "LockFreeQueue.h"
+#include "MemoryAccounting.h"
+#include "WriteAheadLog.h"
+
+// The StoreChange struct describes one row that was added, modified or removed by a merge.
+// For removals only record.key is meaningful.
+struct StoreChange{
+    ContainerRecord record;
+    bool removed{false};
+};
+
+// The StoreSnapshot struct is an immutable copy of the store that readers can use without any lock.
+// Rows are ordered by pallet; each pallet's rows are one contiguous range.
+struct StoreSnapshot{
+    quint64 revision{0};                         // The store revision the copy was taken at.
+    QVector<ContainerRecord> rows;
+    QHash<qint32, QPair<int, int>> pallets;      // Pallet number -> first row and row count.
+    CodeIndex byCode;                            // Packed code -> row, for every row with a valid code.
+    AggregateSummary totals;                     // The aggregates, with up to SnapshotHeaviest pallets.
+    Memory::Charge memory{Memory::Domain::StoreSnapshots};  // The copy's size while it is alive.
+};
+
+// The ContainerStore class holds the merged container records received from every connected client.
+// Containers are identified by their code: a re-posted container is updated in place, and a container
+// that shows up on another pallet is moved there instead of being listed twice. Records live in a slot
+// array, found by code through an open-addressing CodeIndex and by pallet through a list of slots per
+// pallet, so replacing the contents of one pallet costs time proportional to that pallet only.
+// Containers with an invalid code cannot be matched by code; they are matched by their position
+// among the invalid codes of the same pallet instead, which keeps re-posting them idempotent too.
+// Every merge also publishes which rows changed on a lock-free queue, so a view on another thread can be
+// updated without a full reload and without ever blocking the merging threads.
+// With a write-ahead log attached, every change is also logged and survives a restart.
+// Queries read published StoreSnapshot copies (read-copy-update): a reader takes a reference to the
+// current copy with an atomic load, and a new copy replaces it only when the store has changed and
+// the current copy is older than SnapshotMaxAgeMs. The records are also kept as one immutable block
+// per pallet, which a merge replaces for the pallets it changed (copy-on-write). Building a copy holds
+// the store lock only to take the list of blocks and the totals, so ingest waits for a few pointer
+// copies per pallet, never for the rows to be copied, however many queries arrive.
+class ContainerStore{
+public:
+    // The age after which a reader replaces an outdated snapshot, in milliseconds.
+    static constexpr int SnapshotMaxAgeMs = 100;
+    // The number of heaviest pallets kept in each snapshot's totals.
+    static constexpr int SnapshotHeaviest = 100;
+
+    // This method replays the log found in the given directory into the store and then logs every
+    // further change there. It returns false (with error set) if the log cannot be read or created.
+    bool openLog(const WriteAheadLog::Options& options, QString* error);
+
+    // This method merges one parsed manifest. Every pallet mentioned in the manifest has its contents
+    // replaced; pallets posted by other clients only lose the containers that moved to one of these
+    // pallets. It returns true if anything changed. If logSeq is given, it receives the log sequence
+    // number to pass to waitDurable() (0 if nothing was logged, WriteAheadLog::NeverDurable if the log
+    // refused a change).
+    bool mergeManifest(const QVector<ContainerRecord>& rows, quint64* logSeq = nullptr);
+
+    // This method blocks until the logged changes up to seq are on disk. Without a log it returns at once.
+    // It returns false if the changes will never be on disk because the log failed.
+    bool waitDurable(quint64 seq);
+
+    // This method returns a copy of all stored records, ordered by pallet number.
+    QVector<ContainerRecord> snapshot() const;
+
+    // This method returns the running totals, including the topCount heaviest pallets.
+    // It never looks at the rows, so a dashboard can call it as often as it likes.
+    AggregateSummary summary(int topCount) const;
+    // This method returns the running totals of one pallet.
+    PalletTotals palletTotals(qint32 pallet) const;
+
+    // This method returns a recent immutable copy of the store. The copy may lag the store by up to
+    // SnapshotMaxAgeMs. It is safe to call from any thread.
+    std::shared_ptr<const StoreSnapshot> readSnapshot() const;
+
+    // This method turns change publication on or off. A store without a viewer (the headless daemon)
+    // turns it off so that unconsumed batches do not pile up in memory.
+    void setPublishChanges(bool on){ m_publish.store(on, std::memory_order_relaxed); }
+
+    // This method takes the oldest published batch of changes. It returns false if none is waiting.
+    // Only one thread (the one updating the view) may call it.
+    bool popChanges(QVector<StoreChange>& out);
+
+private:
+    // The records of one pallet in posted order. A block is never changed once built; a merge replaces
+    // it instead, so snapshots can keep the blocks they took.
+    using PalletBlock = std::shared_ptr<const QVector<ContainerRecord>>;
+
+    // This helper returns every pallet's block in pallet order. It must be called with m_lock held.
+    QVector<PalletBlock> blockList() const;
+    // This helper joins blocks into one vector of records. It needs no lock.
+    static QVector<ContainerRecord> concatenate(const QVector<PalletBlock>& blocks);
+    // This helper rebuilds the blocks of the pallets changed since the last call.
+    // It must be called with m_lock held.
+    void rebuildBlocks();
+    // This helper reports the store's current size to the memory accounting (see MemoryAccounting.h).
+    // It must be called with m_lock held.
+    void updateMemory();
+
+    // This helper replaces the contents of one pallet and appends the resulting changes.
+    // It must be called with m_lock held.
+    void replacePallet(qint32 pallet, const QVector<ContainerRecord>& incoming, QVector<StoreChange>& changes);
+
+    // This helper stores a new record in a free slot and returns the slot number.
+    quint32 allocateSlot(const ContainerRecord& record);
+
+    // This helper removes a slot from the member list of a pallet.
+    void unlinkFromPallet(qint32 pallet, quint32 slot);
+
+private:
+    // Moving a container touches two pallets that may belong to different clients, so one lock guards
+    // the whole store. It is held only for the hash updates; parsing happens before it is taken.
+    mutable QMutex m_lock;
+
+    QVector<ContainerRecord> m_records;          // Record storage indexed by slot number.
+    QVector<quint32> m_freeSlots;                // Slots of removed records, reused before m_records grows.
+    QVector<quint32> m_seen;                     // Per slot, the merge generation that last listed it.
+    quint32 m_generation{0};                     // Incremented by every replacePallet() call.
+    quint64 m_nextKey{1};                        // The next row key; keys are never reused.
+    CodeIndex m_byCode;                          // Packed code -> slot, for every record with a valid code.
+    QHash<qint32, QVector<quint32>> m_byPallet;  // Pallet number -> slots of its containers, in posted order.
+    ContainerAggregates m_totals;                // Totals updated with every added, changed or removed record.
+    QMap<qint32, PalletBlock> m_blocks;          // Pallet number -> its records, for snapshots, in pallet order.
+    QSet<qint32> m_touched;                      // Pallets whose block is out of date.
+    qint64 m_blockRecords{0};                    // The records held by all blocks together.
+    Memory::Charge m_memory{Memory::Domain::Store};
+
+    // Incremented under m_lock by every merge that changed something; read without it by readSnapshot().
+    std::atomic<quint64> m_revision{0};
+
+    // The published snapshot, swapped with std::atomic_load/atomic_store, and when it was built.
+    mutable std::shared_ptr<const StoreSnapshot> m_published;
+    mutable std::atomic<qint64> m_publishedAtMs{0};
+    // Serializes snapshot rebuilds so concurrent readers of a stale copy build only one replacement.
+    mutable QMutex m_rebuildLock;
+
+    // Batches of changes waiting to be collected by popChanges(), one batch per merged manifest.
+    LockFreeQueue<QVector<StoreChange>> m_changes;
+    std::atomic<bool> m_publish{true};
+
+    // The optional write-ahead log. Declared last so it is destroyed (and flushed) while the records
+    // it may still snapshot are alive.
+    std::unique_ptr<WriteAheadLog> m_log;
+};
+
+#endif // CONTAINERSTORE_H
@@ -0,0 +1,417 @@
+#include "ContainerTableModel.h"
+#include <QStringList>
+#include <algorithm>
+#include <functional>
+#include <numeric>
+#include <type_traits>
+#include "Trace.h"
+
+namespace {
+
+// This helper returns the stable ascending order of 32-bit keys using an LSD radix sort: four passes of
+// one byte each, O(n) regardless of the data. Passes in which every key has the same byte are skipped,
+// so columns with a small range (type, pallet) cost one or two passes.
+QVector<int> radixOrder(const QVector<quint32>& keys){
+    const int n = int(keys.size());
+    QVector<int> order(n), scratch(n);
+    std::iota(order.begin(), order.end(), 0);
+
+    // Builds all four byte histograms in a single pass over the keys.
+    QVector<int> counts(4 * 256, 0);
+    for(quint32 k: keys){
+        ++counts[k & 0xFF];
+        ++counts[256 + ((k >> 8) & 0xFF)];
+        ++counts[512 + ((k >> 16) & 0xFF)];
+        ++counts[768 + (k >> 24)];
+    }
+    for(int pass = 0; pass < 4; ++pass){
+        int* count = counts.data() + pass * 256;
+        const int shift = pass * 8;
+        if(n == 0 || count[(keys.at(0) >> shift) & 0xFF] == n) continue;
+
+        // Turns the histogram into starting offsets and scatters the rows, keeping equal keys in order.
+        int sum = 0;
+        for(int b = 0; b < 256; ++b){
+            const int c = count[b];
+            count[b] = sum;
+            sum += c;
+        }
+        for(int row: order){
+            scratch[count[(keys.at(row) >> shift) & 0xFF]++] = row;
+        }
+        order.swap(scratch);
+    }
+    return order;
+}
+
+} // namespace
+
+// This function formats a single cell. It is only called for cells the view is about to paint.
+QVariant ContainerTableModel::data(const QModelIndex& index, int role) const{
+    // Checks for a valid index and a display role.
+    if(!index.isValid() || role!=Qt::DisplayRole) {
+        return {};
+    }
+    const int row = m_visible.at(index.row());
+    switch(index.column()){
+    case Pallet: return QString::number(m_pallet.at(row));
+    case Type:   return typeName(m_type.at(row));
+    case Code:   return ContainerCode::format(m_code.at(row));
+    default: {
+        // Missing values (for example the diameter of a box) are shown as empty cells.
+        const qint32 v = numberColumn(index.column()).at(row);
+        return v == ContainerRecord::NoValue ? QString() : QString::number(v);
+    }
+    }
+}
+
+// This function provides header data for the table's rows and columns.
+QVariant ContainerTableModel::headerData(int section, Qt::Orientation o, int role) const{
+    // Only handles the display role.
+    if(role!=Qt::DisplayRole) {
+        return {};
+    }
+    // If the orientation is horizontal, it provides column headers.
+    if(o==Qt::Horizontal){
+        static const QStringList h{"Pallet","Type","Code","Height","Weight","Length","Breadth","Diameter"};
+        return h.value(section);
+    }
+    // If the orientation is vertical, it provides row numbers.
+    return section+1;
+}
+
+// This helper maps a numeric display column onto its storage vector.
+const QVector<qint32>& ContainerTableModel::numberColumn(int column) const{
+    switch(column){
+    case Pallet:  return m_pallet;
+    case Height:  return m_height;
+    case Weight:  return m_weight;
+    case Length:  return m_length;
+    case Breadth: return m_breadth;
+    default:      return m_diameter;
+    }
+}
+
+// This helper writes one record into the given storage row.
+void ContainerTableModel::store(int row, const ContainerRecord& r){
+    m_key[row] = r.key;
+    m_pallet[row] = r.pallet;
+    m_type[row] = r.type;
+    m_code[row] = r.code;
+    m_height[row] = r.height;
+    m_weight[row] = r.weight;
+    m_length[row] = r.length;
+    m_breadth[row] = r.breadth;
+    m_diameter[row] = r.diameter;
+}
+
+// This helper finds a storage row in the ascending list of visible rows.
+int ContainerTableModel::viewRowOf(int row) const{
+    const auto it = std::lower_bound(m_visible.cbegin(), m_visible.cend(), row);
+    return (it != m_visible.cend() && *it == row) ? int(it - m_visible.cbegin()) : -1;
+}
+
+// This helper inserts a storage row into the view at its sorted position.
+void ContainerTableModel::showRow(int row){
+    const int pos = int(std::lower_bound(m_visible.cbegin(), m_visible.cend(), row) - m_visible.cbegin());
+    // Rows landing below the fetched range are picked up by a later fetchMore().
+    if(pos >= m_fetched){
+        m_visible.insert(pos, row);
+        return;
+    }
+    beginInsertRows(QModelIndex(), pos, pos);
+    m_visible.insert(pos, row);
+    ++m_fetched;
+    endInsertRows();
+}
+
+// This helper removes a storage row from the view; the row itself stays stored.
+void ContainerTableModel::hideRow(int row){
+    const int pos = viewRowOf(row);
+    if(pos < 0) return;
+    if(pos >= m_fetched){
+        m_visible.remove(pos);
+        return;
+    }
+    beginRemoveRows(QModelIndex(), pos, pos);
+    m_visible.remove(pos);
+    --m_fetched;
+    endRemoveRows();
+}
+
+// This helper evaluates the filter one condition at a time over whole columns.
+QVector<int> ContainerTableModel::matchingRows() const{
+    const int n = totalRows();
+    QVector<int> rows;
+    if(m_filter.isEmpty()){
+        rows.resize(n);
+        std::iota(rows.begin(), rows.end(), 0);
+        return rows;
+    }
+
+    // Filter fields are numbered like the table columns, so numberColumn() can serve both.
+    static_assert(int(ContainerFilter::Field::Diameter) == Diameter, "filter fields must follow the columns");
+
+    // Each condition clears the mask entries of the rows it rejects, in one tight loop per column.
+    QVector<quint8> mask(n, 1);
+    for(const ContainerFilter::Condition& c: m_filter.conditions){
+        using Field = ContainerFilter::Field;
+        switch(c.field){
+        case Field::Type: ContainerFilter::narrow(c, m_type.constData(), n, mask.data()); break;
+        case Field::Code: ContainerFilter::narrow(c, m_code.constData(), n, mask.data()); break;
+        default:          ContainerFilter::narrow(c, numberColumn(int(c.field)).constData(), n, mask.data()); break;
+        }
+    }
+    for(int i = 0; i < n; ++i){
+        if(mask[i]) rows.push_back(i);
+    }
+    return rows;
+}
+
+// This method replaces the filter and shows the first page of the rows that pass it.
+void ContainerTableModel::setFilter(const ContainerFilter& filter){
+    TRACE_SPAN("setFilter");
+    beginResetModel();
+    m_filter = filter;
+    m_visible = matchingRows();
+    m_fetched = qMin(PageSize, visibleRows());
+    endResetModel();
+    updateMemory();
+}
+
+// This method applies a batch of new or modified records.
+void ContainerTableModel::upsertRows(const QVector<ContainerRecord>& rows){
+    if(rows.isEmpty()) return;
+    TRACE_SPAN("upsertRows");
+    QVector<int> touched;
+    QVector<ContainerRecord> added;
+
+    for(const ContainerRecord& r: rows){
+        const auto it = m_rowOf.constFind(r.key);
+        if(it == m_rowOf.cend()){
+            added.push_back(r);
+            continue;
+        }
+        // Known keys are overwritten in place; their storage row does not move. A changed row may
+        // start or stop passing the filter, which adds it to or takes it out of the view.
+        const int row = it.value();
+        const bool wasShown = viewRowOf(row) >= 0;
+        const bool nowShown = m_filter.isEmpty() || m_filter.matches(r);
+        store(row, r);
+        if(wasShown && nowShown) touched.push_back(row);
+        else if(wasShown) hideRow(row);
+        else if(nowShown) showRow(row);
+    }
+
+    // Announces modified rows as contiguous blocks of view rows so the view repaints only those cells.
+    // Storage rows are converted only now, after every show and hide above has settled the view; a key
+    // repeated in the batch may have been hidden after it was touched, and is dropped here.
+    for(int& row: touched) row = viewRowOf(row);
+    touched.erase(std::remove(touched.begin(), touched.end(), -1), touched.end());
+    std::sort(touched.begin(), touched.end());
+    touched.erase(std::unique(touched.begin(), touched.end()), touched.end());
+    for(int i = 0; i < touched.size();){
+        int j = i;
+        while(j + 1 < touched.size() && touched[j + 1] == touched[j] + 1) ++j;
+        emitRowsChanged(touched[i], touched[j]);
+        i = j + 1;
+    }
+
+    // New keys are appended to every column, and to the view if they pass the filter.
+    const int oldVisible = visibleRows();
+    for(const ContainerRecord& r: added){
+        const int row = totalRows();
+        m_rowOf.insert(r.key, row);
+        m_key.push_back(r.key);
+        m_pallet.push_back(r.pallet);
+        m_type.push_back(r.type);
+        m_code.push_back(r.code);
+        m_height.push_back(r.height);
+        m_weight.push_back(r.weight);
+        m_length.push_back(r.length);
+        m_breadth.push_back(r.breadth);
+        m_diameter.push_back(r.diameter);
+        if(m_filter.isEmpty() || m_filter.matches(r)) m_visible.push_back(row);
+    }
+
+    // If the view already shows the last row, the first page of new rows is shown straight away.
+    // Otherwise the new rows wait until the view scrolls down and calls fetchMore().
+    if(m_fetched == oldVisible && visibleRows() > oldVisible){
+        const int n = qMin(PageSize, visibleRows() - oldVisible);
+        beginInsertRows(QModelIndex(), m_fetched, m_fetched + n - 1);
+        m_fetched += n;
+        endInsertRows();
+    }
+    updateMemory();
+}
+
+// This method removes rows by key, one contiguous block at a time.
+void ContainerTableModel::removeKeys(const QVector<quint64>& keys){
+    TRACE_SPAN("removeKeys");
+    QVector<int> rows;
+    rows.reserve(keys.size());
+    for(quint64 k: keys){
+        const auto it = m_rowOf.constFind(k);
+        if(it != m_rowOf.cend()) rows.push_back(it.value());
+    }
+    if(rows.isEmpty()) return;
+
+    // Works from the bottom up so that earlier row numbers stay valid while blocks are erased.
+    std::sort(rows.begin(), rows.end(), std::greater<int>());
+    rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+    for(int i = 0; i < rows.size();){
+        int j = i;
+        while(j + 1 < rows.size() && rows[j + 1] == rows[j] - 1) ++j;
+        const int first = rows[j];
+        const int count = rows[i] - first + 1;
+
+        // The visible rows of the block form one contiguous range of view rows, and only the part
+        // of that range the view has fetched needs to be announced.
+        const int a = int(std::lower_bound(m_visible.cbegin(), m_visible.cend(), first) - m_visible.cbegin());
+        const int b = int(std::lower_bound(m_visible.cbegin(), m_visible.cend(), first + count) - m_visible.cbegin());
+        const int visible = qBound(0, m_fetched - a, b - a);
+        if(visible > 0) beginRemoveRows(QModelIndex(), a, a + visible - 1);
+        for(int r = first; r < first + count; ++r) m_rowOf.remove(m_key.at(r));
+        for(auto* col: {&m_pallet, &m_height, &m_weight, &m_length, &m_breadth, &m_diameter}){
+            col->remove(first, count);
+        }
+        m_key.remove(first, count);
+        m_type.remove(first, count);
+        m_code.remove(first, count);
+        // Storage rows after the block have moved up by count.
+        m_visible.remove(a, b - a);
+        for(int v = a; v < m_visible.size(); ++v) m_visible[v] -= count;
+        if(visible > 0){
+            m_fetched -= visible;
+            endRemoveRows();
+        }
+        i = j + 1;
+    }
+    reindexFrom(rows.last());
+    updateMemory();
+}
+
+// This helper emits dataChanged for the fetched part of a block of rows.
+void ContainerTableModel::emitRowsChanged(int first, int last){
+    last = qMin(last, m_fetched - 1);
+    if(first > last) return;
+    emit dataChanged(index(first, 0), index(last, ColumnCount - 1), {Qt::DisplayRole});
+}
+
+// This helper refreshes the key-to-row lookup after rows have moved.
+void ContainerTableModel::reindexFrom(int row){
+    for(int i = row; i < totalRows(); ++i){
+        m_rowOf.insert(m_key.at(i), i);
+    }
+}
+
+// This function reports whether stored rows remain that the view has not fetched.
+bool ContainerTableModel::canFetchMore(const QModelIndex& parent) const{
+    return !parent.isValid() && m_fetched < visibleRows();
+}
+
+// This function exposes the next page of stored rows to the view.
+void ContainerTableModel::fetchMore(const QModelIndex& parent){
+    if(parent.isValid()) return;
+    const int n = qMin(PageSize, visibleRows() - m_fetched);
+    if(n <= 0) return;
+    beginInsertRows(QModelIndex(), m_fetched, m_fetched + n - 1);
+    m_fetched += n;
+    endInsertRows();
+}
+
+// This helper returns the row order that sorts the typed column, without moving any data.
+QVector<int> ContainerTableModel::sortedOrder(int column, Qt::SortOrder order) const{
+    // Precomputes one unsigned key per row whose integer order is the column's order: signed numbers
+    // get their sign bit flipped and a descending sort inverts every key. The radix sort is stable,
+    // so equal values keep their current relative order either way.
+    const int n = totalRows();
+    QVector<quint32> keys(n);
+    if(column == Type){
+        for(int i = 0; i < n; ++i) keys[i] = quint32(m_type.at(i));
+    } else if(column == Code){
+        for(int i = 0; i < n; ++i) keys[i] = m_code.at(i);
+    } else {
+        const qint32* values = numberColumn(column).constData();
+        for(int i = 0; i < n; ++i) keys[i] = quint32(values[i]) ^ 0x80000000u;
+    }
+    if(order == Qt::DescendingOrder){
+        for(quint32& k: keys) k = ~k;
+    }
+    return radixOrder(keys);
+}
+
+// This method sorts the rows and moves persistent indexes (such as the selection) along with them.
+void ContainerTableModel::sort(int column, Qt::SortOrder order){
+    if(column < 0 || column >= ColumnCount) return;
+    TRACE_SPAN("sort");
+    m_sortColumn = column;
+    m_sortOrder = order;
+
+    const QVector<int> perm = sortedOrder(column, order);
+
+    emit layoutAboutToBeChanged({}, QAbstractItemModel::VerticalSortHint);
+
+    QVector<int> newRowOf(perm.size());
+    for(int i = 0; i < perm.size(); ++i) newRowOf[perm[i]] = i;
+
+    // The same rows stay visible, listed again in ascending order of their new storage rows.
+    QVector<quint8> shown(perm.size(), 0);
+    for(int row: m_visible) shown[row] = 1;
+    QVector<int> visible;
+    visible.reserve(m_visible.size());
+    for(int i = 0; i < perm.size(); ++i){
+        if(shown[perm[i]]) visible.push_back(i);
+    }
+
+    const QModelIndexList from = persistentIndexList();
+    QModelIndexList to;
+    to.reserve(from.size());
+    for(const QModelIndex& idx: from){
+        // Rows sorted past the fetched range are no longer visible, so their indexes become invalid.
+        const int row = newRowOf.value(m_visible.value(idx.row()));
+        const int viewRow = int(std::lower_bound(visible.cbegin(), visible.cend(), row) - visible.cbegin());
+        to.push_back(viewRow < m_fetched ? index(viewRow, idx.column()) : QModelIndex());
+    }
+    applyPermutation(perm);
+    m_visible.swap(visible);
+    reindexFrom(0);
+    changePersistentIndexList(from, to);
+
+    emit layoutChanged({}, QAbstractItemModel::VerticalSortHint);
+    updateMemory();
+}
+
+// This helper gathers every column through the permutation.
+void ContainerTableModel::applyPermutation(const QVector<int>& perm){
+    auto gather = [&](auto& col){
+        std::remove_reference_t<decltype(col)> out(col.size());
+        for(int i = 0; i < perm.size(); ++i) out[i] = col[perm[i]];
+        col.swap(out);
+    };
+    gather(m_key);
+    gather(m_pallet);
+    gather(m_type);
+    gather(m_code);
+    gather(m_height);
+    gather(m_weight);
+    gather(m_length);
+    gather(m_breadth);
+    gather(m_diameter);
+}
+
+// This helper adds up the reserved capacity of every column. The key lookup is estimated per entry,
+// since QHash does not report its node and bucket sizes.
+void ContainerTableModel::updateMemory(){
+    if(!Memory::enabled()) return;
+    constexpr qint64 HashEntryBytes = 24;
+    qint64 bytes = m_key.capacity() * qint64(sizeof(quint64))
+                 + m_type.capacity() * qint64(sizeof(ContainerType))
+                 + m_code.capacity() * qint64(sizeof(quint32))
+                 + m_visible.capacity() * qint64(sizeof(int))
+                 + m_rowOf.capacity() * HashEntryBytes;
+    for(const auto* col: {&m_pallet, &m_height, &m_weight, &m_length, &m_breadth, &m_diameter}){
+        bytes += col->capacity() * qint64(sizeof(qint32));
+    }
+    m_memory.set(bytes);
+}
@@ -1,65 +1,123 @@
 #ifndef CONTAINERTABLEMODEL_H
 #define CONTAINERTABLEMODEL_H
 #include <QAbstractTableModel>
+#include <QHash>
 #include <QVector>
+#include "ContainerFilter.h"
+#include "ContainerRecord.h"
+#include "MemoryAccounting.h"
 
 // This class is a custom data model for displaying container information in a table view.
 // It inherits from QAbstractTableModel, which provides a flexible framework for data representation.
+// The data is kept column by column in typed vectors; text is only produced in data() for the cells
+// the view actually asks for. Rows are added and updated incrementally and exposed to the view one
+// page at a time through canFetchMore()/fetchMore().
+// Sorting and filtering happen inside the model on the typed columns rather than in a
+// QSortFilterProxyModel comparing QVariants: sort() radix-sorts integer keys and a ContainerFilter is
+// evaluated over whole columns at once. The view sees the stored rows through m_visible, the list of
+// storage rows that pass the filter.
 class ContainerTableModel : public QAbstractTableModel{
     Q_OBJECT
 public:
+    // The columns of the table, in display order.
+    enum Column { Pallet, Type, Code, Height, Weight, Length, Breadth, Diameter, ColumnCount };
+
+    // The number of rows handed to the view by each fetchMore() call.
+    static constexpr int PageSize = 4096;
+
     // This is the constructor. It initializes the model with an optional parent QObject.
     explicit ContainerTableModel(QObject* parent=nullptr): QAbstractTableModel(parent) {}
 
-    // This override function returns the number of rows in the table.
+    // This override function returns the number of rows the view has fetched so far.
     int rowCount(const QModelIndex& parent=QModelIndex()) const override {
-        Q_UNUSED(parent);
-        return m_rows.size();
+        return parent.isValid() ? 0 : m_fetched;
     }
 
     // This override function returns the number of columns in the table.
     int columnCount(const QModelIndex& parent=QModelIndex()) const override {
-        Q_UNUSED(parent);
-        return 8; // The table has a fixed number of 8 columns.
+        return parent.isValid() ? 0 : ColumnCount;
     }
 
     // This override function provides data for a given index and role.
-    QVariant data(const QModelIndex& index, int role) const override{
-        // Checks for a valid index and a display role.
-        if(!index.isValid() || role!=Qt::DisplayRole) {
-            return {};
-        }
-        // Returns the data from the internal vector at the specified row and column.
-        return m_rows.at(index.row()).at(index.column());
-    }
+    QVariant data(const QModelIndex& index, int role) const override;
 
     // This override function provides header data for the table's rows and columns.
-    QVariant headerData(int section, Qt::Orientation o, int role) const override{
-        // Only handles the display role.
-        if(role!=Qt::DisplayRole) {
-            return {};
-        }
-        // If the orientation is horizontal, it provides column headers.
-        if(o==Qt::Horizontal){
-            static const QStringList h{"Pallet","Type","Code","Height","Weight","Length","Breadth","Diameter"};
-            return h.value(section);
-        }
-        // If the orientation is vertical, it provides row numbers.
-        return section+1;
-    }
+    QVariant headerData(int section, Qt::Orientation o, int role) const override;
+
+    // This override function sorts the rows by one column using the typed values, not their text.
+    void sort(int column, Qt::SortOrder order = Qt::AscendingOrder) override;
+
+    // These override functions let the view page through rows that are stored but not yet shown.
+    bool canFetchMore(const QModelIndex& parent) const override;
+    void fetchMore(const QModelIndex& parent) override;
+
+    // This method returns the number of stored rows, including those hidden by the filter.
+    int totalRows() const { return int(m_key.size()); }
+    // This method returns the number of rows that pass the filter, including those not fetched yet.
+    int visibleRows() const { return int(m_visible.size()); }
+
+    // This method shows only the rows accepted by the filter. An empty filter shows every row.
+    void setFilter(const ContainerFilter& filter);
+    // This method returns the filter in effect.
+    const ContainerFilter& filter() const { return m_filter; }
+
+    // This method inserts records with new keys at the end and overwrites records whose key is known.
+    // Only the affected ranges are announced to the view.
+    void upsertRows(const QVector<ContainerRecord>& rows);
+
+    // This method removes the rows with the given keys. Unknown keys are ignored.
+    void removeKeys(const QVector<quint64>& keys);
+
+private:
+    // This helper returns the integer column backing a numeric display column.
+    const QVector<qint32>& numberColumn(int column) const;
+    // This helper writes one record into the given storage row.
+    void store(int row, const ContainerRecord& r);
+    // This helper announces a block of changed view rows, clipped to what the view has fetched.
+    void emitRowsChanged(int first, int last);
+    // This helper rebuilds the key-to-row lookup from the given row onwards.
+    void reindexFrom(int row);
+    // This helper returns the view row showing a storage row, or -1 if the filter hides it.
+    int viewRowOf(int row) const;
+    // These helpers add a storage row to the view or take it out after its contents changed.
+    void showRow(int row);
+    void hideRow(int row);
+    // This helper runs the filter over every column and returns the storage rows that pass.
+    QVector<int> matchingRows() const;
+    // This helper returns the row order that sorts the given column.
+    QVector<int> sortedOrder(int column, Qt::SortOrder order) const;
+    // This helper reorders every column so that new row i holds old row perm[i].
+    void applyPermutation(const QVector<int>& perm);
+    // This helper reports the storage's current size to the memory accounting (see MemoryAccounting.h).
+    void updateMemory();
 
-    // This method sets the data for the model and notifies views of the change.
-    void setRows(const QVector<QVector<QString>>& rows){
-        // Signals the start of a model reset.
-        beginResetModel();
-        // Replaces the internal data with the new rows.
-        m_rows=rows;
-        // Signals the end of the model reset.
-        endResetModel();
-    }
 private:
-    // A private member variable to store the table data as a vector of string vectors.
-    QVector<QVector<QString>> m_rows;
+    // Column storage. Every vector has one entry per stored row.
+    QVector<quint64> m_key;      // The store-assigned identity of each row.
+    QVector<qint32> m_pallet;
+    QVector<ContainerType> m_type;
+    QVector<quint32> m_code;     // Packed codes; see ContainerCode.
+    QVector<qint32> m_height;
+    QVector<qint32> m_weight;
+    QVector<qint32> m_length;
+    QVector<qint32> m_breadth;
+    QVector<qint32> m_diameter;
+
+    // The storage row of every key, used to find the row an upsert or removal refers to.
+    QHash<quint64, int> m_rowOf;
+    // The storage row shown at each view row, in ascending order. Without a filter it lists every row.
+    QVector<int> m_visible;
+    // The number of view rows exposed to the view. Rows beyond this pass the filter but are not yet fetched.
+    int m_fetched{0};
+    // The filter in effect.
+    ContainerFilter m_filter;
+
+    // The last requested sort. -1 means unsorted. New rows are appended below the sorted block.
+    int m_sortColumn{-1};
+    Qt::SortOrder m_sortOrder{Qt::AscendingOrder};
+
+    // The bytes the columns, the key lookup and the visible list hold, counted as model rows.
+    Memory::Charge m_memory{Memory::Domain::ModelRows};
 };
 
 #endif // CONTAINERTABLEMODEL_H
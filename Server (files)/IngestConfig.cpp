@@ -0,0 +1,89 @@
+#include "IngestConfig.h"
+#include <QCommandLineParser>
+
+// This function declares every option understood by the ingest core.
+void IngestConfig::addOptions(QCommandLineParser& parser){
+    parser.addOption({{"a", "address"}, "Interface to listen on (default 127.0.0.1).", "address"});
+    parser.addOption({{"p", "port"}, "TCP port to listen on (default 6164).", "port"});
+    parser.addOption({"query-port", "TCP port answering queries (default 6165, 0 to disable).", "port"});
+    parser.addOption({"metrics-port", "TCP port serving ingest metrics as plain text (default 6166, 0 to disable).", "port"});
+    parser.addOption({"local-name", "Local socket name for same-host clients (default cargo-tracker-manifests-<port>, \"\" to disable).", "name"});
+    parser.addOption({"parser-threads", "Number of parser threads (default: one per core).", "count"});
+    parser.addOption({"io-threads", "Number of threads serving client connections (default: one per core, at most 4).", "count"});
+    parser.addOption({"data-dir", "Directory for the write-ahead log; accepted pallets survive a restart.", "dir"});
+    parser.addOption({"max-upload-mb", "Largest manifest accepted as a chunked upload, in MB (default 1024).", "mb"});
+}
+
+// This function converts the parsed option values into a configuration.
+bool IngestConfig::fromParser(const QCommandLineParser& parser, IngestConfig& out, QString* error){
+    if(parser.isSet("address")){
+        const QString text = parser.value("address");
+        // Accepts the usual shorthands as well as literal addresses.
+        if(text == "any") out.address = QHostAddress::Any;
+        else if(text == "localhost") out.address = QHostAddress::LocalHost;
+        else if(!out.address.setAddress(text)){
+            if(error) *error = QString("Invalid listen address: %1").arg(text);
+            return false;
+        }
+    }
+    if(parser.isSet("port")){
+        bool ok = false;
+        const uint port = parser.value("port").toUInt(&ok);
+        if(!ok || port == 0 || port > 65535){
+            if(error) *error = QString("Invalid port: %1").arg(parser.value("port"));
+            return false;
+        }
+        out.port = quint16(port);
+    }
+    if(parser.isSet("query-port")){
+        bool ok = false;
+        const uint port = parser.value("query-port").toUInt(&ok);
+        if(!ok || port > 65535){
+            if(error) *error = QString("Invalid query port: %1").arg(parser.value("query-port"));
+            return false;
+        }
+        out.queryPort = quint16(port);
+    }
+    if(parser.isSet("metrics-port")){
+        bool ok = false;
+        const uint port = parser.value("metrics-port").toUInt(&ok);
+        if(!ok || port > 65535){
+            if(error) *error = QString("Invalid metrics port: %1").arg(parser.value("metrics-port"));
+            return false;
+        }
+        out.metricsPort = quint16(port);
+    }
+    // The local socket follows the manifest port unless it is named explicitly.
+    out.localName = parser.isSet("local-name") ? parser.value("local-name") : Wire::localName(out.port);
+    if(parser.isSet("parser-threads")){
+        bool ok = false;
+        const int n = parser.value("parser-threads").toInt(&ok);
+        if(!ok || n < 1){
+            if(error) *error = QString("Invalid parser thread count: %1").arg(parser.value("parser-threads"));
+            return false;
+        }
+        out.parserThreads = n;
+    }
+    if(parser.isSet("io-threads")){
+        bool ok = false;
+        const int n = parser.value("io-threads").toInt(&ok);
+        if(!ok || n < 1){
+            if(error) *error = QString("Invalid I/O thread count: %1").arg(parser.value("io-threads"));
+            return false;
+        }
+        out.ioThreads = n;
+    }
+    if(parser.isSet("data-dir")){
+        out.dataDir = parser.value("data-dir");
+    }
+    if(parser.isSet("max-upload-mb")){
+        bool ok = false;
+        const qint64 mb = parser.value("max-upload-mb").toLongLong(&ok);
+        if(!ok || mb < 1 || mb > 1024 * 1024){
+            if(error) *error = QString("Invalid upload limit: %1").arg(parser.value("max-upload-mb"));
+            return false;
+        }
+        out.maxUploadBytes = mb * 1024 * 1024;
+    }
+    return true;
+}
@@ -0,0 +1,28 @@
+#ifndef INGESTCONFIG_H
+#define INGESTCONFIG_H
+#include <QHostAddress>
+#include <QString>
+#include "WireProtocol.h"
+
+class QCommandLineParser;
+
+// The IngestConfig struct collects the settings of the ingest core.
+// Both the windowed server and the headless daemon fill it from the same command-line options.
+struct IngestConfig{
+    QHostAddress address{QHostAddress::LocalHost};   // The interface to listen on.
+    quint16 port{6164};                              // The TCP port clients post manifests to.
+    quint16 queryPort{6165};                         // The TCP port clients query the store on; 0 disables queries.
+    quint16 metricsPort{6166};                       // The TCP port serving metrics as plain text; 0 disables it.
+    QString localName{Wire::localName(6164)};        // The local socket same-host clients post to; empty disables it.
+    int parserThreads{0};                            // The size of the parser pool; 0 means one per core.
+    int ioThreads{0};                                // The threads connections are spread over; 0 means one per core, at most 4.
+    QString dataDir;                                 // Where the write-ahead log is kept; empty keeps nothing on disk.
+    qint64 maxUploadBytes{qint64(1) << 30};          // The largest manifest accepted as a chunked upload.
+
+    // This function registers the ingest options on a command-line parser.
+    static void addOptions(QCommandLineParser& parser);
+    // This function reads the options back. It returns false and sets error if a value is invalid.
+    static bool fromParser(const QCommandLineParser& parser, IngestConfig& out, QString* error);
+};
+
+#endif // INGESTCONFIG_H
@@ -0,0 +1,9 @@
+#ifndef INGESTLOG_H
+#define INGESTLOG_H
+#include <QLoggingCategory>
+
+// The logging category used by the ingest core. Messages can be filtered with QT_LOGGING_RULES,
+// e.g. QT_LOGGING_RULES="cargo.ingest.info=false".
+Q_DECLARE_LOGGING_CATEGORY(lcIngest)
+
+#endif // INGESTLOG_H
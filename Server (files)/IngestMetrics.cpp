@@ -0,0 +1,170 @@
+#include "IngestMetrics.h"
+#include <QtAlgorithms>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// This helper formats microseconds as milliseconds for the log.
+QString millis(qint64 us) {
+    return QString::number(us / 1000.0, 'f', us < 10000 ? 2 : 1);
+}
+
+// This helper writes one counter or gauge with its help and type lines.
+void writeMetric(QByteArray& out, const char* name, const char* type, const char* help, qint64 value) {
+    out += QByteArray("# HELP ") + name + ' ' + help + "\n# TYPE " + name + ' ' + type + '\n';
+    out += QByteArray(name) + ' ' + QByteArray::number(value) + '\n';
+}
+
+// This helper writes a latency histogram as a summary in seconds, with its maximum as a gauge.
+void writeSummary(QByteArray& out, const char* name, const char* help, const HistogramSnapshot& h) {
+    out += QByteArray("# HELP ") + name + ' ' + help + "\n# TYPE " + name + " summary\n";
+    for (const double q : {0.5, 0.9, 0.99, 0.999}) {
+        out += QByteArray(name) + "{quantile=\"" + QByteArray::number(q) + "\"} "
+               + QByteArray::number(h.percentile(q) / 1e6, 'g', 6) + '\n';
+    }
+    out += QByteArray(name) + "_sum " + QByteArray::number(h.sum / 1e6, 'g', 9) + '\n';
+    out += QByteArray(name) + "_count " + QByteArray::number(h.count) + '\n';
+    out += QByteArray("# TYPE ") + name + "_max gauge\n";
+    out += QByteArray(name) + "_max " + QByteArray::number(h.max / 1e6, 'g', 6) + '\n';
+}
+
+} // namespace
+
+// This method walks the buckets until the wanted share of values is covered. The result is the upper
+// edge of that bucket, but never more than the largest value seen.
+qint64 HistogramSnapshot::percentile(double fraction) const {
+    if (count <= 0) return 0;
+    const qint64 rank = qBound<qint64>(1, qint64(std::ceil(fraction * double(count))), count);
+    qint64 seen = 0;
+    for (size_t i = 0; i < counts.size(); ++i) {
+        seen += counts[i];
+        if (seen >= rank) return std::min(qint64(LatencyHistogram::bucketHigh(int(i))), max);
+    }
+    return max;
+}
+
+// This method subtracts the buckets of an earlier snapshot.
+HistogramSnapshot HistogramSnapshot::since(const HistogramSnapshot& earlier) const {
+    HistogramSnapshot d;
+    d.counts = counts;
+    for (size_t i = 0; i < d.counts.size() && i < earlier.counts.size(); ++i) {
+        d.counts[i] -= earlier.counts[i];
+        if (d.counts[i] > 0) d.max = std::min(qint64(LatencyHistogram::bucketHigh(int(i))), max);
+    }
+    d.count = count - earlier.count;
+    d.sum = sum - earlier.sum;
+    return d;
+}
+
+// This function maps a value to its bucket. Values below SubBuckets have a bucket each; above that,
+// the highest set bit picks the power of two and the next SubBucketBits bits the part of it.
+int LatencyHistogram::bucketOf(quint64 value) {
+    if (value < quint64(SubBuckets)) return int(value);
+    const int msb = 63 - int(qCountLeadingZeroBits(value));
+    if (msb >= MaxBits) return BucketCount - 1;
+    const int shift = msb - SubBucketBits;
+    return (shift + 1) * SubBuckets + int(value >> shift) - SubBuckets;
+}
+
+// This function returns the upper edge of a bucket, the inverse of bucketOf().
+quint64 LatencyHistogram::bucketHigh(int bucket) {
+    const int group = bucket / SubBuckets;
+    const quint64 sub = quint64(bucket % SubBuckets);
+    if (group == 0) return sub;
+    const int shift = group - 1;
+    return ((quint64(SubBuckets) + sub + 1) << shift) - 1;
+}
+
+// This method counts one value. The maximum is raised with a compare-and-swap loop, which only loops
+// while another thread is raising it at the same time.
+void LatencyHistogram::record(qint64 us) {
+    const qint64 v = std::max<qint64>(0, us);
+    m_counts[size_t(bucketOf(quint64(v)))].fetch_add(1, std::memory_order_relaxed);
+    m_sum.fetch_add(v, std::memory_order_relaxed);
+    qint64 seen = m_max.load(std::memory_order_relaxed);
+    while (v > seen && !m_max.compare_exchange_weak(seen, v, std::memory_order_relaxed)) {
+    }
+}
+
+// This method copies the buckets. The total is recomputed from them so that percentiles stay
+// consistent with the counts even while other threads are recording.
+HistogramSnapshot LatencyHistogram::snapshot() const {
+    HistogramSnapshot s;
+    s.counts.resize(size_t(BucketCount));
+    for (int i = 0; i < BucketCount; ++i) {
+        s.counts[size_t(i)] = m_counts[size_t(i)].load(std::memory_order_relaxed);
+        s.count += s.counts[size_t(i)];
+    }
+    s.sum = m_sum.load(std::memory_order_relaxed);
+    s.max = m_max.load(std::memory_order_relaxed);
+    return s;
+}
+
+// This method counts a successfully parsed manifest.
+void IngestMetrics::manifestParsed(qint64 parseUs, qint64 invalidCodes) {
+    m_manifestsParsed.fetch_add(1, std::memory_order_relaxed);
+    m_invalidCodes.fetch_add(invalidCodes, std::memory_order_relaxed);
+    m_parseUs.record(parseUs);
+}
+
+// This method counts a manifest that could not be parsed; its parse time counts too.
+void IngestMetrics::manifestRejected(qint64 parseUs) {
+    m_manifestsRejected.fetch_add(1, std::memory_order_relaxed);
+    m_parseUs.record(parseUs);
+}
+
+// This method counts a manifest merged into the store.
+void IngestMetrics::manifestCommitted(qint64 rows, qint64 commitUs) {
+    m_rowsIngested.fetch_add(rows, std::memory_order_relaxed);
+    m_commitUs.record(commitUs);
+}
+
+// This method reads every counter on its own, so the snapshot is only roughly consistent.
+MetricsSnapshot IngestMetrics::snapshot() const {
+    MetricsSnapshot s;
+    s.uptimeMs = m_clock.elapsed();
+    s.bytesReceived = m_bytesReceived.load(std::memory_order_relaxed);
+    s.connectionsAccepted = m_connectionsAccepted.load(std::memory_order_relaxed);
+    s.activeConnections = m_activeConnections.load(std::memory_order_relaxed);
+    s.manifestsParsed = m_manifestsParsed.load(std::memory_order_relaxed);
+    s.manifestsRejected = m_manifestsRejected.load(std::memory_order_relaxed);
+    s.rowsIngested = m_rowsIngested.load(std::memory_order_relaxed);
+    s.invalidCodes = m_invalidCodes.load(std::memory_order_relaxed);
+    s.parseUs = m_parseUs.snapshot();
+    s.commitUs = m_commitUs.snapshot();
+    return s;
+}
+
+// This function writes every metric under the cargo_ingest_ prefix; durations are in seconds.
+QByteArray IngestMetrics::exposition(const MetricsSnapshot& s) {
+    QByteArray out;
+    writeMetric(out, "cargo_ingest_uptime_seconds", "gauge", "Seconds since the server started.", s.uptimeMs / 1000);
+    writeMetric(out, "cargo_ingest_bytes_received_total", "counter", "Bytes read from manifest connections.", s.bytesReceived);
+    writeMetric(out, "cargo_ingest_connections_accepted_total", "counter", "Manifest connections accepted.", s.connectionsAccepted);
+    writeMetric(out, "cargo_ingest_connections_active", "gauge", "Manifest connections open now.", s.activeConnections);
+    writeMetric(out, "cargo_ingest_manifests_parsed_total", "counter", "Manifests parsed successfully.", s.manifestsParsed);
+    writeMetric(out, "cargo_ingest_manifests_rejected_total", "counter", "Manifests that failed to parse.", s.manifestsRejected);
+    writeMetric(out, "cargo_ingest_rows_total", "counter", "Container rows merged into the store.", s.rowsIngested);
+    writeMetric(out, "cargo_ingest_invalid_codes_total", "counter", "Rows stored with a masked, invalid code.", s.invalidCodes);
+    writeSummary(out, "cargo_ingest_parse_seconds", "Time to parse one manifest.", s.parseUs);
+    writeSummary(out, "cargo_ingest_commit_seconds", "Time to merge one manifest into the store.", s.commitUs);
+    return out;
+}
+
+// This function reports the traffic and latencies of the interval between two snapshots.
+QString IngestMetrics::logLine(const MetricsSnapshot& now, const MetricsSnapshot& before) {
+    const HistogramSnapshot parse = now.parseUs.since(before.parseUs);
+    const HistogramSnapshot commit = now.commitUs.since(before.commitUs);
+    return QString("Last %1 s: %2 manifests (%3 rejected), %4 rows (%5 invalid codes), %6 KB, %7 open connections; "
+                   "parse p50 %8 ms, p99 %9 ms; commit p50 %10 ms, p99 %11 ms")
+        .arg((now.uptimeMs - before.uptimeMs) / 1000)
+        .arg(now.manifestsParsed - before.manifestsParsed)
+        .arg(now.manifestsRejected - before.manifestsRejected)
+        .arg(now.rowsIngested - before.rowsIngested)
+        .arg(now.invalidCodes - before.invalidCodes)
+        .arg((now.bytesReceived - before.bytesReceived) / 1024)
+        .arg(now.activeConnections)
+        .arg(millis(parse.percentile(0.5)), millis(parse.percentile(0.99)),
+             millis(commit.percentile(0.5)), millis(commit.percentile(0.99)));
+}
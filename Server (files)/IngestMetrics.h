@@ -0,0 +1,110 @@
+#ifndef INGESTMETRICS_H
+#define INGESTMETRICS_H
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QString>
+#include <array>
+#include <atomic>
+#include <vector>
+
+// The HistogramSnapshot struct is a copy of a LatencyHistogram's buckets, taken for reporting.
+struct HistogramSnapshot{
+    std::vector<qint64> counts;     // One count per bucket (see LatencyHistogram::bucketOf).
+    qint64 count{0};                // Recorded values.
+    qint64 sum{0};                  // Their total, in microseconds.
+    qint64 max{0};                  // The largest value ever recorded, in microseconds.
+
+    // This method returns the value below which the given fraction (0-1) of values fall, accurate to
+    // the bucket width (about 3%). It returns 0 when nothing was recorded.
+    qint64 percentile(double fraction) const;
+    // This method returns the average value, or 0 when nothing was recorded.
+    double mean() const{ return count > 0 ? double(sum) / double(count) : 0.0; }
+    // This method returns what was recorded after the earlier snapshot of the same histogram. The max
+    // of the difference is the upper edge of its highest bucket, as the exact value is not kept.
+    HistogramSnapshot since(const HistogramSnapshot& earlier) const;
+};
+
+// The LatencyHistogram class counts durations in log-linear buckets, like an HDR histogram: every
+// power of two is split into SubBuckets equal parts, so each value is kept to within about 3% whether
+// it is 40 microseconds or 40 seconds, in a fixed few kilobytes. Recording is a handful of relaxed
+// atomic additions, so any number of threads can record at once without a lock.
+class LatencyHistogram{
+public:
+    static constexpr int SubBucketBits = 5;
+    static constexpr int SubBuckets = 1 << SubBucketBits;
+    // Values up to 2^MaxBits microseconds (about 12 days) are resolved; larger ones land in the last bucket.
+    static constexpr int MaxBits = 40;
+    static constexpr int BucketCount = (MaxBits - SubBucketBits + 1) * SubBuckets;
+
+    // This method counts one duration in microseconds; negative durations count as zero.
+    void record(qint64 us);
+    // This method copies the buckets; concurrent recording may make the copy slightly inconsistent.
+    HistogramSnapshot snapshot() const;
+
+    // This function returns the bucket a value is counted in.
+    static int bucketOf(quint64 value);
+    // This function returns the largest value counted in a bucket.
+    static quint64 bucketHigh(int bucket);
+
+private:
+    std::array<std::atomic<qint64>, BucketCount> m_counts{};
+    std::atomic<qint64> m_sum{0};
+    std::atomic<qint64> m_max{0};
+};
+
+// The MetricsSnapshot struct is a copy of every ingest metric at one moment.
+struct MetricsSnapshot{
+    qint64 uptimeMs{0};              // Time since the metrics were created.
+    qint64 bytesReceived{0};         // Bytes read from manifest connections.
+    qint64 connectionsAccepted{0};   // Manifest connections accepted since start.
+    qint64 activeConnections{0};     // Manifest connections open now.
+    qint64 manifestsParsed{0};       // Manifests parsed successfully.
+    qint64 manifestsRejected{0};     // Manifests that failed to parse.
+    qint64 rowsIngested{0};          // Container rows merged into the store.
+    qint64 invalidCodes{0};          // Rows whose code was invalid and is stored masked.
+    HistogramSnapshot parseUs;       // Time to parse one manifest.
+    HistogramSnapshot commitUs;      // Time to merge one parsed manifest into the store.
+};
+
+// The IngestMetrics class collects the counters and latency histograms of the ingest core. The shards
+// and parser tasks update it with relaxed atomics, so measuring costs no lock on the ingest path; the
+// status panel, the periodic log line and the metrics port read it through snapshot().
+class IngestMetrics{
+public:
+    // This is the constructor. It starts the uptime clock.
+    IngestMetrics(){ m_clock.start(); }
+
+    // These methods count connection events and received bytes.
+    void connectionOpened(){ ++m_connectionsAccepted; ++m_activeConnections; }
+    void connectionsClosed(int count){ m_activeConnections -= count; }
+    void bytesReceived(qint64 bytes){ m_bytesReceived.fetch_add(bytes, std::memory_order_relaxed); }
+
+    // This method counts a parsed manifest with its parse time, rows and invalid codes.
+    void manifestParsed(qint64 parseUs, qint64 invalidCodes);
+    // This method counts a manifest that failed to parse.
+    void manifestRejected(qint64 parseUs);
+    // This method counts the rows of a manifest merged into the store and the time the merge took.
+    void manifestCommitted(qint64 rows, qint64 commitUs);
+
+    // This method copies every metric. It is thread-safe.
+    MetricsSnapshot snapshot() const;
+
+    // This function renders a snapshot in the Prometheus text format, the form the metrics port serves.
+    static QByteArray exposition(const MetricsSnapshot& s);
+    // This function describes what happened between two snapshots in one log line.
+    static QString logLine(const MetricsSnapshot& now, const MetricsSnapshot& before);
+
+private:
+    QElapsedTimer m_clock;
+    std::atomic<qint64> m_bytesReceived{0};
+    std::atomic<qint64> m_connectionsAccepted{0};
+    std::atomic<qint64> m_activeConnections{0};
+    std::atomic<qint64> m_manifestsParsed{0};
+    std::atomic<qint64> m_manifestsRejected{0};
+    std::atomic<qint64> m_rowsIngested{0};
+    std::atomic<qint64> m_invalidCodes{0};
+    LatencyHistogram m_parseUs;
+    LatencyHistogram m_commitUs;
+};
+
+#endif // INGESTMETRICS_H
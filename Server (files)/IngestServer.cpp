@@ -0,0 +1,238 @@
+#include "IngestServer.h"
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QTcpServer>
+#include <QThread>
+#include <QThreadPool>
+#include <QTimer>
+#include <functional>
+#include "ContainerStore.h"
+#include "MetricsServer.h"
+#include "QueryServer.h"
+#include "IngestLog.h"
+
+Q_LOGGING_CATEGORY(lcIngest, "cargo.ingest")
+
+namespace {
+
+// The ShardingTcpServer class passes each accepted descriptor on instead of wrapping it in a socket on
+// the accepting thread; the shard that gets it creates the socket on its own thread.
+class ShardingTcpServer : public QTcpServer{
+public:
+    explicit ShardingTcpServer(std::function<void(qintptr)> assign, QObject* parent)
+        : QTcpServer(parent), assign(std::move(assign)) {}
+protected:
+    void incomingConnection(qintptr descriptor) override { assign(descriptor); }
+private:
+    std::function<void(qintptr)> assign;
+};
+
+// The ShardingLocalServer class does the same for local socket connections.
+class ShardingLocalServer : public QLocalServer{
+public:
+    explicit ShardingLocalServer(std::function<void(quintptr)> assign, QObject* parent)
+        : QLocalServer(parent), assign(std::move(assign)) {}
+protected:
+    void incomingConnection(quintptr descriptor) override { assign(descriptor); }
+private:
+    std::function<void(quintptr)> assign;
+};
+
+} // namespace
+
+// The constructor only stores its configuration; sockets and threads are created later by start().
+IngestServer::IngestServer(ContainerStore* store, const IngestConfig& config, QObject* parent)
+    : QObject(parent), store(store), config(config)
+{
+    // Creates the parser pool, by default with one thread per core so simultaneous posts are parsed in parallel.
+    parsers = new QThreadPool(this);
+    parsers->setMaxThreadCount(config.parserThreads > 0 ? config.parserThreads : QThread::idealThreadCount());
+}
+
+// The destructor shuts down in dependency order: no new connections, no open sockets, no running parser
+// tasks (they reply through the shards), and only then the shards' threads.
+IngestServer::~IngestServer() {
+    if (server) server->close();
+    if (localServer) localServer->close();
+    for (IngestShard* shard : shards) {
+        QMetaObject::invokeMethod(shard, &IngestShard::closeAll, Qt::BlockingQueuedConnection);
+    }
+    parsers->waitForDone();
+    for (QThread* thread : shardThreads) {
+        thread->quit();
+        thread->wait();
+    }
+}
+
+// This method collects every shard's counters.
+QVector<ShardStats> IngestServer::shardStats() const {
+    QVector<ShardStats> out;
+    out.reserve(shards.size());
+    for (const IngestShard* shard : shards) out.push_back(shard->stats());
+    return out;
+}
+
+// This slot creates the I/O threads and the listening sockets on the current (ingest) thread.
+bool IngestServer::start() {
+    // Restores the store from the write-ahead log before any client can post a newer manifest.
+    if (!config.dataDir.isEmpty()) {
+        WriteAheadLog::Options options;
+        options.directory = config.dataDir;
+        QString error;
+        if (!store->openLog(options, &error)) {
+            const QString message = QString("Cannot open the log in %1: %2").arg(config.dataDir, error);
+            qCCritical(lcIngest).noquote() << message;
+            emit ingestError(message);
+            return false;
+        }
+        qCInfo(lcIngest) << "Logging accepted pallets to" << config.dataDir;
+    }
+
+    // Starts the I/O shards, by default one per core up to four; beyond that accepting is rarely the limit.
+    const int shardCount = config.ioThreads > 0 ? config.ioThreads : qBound(1, QThread::idealThreadCount(), 4);
+    IngestShard::Shared shared;
+    shared.store = store;
+    shared.parsers = parsers;
+    shared.uploads = &uploads;
+    shared.metrics = &counters;
+    shared.maxUploadBytes = config.maxUploadBytes;
+    for (int i = 0; i < shardCount; ++i) {
+        auto* thread = new QThread(this);
+        thread->setObjectName(QString("ingest-io-%1").arg(i));
+        auto* shard = new IngestShard(i, shared);
+        shard->moveToThread(thread);
+        connect(thread, &QThread::finished, shard, &QObject::deleteLater);
+        connect(shard, &IngestShard::ingestError, this, &IngestServer::ingestError);
+        thread->start();
+        shards.push_back(shard);
+        shardThreads.push_back(thread);
+    }
+    lastLogged = shardStats();
+    lastMetrics = counters.snapshot();
+
+    // Drops abandoned uploads and logs the shard statistics once a minute.
+    auto* housekeepingTimer = new QTimer(this);
+    connect(housekeepingTimer, &QTimer::timeout, this, &IngestServer::housekeeping);
+    housekeepingTimer->start(HousekeepingMs);
+
+    // Creates the TCP listener; it hands every connection to a shard.
+    server = new ShardingTcpServer([this](qintptr d) { assignTcp(d); }, this);
+
+    // Attempts to start the server listening on the configured address and port.
+    if (!server->listen(config.address, config.port)) {
+        const QString message = QString("Cannot listen on %1:%2: %3")
+                                    .arg(config.address.toString()).arg(config.port).arg(server->errorString());
+        qCCritical(lcIngest).noquote() << message;
+        emit ingestError(message);
+        return false;
+    }
+    qCInfo(lcIngest) << "Listening on" << config.address.toString() << config.port << "with"
+                     << shardCount << "I/O threads and" << parsers->maxThreadCount() << "parser threads";
+
+    // Serves queries from the same thread; they read store snapshots and never wait for the parsers.
+    if (config.queryPort != 0) {
+        queries = new QueryServer(store, this);
+        QString error;
+        if (!queries->listen(config.address, config.queryPort, &error)) {
+            const QString message = QString("Cannot listen for queries on %1:%2: %3")
+                                        .arg(config.address.toString()).arg(config.queryPort).arg(error);
+            qCCritical(lcIngest).noquote() << message;
+            emit ingestError(message);
+            return false;
+        }
+        qCInfo(lcIngest) << "Answering queries on port" << config.queryPort;
+    }
+
+    // Serves the metrics for scraping. A failure is not fatal; ingest works without it.
+    if (config.metricsPort != 0) {
+        metricsServer = new MetricsServer(&counters, this);
+        QString error;
+        if (metricsServer->listen(config.address, config.metricsPort, &error)) {
+            qCInfo(lcIngest) << "Serving metrics on port" << config.metricsPort;
+        } else {
+            qCWarning(lcIngest) << "Cannot serve metrics on port" << config.metricsPort << ":" << error;
+        }
+    }
+
+    // Same-host clients connect here instead of over TCP. A failure is not fatal; they fall back to TCP.
+    if (!config.localName.isEmpty()) {
+        localServer = new ShardingLocalServer([this](quintptr d) { assignLocal(d); }, this);
+        localServer->setSocketOptions(QLocalServer::UserAccessOption);
+        // A socket file left behind by a crashed server would make listen() fail, so it is removed; but only
+        // if nothing answers on it, since removing a running server's name would cut its clients off.
+        QLocalSocket probe;
+        probe.connectToServer(config.localName);
+        if (probe.waitForConnected(1000)) {
+            probe.abort();
+            qCWarning(lcIngest) << "Local socket" << config.localName << "is in use by another server; local clients stay with it";
+        } else {
+            QLocalServer::removeServer(config.localName);
+            if (localServer->listen(config.localName)) {
+                qCInfo(lcIngest) << "Accepting local clients on" << localServer->fullServerName();
+            } else {
+                qCWarning(lcIngest) << "Cannot listen on local socket" << config.localName << ":" << localServer->errorString();
+            }
+        }
+    }
+    return true;
+}
+
+// This private helper function picks the least loaded shard. Connections are counted when assigned,
+// not when the shard gets round to them, so a burst does not all land on the same shard.
+IngestShard* IngestServer::pickShard() {
+    IngestShard* best = nullptr;
+    int bestLoad = 0;
+    for (int n = 0; n < shards.size(); ++n) {
+        IngestShard* shard = shards.at((nextShard + n) % shards.size());
+        const int load = shard->activeConnections();
+        if (!best || load < bestLoad) {
+            best = shard;
+            bestLoad = load;
+        }
+    }
+    nextShard = (nextShard + 1) % shards.size();
+    best->countAssigned();
+    return best;
+}
+
+// This private helper function hands a TCP descriptor to a shard's thread.
+void IngestServer::assignTcp(qintptr descriptor) {
+    IngestShard* shard = pickShard();
+    QMetaObject::invokeMethod(shard, [shard, descriptor] { shard->adoptTcp(descriptor); }, Qt::QueuedConnection);
+}
+
+// This private helper function hands a local socket descriptor to a shard's thread.
+void IngestServer::assignLocal(quintptr descriptor) {
+    IngestShard* shard = pickShard();
+    QMetaObject::invokeMethod(shard, [shard, descriptor] { shard->adoptLocal(descriptor); }, Qt::QueuedConnection);
+}
+
+// This slot drops abandoned uploads and logs, per shard and in total, the traffic since the previous call.
+void IngestServer::housekeeping() {
+    if (const int dropped = uploads.dropIdle()) {
+        qCInfo(lcIngest) << "Dropped" << dropped << "idle uploads";
+    }
+    const QVector<ShardStats> now = shardStats();
+    for (int i = 0; i < now.size(); ++i) {
+        const ShardStats& s = now.at(i);
+        const ShardStats before = lastLogged.value(i);
+        if (s.accepted == before.accepted && s.bytes == before.bytes) continue;
+        qCInfo(lcIngest).nospace() << "I/O thread " << s.shard << ": " << s.active << " open, "
+                                   << s.accepted - before.accepted << " new connections, "
+                                   << s.manifests - before.manifests << " manifests, "
+                                   << (s.bytes - before.bytes) / 1024 << " KB in the last minute";
+    }
+    lastLogged = now;
+
+    const MetricsSnapshot metricsNow = counters.snapshot();
+    if (metricsNow.bytesReceived != lastMetrics.bytesReceived || metricsNow.activeConnections != 0) {
+        qCInfo(lcIngest).noquote() << IngestMetrics::logLine(metricsNow, lastMetrics);
+    }
+    lastMetrics = metricsNow;
+
+    if (Memory::enabled()) {
+        const Memory::Snapshot memoryNow = Memory::snapshot();
+        qCInfo(lcIngest).noquote() << "Memory:" << Memory::summary(memoryNow, lastMemory);
+        lastMemory = memoryNow;
+    }
+}
@@ -0,0 +1,95 @@
+#ifndef INGESTSERVER_H
+#define INGESTSERVER_H
+#include <QObject>
+#include <QVector>
+#include "IngestConfig.h"
+#include "IngestMetrics.h"
+#include "MemoryAccounting.h"
+#include "IngestShard.h"
+
+// Forward declarations to reduce compile time dependencies.
+class QLocalServer;
+class QTcpServer;
+class QThread;
+class QThreadPool;
+class ContainerStore;
+class QueryServer;
+class MetricsServer;
+
+// The IngestServer class receives manifests from clients and merges them into a ContainerStore.
+// It has no GUI dependency: the headless daemon runs it on its main event loop and the windowed
+// server runs it on a QThread of its own. The server's thread only accepts connections; each accepted
+// socket is handed to the least loaded of several IngestShard I/O threads, which read and frame its
+// data, and parsing happens on a pool of worker threads. Errors are logged under the cargo.ingest
+// category and also signalled, so a viewer can show them.
+// A client that opens its connection with Wire::ManifestMagic sends framed manifests, each carrying a
+// sequence number, and gets an Ack or Nack for every one once it has been merged (and logged, when the
+// write-ahead log is on). Any other connection is read as one bare XML manifest ending at disconnect,
+// as older clients send it, and gets no reply. Large manifests arrive as chunked uploads, which survive
+// a reconnect (see UploadTable).
+// Besides TCP, the server listens on a local socket (see IngestConfig::localName); clients on the same
+// host use it automatically. A local client may attach a shared memory ring and post manifests as
+// (offset, length) frames pointing into it; those are parsed where they lie, without passing through
+// the socket at all.
+// Counters and latency histograms of the whole ingest path are kept in an IngestMetrics, logged with the
+// housekeeping and served as plain text on the metrics port (see IngestConfig::metricsPort).
+class IngestServer : public QObject{
+    Q_OBJECT
+public:
+    // How often idle uploads are dropped and the shard statistics and metrics are logged.
+    static constexpr int HousekeepingMs = 60 * 1000;
+
+    // This is the constructor. The store must outlive the server.
+    explicit IngestServer(ContainerStore* store, const IngestConfig& config, QObject* parent=nullptr);
+    // The destructor stops accepting, closes every client socket, waits for running parser tasks and
+    // stops the I/O threads.
+    ~IngestServer() override;
+
+    // This method returns the counters of every shard. It may be called from any thread once start()
+    // has returned.
+    QVector<ShardStats> shardStats() const;
+    // This method returns the ingest metrics. Reading them is thread-safe.
+    const IngestMetrics& metrics() const{ return counters; }
+
+public slots:
+    // This slot starts the I/O threads and listens for manifests and, unless disabled, for queries. It
+    // must run on the thread that owns the server. It returns false (after logging and signalling the
+    // error) if a port cannot be bound.
+    bool start();
+
+signals:
+    // This signal is emitted, possibly from a worker thread, when a manifest or the listener fails.
+    void ingestError(const QString& message);
+
+private slots:
+    // This slot drops idle uploads and logs what each shard, and the ingest as a whole, has done since
+    // the last time.
+    void housekeeping();
+
+private:
+    // This private helper function picks the shard for a new connection: the one with the fewest open
+    // connections, taking turns among equals.
+    IngestShard* pickShard();
+    // These private helper functions pass an accepted descriptor to a shard's thread.
+    void assignTcp(qintptr descriptor);
+    void assignLocal(quintptr descriptor);
+
+private:
+    ContainerStore* store{};                    // The store that parser threads merge their results into.
+    IngestConfig config;                        // The listen address, ports and thread counts.
+    QTcpServer* server{};                       // The TCP listener; created by start() on the ingest thread.
+    QLocalServer* localServer{};                // The local socket listener; created by start() unless disabled.
+    QThreadPool* parsers{};                     // The worker threads that parse manifests.
+    QueryServer* queries{};                     // Answers client queries; created by start() unless disabled.
+    MetricsServer* metricsServer{};             // Serves the metrics; created by start() unless disabled.
+    IngestMetrics counters;                     // Updated by the shards and parser tasks.
+    MetricsSnapshot lastMetrics;                // The metrics at the last housekeeping log line.
+    Memory::Snapshot lastMemory;                // The memory counters at the last housekeeping log line.
+    UploadTable uploads;                        // Unfinished chunked uploads, shared by every shard.
+    QVector<IngestShard*> shards;               // The I/O shards; each lives on its own thread.
+    QVector<QThread*> shardThreads;             // The threads running the shards, in the same order.
+    int nextShard{0};                           // Where pickShard() starts looking, to take turns.
+    QVector<ShardStats> lastLogged;             // The shard counters at the last housekeeping log line.
+};
+
+#endif // INGESTSERVER_H
@@ -0,0 +1,397 @@
+#include "IngestShard.h"
+#include <QLocalSocket>
+#include <QMutexLocker>
+#include <QSharedMemory>
+#include <QTcpSocket>
+#include <QThreadPool>
+#include "ContainerStore.h"
+#include "IngestMetrics.h"
+#include "ManifestParser.h"
+#include "IngestLog.h"
+#include "Trace.h"
+
+namespace {
+
+// This helper builds a Nack frame.
+QByteArray nackFrame(quint32 seq, Wire::NackReason reason, const QString& message) {
+    QByteArray nack;
+    Wire::Writer(nack).u8(quint8(reason));
+    nack.append(message.toUtf8());
+    return Wire::frame(Wire::Frame::Nack, seq, nack);
+}
+
+// This helper names a client for the log.
+QString peerName(QIODevice* sock) {
+    if (auto* tcp = qobject_cast<QTcpSocket*>(sock)) return tcp->peerAddress().toString();
+    return QStringLiteral("local client");
+}
+
+// This helper closes a client socket once its pending replies are written.
+void closeSocket(QIODevice* sock) {
+    if (auto* tcp = qobject_cast<QTcpSocket*>(sock)) tcp->disconnectFromHost();
+    else if (auto* local = qobject_cast<QLocalSocket*>(sock)) local->disconnectFromServer();
+}
+
+// This helper drops a client socket at once.
+void abortSocket(QIODevice* sock) {
+    if (auto* tcp = qobject_cast<QTcpSocket*>(sock)) tcp->abort();
+    else if (auto* local = qobject_cast<QLocalSocket*>(sock)) local->abort();
+}
+
+} // namespace
+
+// This method appends a chunk under the table's lock. An upload the table does not know (the server
+// restarted, or dropped it as idle) can only start at chunk 0; anything else is answered with next 0.
+UploadTable::Result UploadTable::add(const Wire::ChunkHeader& h, const QByteArray& data, bool intact) {
+    QMutexLocker lock(&m_lock);
+    Result result;
+    auto it = m_uploads.find(h.upload);
+    if (it == m_uploads.end() || it->totalBytes != h.totalBytes || it->count != h.count) {
+        if (h.index != 0) return result;
+        if (it != m_uploads.end()) m_bytes -= it->data.size();
+        Upload fresh;
+        fresh.totalBytes = h.totalBytes;
+        fresh.count = h.count;
+        it = m_uploads.insert(h.upload, fresh);
+    }
+
+    Upload& u = it.value();
+    u.touchedMs = m_clock.elapsed();
+    if (intact && h.index == u.next && quint64(u.data.size() + data.size()) <= u.totalBytes) {
+        u.data.append(data);
+        m_bytes += data.size();
+        ++u.next;
+    }
+    result.next = u.next;
+    if (u.next == u.count) {
+        result.complete = true;
+        result.data = m_uploads.take(h.upload).data;
+        m_bytes -= result.data.size();
+    }
+    updateMemory();
+    return result;
+}
+
+// This method forgets an upload, for instance one that exceeds the size limit.
+void UploadTable::remove(quint64 upload) {
+    QMutexLocker lock(&m_lock);
+    const auto it = m_uploads.constFind(upload);
+    if (it == m_uploads.cend()) return;
+    m_bytes -= it->data.size();
+    m_uploads.erase(it);
+    updateMemory();
+}
+
+// This method forgets uploads whose client has not sent a chunk for a long time.
+int UploadTable::dropIdle() {
+    QMutexLocker lock(&m_lock);
+    const qint64 now = m_clock.elapsed();
+    int dropped = 0;
+    for (auto it = m_uploads.begin(); it != m_uploads.end();) {
+        if (now - it->touchedMs > IdleMs) {
+            m_bytes -= it->data.size();
+            it = m_uploads.erase(it);
+            ++dropped;
+        } else {
+            ++it;
+        }
+    }
+    updateMemory();
+    return dropped;
+}
+
+// This helper counts the chunk data received so far; a completed upload's data leaves with its manifest.
+void UploadTable::updateMemory() {
+    m_memory.set(m_bytes);
+}
+
+// The constructor only stores what the shard shares with the others; sockets arrive later.
+IngestShard::IngestShard(int index, const Shared& shared, QObject* parent)
+    : QObject(parent), index(index), shared(shared)
+{
+}
+
+// The destructor drops the connections that are still open.
+IngestShard::~IngestShard() {
+    closeAll();
+}
+
+// This method counts a new connection; it is thread-safe.
+void IngestShard::countAssigned() {
+    ++activeCount;
+    ++acceptedCount;
+    shared.metrics->connectionOpened();
+}
+
+// This private helper function uncounts connections that were closed or never taken over.
+void IngestShard::countClosed(int count) {
+    activeCount -= count;
+    shared.metrics->connectionsClosed(count);
+}
+
+// This method copies the counters; each is read on its own, so the copy is only roughly consistent.
+ShardStats IngestShard::stats() const {
+    ShardStats s;
+    s.shard = index;
+    s.accepted = acceptedCount.load(std::memory_order_relaxed);
+    s.active = activeCount.load(std::memory_order_relaxed);
+    s.bytes = bytesCount.load(std::memory_order_relaxed);
+    s.manifests = manifestCount.load(std::memory_order_relaxed);
+    return s;
+}
+
+// This slot creates the TCP socket on the shard's thread, which makes the shard's event loop serve it.
+void IngestShard::adoptTcp(qintptr descriptor) {
+    auto* sock = new QTcpSocket(this);
+    if (!sock->setSocketDescriptor(descriptor)) {
+        qCWarning(lcIngest) << "Shard" << index << "cannot take over a connection:" << sock->errorString();
+        delete sock;
+        countClosed(1);
+        return;
+    }
+    addClient(sock, false);
+    connect(sock, &QTcpSocket::disconnected, this, &IngestShard::onClientDisconnected);
+}
+
+// This slot creates the local socket on the shard's thread.
+void IngestShard::adoptLocal(quintptr descriptor) {
+    auto* sock = new QLocalSocket(this);
+    if (!sock->setSocketDescriptor(descriptor)) {
+        qCWarning(lcIngest) << "Shard" << index << "cannot take over a local connection:" << sock->errorString();
+        delete sock;
+        countClosed(1);
+        return;
+    }
+    addClient(sock, true);
+    connect(sock, &QLocalSocket::disconnected, this, &IngestShard::onClientDisconnected);
+}
+
+// This slot drops every connection without waiting for pending writes.
+void IngestShard::closeAll() {
+    for (auto* sock : clients.keys()) {
+        sock->disconnect(this);
+        abortSocket(sock);
+        sock->deleteLater();
+    }
+    countClosed(int(clients.size()));
+    clients.clear();
+}
+
+// This private helper function registers a client; the protocol is the same on both transports.
+void IngestShard::addClient(QIODevice* sock, bool local) {
+    Connection conn;
+    conn.local = local;
+    clients.insert(sock, conn);
+    connect(sock, &QIODevice::readyRead, this, &IngestShard::onReadyRead);
+}
+
+// This slot is triggered when data is available to be read from one of the client sockets.
+void IngestShard::onReadyRead() {
+    auto* sock = qobject_cast<QIODevice*>(sender());
+    if (!sock || !clients.contains(sock)) return;
+    Connection& conn = clients[sock];
+
+    // Appends the available bytes to this client's buffer; a manifest may arrive in many pieces.
+    const QByteArray bytes = sock->readAll();
+    bytesCount += bytes.size();
+    shared.metrics->bytesReceived(bytes.size());
+    conn.buffer.append(bytes);
+
+    // The first bytes tell a framed client from one that sends a bare XML manifest.
+    if (conn.mode == Connection::Undecided) {
+        const QByteArray magic(Wire::ManifestMagic, sizeof Wire::ManifestMagic);
+        if (conn.buffer.size() < magic.size() && magic.startsWith(conn.buffer)) return;
+        if (conn.buffer.startsWith(magic)) {
+            conn.mode = Connection::Framed;
+            conn.buffer.remove(0, magic.size());
+        } else {
+            conn.mode = Connection::Bare;
+        }
+    }
+    if (conn.mode == Connection::Framed) readFrames(sock, conn);
+}
+
+// This private helper function dispatches every manifest frame that has arrived completely.
+void IngestShard::readFrames(QIODevice* sock, Connection& conn) {
+    TRACE_SPAN("readFrames");
+    Wire::Frame type;
+    quint32 seq = 0;
+    QByteArray payload;
+    for (;;) {
+        const Wire::TakeResult result = Wire::takeFrame(conn.buffer, type, seq, payload);
+        if (result == Wire::TakeResult::NeedMore) return;
+        if (result == Wire::TakeResult::Malformed) {
+            // The stream cannot be followed past an oversized frame, so the connection is closed.
+            sock->write(nackFrame(0, Wire::NackReason::TooLarge, "Frame too large"));
+            qCWarning(lcIngest).noquote() << "Closing" << peerName(sock) << "after an oversized frame";
+            conn.buffer.clear();
+            disconnect(sock, &QIODevice::readyRead, this, &IngestShard::onReadyRead);
+            closeSocket(sock);
+            return;
+        }
+        if (type == Wire::Frame::Manifest) {
+            dispatchManifest(payload, sock, seq);
+        } else if (type == Wire::Frame::ManifestChunk) {
+            acceptChunk(sock, seq, payload);
+        } else if (type == Wire::Frame::AttachRing && conn.local) {
+            attachRing(sock, conn, seq, payload);
+        } else if (type == Wire::Frame::RingManifest && conn.local) {
+            acceptRingManifest(sock, conn, seq, payload);
+        } else {
+            sock->write(nackFrame(seq, Wire::NackReason::ParseError, "Unexpected frame type on the manifest port"));
+        }
+    }
+}
+
+// This private helper function appends a chunk to its upload. Every chunk is answered with a ChunkAck
+// naming the next chunk wanted, so the client learns both what arrived and where to resume.
+void IngestShard::acceptChunk(QIODevice* sock, quint32 seq, const QByteArray& payload) {
+    Wire::ChunkHeader h;
+    QByteArray data;
+    const bool intact = Wire::readChunk(payload, h, data);
+    if (payload.size() < Wire::ChunkHeaderBytes || h.count == 0 || h.index >= h.count) {
+        sock->write(nackFrame(seq, Wire::NackReason::ParseError, "Malformed manifest chunk"));
+        return;
+    }
+    if (h.totalBytes > quint64(shared.maxUploadBytes)) {
+        shared.uploads->remove(h.upload);
+        sock->write(nackFrame(seq, Wire::NackReason::TooLarge,
+                              QString("Manifest exceeds the upload limit of %1 bytes").arg(shared.maxUploadBytes)));
+        return;
+    }
+
+    const UploadTable::Result result = shared.uploads->add(h, data, intact);
+    QByteArray ack;
+    Wire::Writer w(ack);
+    w.u32(h.index);
+    w.u32(result.next);
+    sock->write(Wire::frame(Wire::Frame::ChunkAck, seq, ack));
+    if (!result.complete) return;
+
+    // The last chunk is answered like a whole manifest, with an Ack or Nack under its sequence number.
+    if (quint64(result.data.size()) != h.totalBytes) {
+        sock->write(nackFrame(seq, Wire::NackReason::ParseError, "Manifest chunks do not add up to the announced size"));
+        return;
+    }
+    dispatchManifest(result.data, sock, seq);
+}
+
+// This private helper function attaches the client's ring read-only. The client owns the ring and
+// never touches a manifest in it before the server has answered that manifest, so no lock is needed.
+void IngestShard::attachRing(QIODevice* sock, Connection& conn, quint32 seq, const QByteArray& payload) {
+    auto ring = std::make_shared<QSharedMemory>(QString::fromUtf8(payload));
+    if (!ring->attach(QSharedMemory::ReadOnly)) {
+        // The client then sends its manifests through the socket instead.
+        sock->write(nackFrame(seq, Wire::NackReason::ServerError,
+                              QString("Cannot attach shared memory: %1").arg(ring->errorString())));
+        return;
+    }
+    conn.ring = ring;
+    QByteArray ack;
+    Wire::Writer(ack).u32(0);
+    sock->write(Wire::frame(Wire::Frame::Ack, seq, ack));
+}
+
+// This private helper function parses a manifest where the client put it in the ring. The parser reads
+// the shared pages directly, so the manifest is never copied through the kernel.
+void IngestShard::acceptRingManifest(QIODevice* sock, Connection& conn, quint32 seq, const QByteArray& payload) {
+    Wire::Reader in(payload);
+    const quint32 offset = in.u32();
+    const quint32 length = in.u32();
+    if (!conn.ring || !in.ok() || quint64(offset) + length > quint64(conn.ring->size())) {
+        sock->write(nackFrame(seq, Wire::NackReason::ParseError, "Invalid shared memory manifest"));
+        return;
+    }
+    const char* data = static_cast<const char*>(conn.ring->constData()) + offset;
+    dispatchManifest(QByteArray::fromRawData(data, qsizetype(length)), sock, seq, conn.ring);
+}
+
+// This slot is triggered when a client closes its connection, which marks the end of a bare manifest.
+void IngestShard::onClientDisconnected() {
+    auto* sock = qobject_cast<QIODevice*>(sender());
+    if (!sock || !clients.contains(sock)) return;
+
+    Connection conn = clients.take(sock);
+    conn.buffer.append(sock->readAll());
+    countClosed(1);
+    sock->deleteLater();
+
+    // A framed client's manifests have all been dispatched already; an unfinished frame is dropped.
+    if (conn.mode != Connection::Framed && !conn.buffer.isEmpty()) {
+        dispatchManifest(conn.buffer);
+    }
+}
+
+// This private helper function parses a manifest on the thread pool and merges the result into the store.
+void IngestShard::dispatchManifest(const QByteArray& xml, QPointer<QIODevice> replyTo, quint32 seq,
+                                    std::shared_ptr<QSharedMemory> ring) {
+    const bool framed = !replyTo.isNull();
+    ++manifestCount;
+    ContainerStore* store = shared.store;
+    IngestMetrics* metrics = shared.metrics;
+    shared.parsers->start([this, store, metrics, xml, replyTo, seq, framed, ring] {
+        // Holding the ring keeps it mapped while the parser reads from it, even if the client is gone.
+        Q_UNUSED(ring);
+        // Each task uses its own parser, so no state is shared between worker threads.
+        ManifestParser parser;
+        QElapsedTimer timer;
+        timer.start();
+        ParsedManifest parsed;
+        {
+            // The trace id is only known once the root element is read; the client's flow ends here.
+            Trace::Span span("parse");
+            parsed = parser.parse(xml);
+            span.setTraceId(parsed.traceId);
+            Trace::flowEnd(parsed.traceId);
+        }
+        const qint64 parseUs = timer.nsecsElapsed() / 1000;
+
+        if (!parsed.ok) {
+            metrics->manifestRejected(parseUs);
+            qCWarning(lcIngest).noquote() << "Rejected manifest:" << parsed.error;
+            // Signals may be emitted from any thread; receivers on other threads get a queued call.
+            emit ingestError(parsed.error);
+            if (framed) {
+                reply(replyTo, nackFrame(seq, Wire::NackReason::ParseError, parsed.error));
+            }
+            return;
+        }
+
+        // The store publishes the resulting changes on its queue for whoever displays them.
+        metrics->manifestParsed(parseUs, parsed.invalidCodes);
+        quint64 logSeq = 0;
+        timer.restart();
+        {
+            Trace::Span span("commit");
+            span.setTraceId(parsed.traceId);
+            store->mergeManifest(parsed.rows, &logSeq);
+        }
+        metrics->manifestCommitted(parsed.rows.size(), timer.nsecsElapsed() / 1000);
+        if (!framed) return;
+
+        // Acknowledges only once the manifest is durable, so an Ack survives a server crash.
+        // Waiting parser threads share one fsync thanks to the log's group commit. If the log failed,
+        // the manifest is refused instead; ServerError tells the client it may send it again later.
+        bool durable;
+        {
+            Trace::Span span("waitDurable");
+            span.setTraceId(parsed.traceId);
+            durable = store->waitDurable(logSeq);
+        }
+        if (!durable) {
+            reply(replyTo, nackFrame(seq, Wire::NackReason::ServerError, "The manifest could not be written to the log"));
+            return;
+        }
+        QByteArray ack;
+        Wire::Writer(ack).u32(quint32(parsed.rows.size()));
+        reply(replyTo, Wire::frame(Wire::Frame::Ack, seq, ack));
+    });
+}
+
+// This private helper function queues the write onto the shard's thread, which owns the sockets.
+// The QPointer turns into null if the client disconnected in the meantime.
+void IngestShard::reply(const QPointer<QIODevice>& sock, const QByteArray& frame) {
+    QMetaObject::invokeMethod(this, [sock, frame] {
+        if (sock) sock->write(frame);
+    }, Qt::QueuedConnection);
+}
@@ -0,0 +1,166 @@
+#ifndef INGESTSHARD_H
+#define INGESTSHARD_H
+#include <QObject>
+#include <QHash>
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QPointer>
+#include <atomic>
+#include <memory>
+#include "MemoryAccounting.h"
+#include "WireProtocol.h"
+
+// Forward declarations to reduce compile time dependencies.
+class QIODevice;
+class QSharedMemory;
+class QThreadPool;
+class ContainerStore;
+class IngestMetrics;
+
+// The UploadTable class holds the unfinished chunked uploads of every connection. A client that
+// reconnects may land on another shard, so the table is shared by all of them and guarded by a mutex.
+// Chunks are accepted strictly in order; uploads that see no chunk for IdleMs are dropped.
+class UploadTable{
+public:
+    // How long an unfinished upload is kept without receiving a chunk.
+    static constexpr qint64 IdleMs = 10 * 60 * 1000;
+
+    // The outcome of adding a chunk: the next chunk wanted and, once all have arrived, the manifest.
+    struct Result{
+        quint32 next{0};
+        bool complete{false};
+        QByteArray data;
+    };
+
+    // This is the constructor. It starts the clock idle uploads are measured on.
+    UploadTable(){ m_clock.start(); }
+
+    // This method adds a chunk to its upload. A repeated chunk changes nothing; a damaged or
+    // out-of-order one is refused, which the caller reports by answering with the unchanged next chunk.
+    Result add(const Wire::ChunkHeader& h, const QByteArray& data, bool intact);
+    // This method forgets an upload.
+    void remove(quint64 upload);
+    // This method drops uploads idle for longer than IdleMs and returns how many were dropped.
+    int dropIdle();
+
+private:
+    // An unfinished upload: the chunks received so far, in order.
+    struct Upload{
+        QByteArray data;
+        quint64 totalBytes{0};
+        quint32 count{0};
+        quint32 next{0};        // The next chunk expected.
+        qint64 touchedMs{0};    // When the last chunk arrived, on m_clock.
+    };
+
+    // This helper reports the buffered chunks to the memory accounting. It must be called with m_lock held.
+    void updateMemory();
+
+    QMutex m_lock;
+    QHash<quint64, Upload> m_uploads;   // Unfinished uploads by the client's upload id.
+    QElapsedTimer m_clock;
+    qint64 m_bytes{0};                  // The chunk data held by all unfinished uploads.
+    Memory::Charge m_memory{Memory::Domain::Uploads};
+};
+
+// The ShardStats struct is a snapshot of one shard's counters.
+struct ShardStats{
+    int shard{0};
+    qint64 accepted{0};      // Connections handed to the shard since start.
+    qint64 active{0};        // Connections open now.
+    qint64 bytes{0};         // Bytes received.
+    qint64 manifests{0};     // Manifests handed to the parsers.
+};
+
+// The IngestShard class serves a share of the manifest connections on an I/O thread of its own.
+// IngestServer accepts connections and passes each socket descriptor to the least loaded shard, which
+// creates the socket on its thread and from then on owns it: buffering, framing, chunked uploads and
+// shared memory rings all happen here, so a storm of connections is spread over every shard instead of
+// queueing on one thread. Parsing still runs on the shared parser pool, and replies come back to the
+// shard's thread, which owns the socket.
+class IngestShard : public QObject{
+    Q_OBJECT
+public:
+    // What every shard shares: the store, the parser pool, the upload table, the metrics and the upload limit.
+    struct Shared{
+        ContainerStore* store{};
+        QThreadPool* parsers{};
+        UploadTable* uploads{};
+        IngestMetrics* metrics{};
+        qint64 maxUploadBytes{0};
+    };
+
+    // This is the constructor. Everything in shared must outlive the shard.
+    IngestShard(int index, const Shared& shared, QObject* parent = nullptr);
+    // The destructor drops the shard's remaining connections.
+    ~IngestShard() override;
+
+    // This method counts a connection assigned to the shard. IngestServer calls it when it picks the
+    // shard, before the descriptor arrives, so a burst of connections is spread evenly.
+    void countAssigned();
+    // This method returns the number of connections assigned and not yet closed. It is thread-safe.
+    int activeConnections() const{ return activeCount.load(std::memory_order_relaxed); }
+    // This method returns the shard's counters. It is thread-safe.
+    ShardStats stats() const;
+
+public slots:
+    // This slot takes over an accepted TCP connection.
+    void adoptTcp(qintptr descriptor);
+    // This slot takes over an accepted local socket connection.
+    void adoptLocal(quintptr descriptor);
+    // This slot drops every connection; IngestServer calls it before shutting the parsers down.
+    void closeAll();
+
+signals:
+    // This signal is emitted, possibly from a parser thread, when a manifest fails.
+    void ingestError(const QString& message);
+
+private slots:
+    // This slot is automatically called by a client socket when new data is available to be read.
+    void onReadyRead();
+    // This slot is called when a client has finished sending and closed its connection.
+    void onClientDisconnected();
+
+private:
+    // The per-connection state: received bytes, whether the client uses framed manifests, and the
+    // shared memory ring a local client attached, if any.
+    struct Connection{
+        enum Mode { Undecided, Bare, Framed };
+        QByteArray buffer;
+        Mode mode{Undecided};
+        bool local{false};
+        std::shared_ptr<QSharedMemory> ring;
+    };
+
+    // This private helper function starts tracking a newly adopted client socket.
+    void addClient(QIODevice* sock, bool local);
+    // This private helper function hands a complete manifest to the parser thread pool. For a framed
+    // manifest, replyTo and seq say where the Ack or Nack goes; a bare manifest has no replyTo. A manifest
+    // lying in a shared memory ring passes the ring along so it stays mapped until parsed.
+    void dispatchManifest(const QByteArray& xml, QPointer<QIODevice> replyTo = {}, quint32 seq = 0,
+                          std::shared_ptr<QSharedMemory> ring = {});
+    // This private helper function takes every complete manifest frame out of a framed connection.
+    void readFrames(QIODevice* sock, Connection& conn);
+    // This private helper function adds one chunk to its upload and dispatches the upload once complete.
+    void acceptChunk(QIODevice* sock, quint32 seq, const QByteArray& payload);
+    // This private helper function attaches the shared memory ring a local client created.
+    void attachRing(QIODevice* sock, Connection& conn, quint32 seq, const QByteArray& payload);
+    // This private helper function dispatches a manifest that lies in the connection's ring.
+    void acceptRingManifest(QIODevice* sock, Connection& conn, quint32 seq, const QByteArray& payload);
+    // This private helper function writes a reply frame from any thread, on the shard's own thread.
+    void reply(const QPointer<QIODevice>& sock, const QByteArray& frame);
+    // This private helper function uncounts closed connections, in the shard and in the metrics.
+    void countClosed(int count);
+
+private:
+    int index;                                  // The shard's number, for the log and the stats.
+    Shared shared;
+    QHash<QIODevice*, Connection> clients;      // The state of every connection this shard owns.
+    std::atomic<int> activeCount{0};
+    std::atomic<qint64> acceptedCount{0};
+    std::atomic<qint64> bytesCount{0};
+    std::atomic<qint64> manifestCount{0};
+};
+
+#endif // INGESTSHARD_H
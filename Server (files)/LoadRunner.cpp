@@ -0,0 +1,181 @@
+#include "LoadRunner.h"
+#include <QElapsedTimer>
+#include <QHash>
+#include <QTcpSocket>
+#include <QThread>
+#include <algorithm>
+#include <cmath>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace {
+
+// This helper names a Nack reason for the report.
+QString reasonName(Wire::NackReason reason) {
+    switch (reason) {
+    case Wire::NackReason::ParseError:  return QStringLiteral("nack: parse error");
+    case Wire::NackReason::TooLarge:    return QStringLiteral("nack: too large");
+    case Wire::NackReason::ServerError: return QStringLiteral("nack: server error");
+    }
+    return QStringLiteral("nack: reason %1").arg(int(reason));
+}
+
+// This helper runs one connection until the shared counter passes the end of the list, then waits for
+// the outstanding replies. Everything it observes goes into its own report, merged by run().
+void runConnection(const LoadOptions& options, const QVector<QByteArray>& manifests,
+                   std::atomic<int>& next, const QElapsedTimer& clock, LoadReport& out) {
+    QTcpSocket socket;
+    socket.connectToHost(options.host, options.port);
+    if (!socket.waitForConnected(options.timeoutMs)) {
+        out.errors[QStringLiteral("connect: %1").arg(socket.errorString())] += 1;
+        return;
+    }
+    socket.setSocketOption(QAbstractSocket::LowDelayOption, 1);
+    socket.write(Wire::ManifestMagic, sizeof Wire::ManifestMagic);
+
+    QHash<quint32, qint64> dueUs;    // Outstanding manifests by sequence number.
+    QByteArray inbox;
+    quint32 seq = 0;
+
+    // Reads whatever replies arrive within waitMs. Returns false if the connection is no longer usable.
+    auto collect = [&](int waitMs) -> bool {
+        if (socket.bytesAvailable() == 0 && !socket.waitForReadyRead(waitMs)) {
+            return socket.state() == QAbstractSocket::ConnectedState
+                   && socket.error() == QAbstractSocket::SocketTimeoutError;
+        }
+        inbox.append(socket.readAll());
+        const qint64 nowUs = clock.nsecsElapsed() / 1000;
+        Wire::Frame type;
+        quint32 id = 0;
+        QByteArray payload;
+        for (;;) {
+            const Wire::TakeResult r = Wire::takeFrame(inbox, type, id, payload);
+            if (r == Wire::TakeResult::NeedMore) break;
+            if (r == Wire::TakeResult::Malformed) {
+                out.errors[QStringLiteral("malformed reply")] += 1;
+                return false;
+            }
+            if (!dueUs.contains(id)) continue;
+            Wire::Reader reader(payload);
+            if (type == Wire::Frame::Ack) {
+                out.latenciesUs.push_back(nowUs - dueUs.take(id));
+                out.containers += reader.u32();
+                ++out.acked;
+            } else if (type == Wire::Frame::Nack) {
+                dueUs.remove(id);
+                out.errors[reasonName(Wire::NackReason(reader.u8()))] += 1;
+                ++out.nacked;
+            }
+        }
+        return true;
+    };
+
+    // Waits until at least one outstanding manifest is answered, for at most timeoutMs.
+    auto awaitReply = [&]() -> bool {
+        QElapsedTimer waited;
+        waited.start();
+        const int before = dueUs.size();
+        while (dueUs.size() >= before) {
+            const qint64 left = options.timeoutMs - waited.elapsed();
+            if (left <= 0 || !collect(int(left))) return false;
+        }
+        return true;
+    };
+
+    bool usable = true;
+    for (;;) {
+        const int index = next.fetch_add(1);
+        if (index >= manifests.size()) break;
+
+        // Waits until the manifest is due, reading replies meanwhile.
+        qint64 due = 0;
+        if (options.rate > 0) {
+            due = qint64(index * 1e6 / options.rate);
+            for (qint64 wait = due - clock.nsecsElapsed() / 1000; wait > 0 && usable;
+                 wait = due - clock.nsecsElapsed() / 1000) {
+                if (dueUs.isEmpty()) QThread::usleep(quint64(wait));
+                else usable = collect(int(qMax<qint64>(1, wait / 1000)));
+            }
+        }
+        // Keeps at most window manifests in flight.
+        while (usable && dueUs.size() >= options.window) {
+            usable = awaitReply();
+        }
+        if (!usable) break;
+        // In a closed loop latency counts from the send, not from the wait for a free window slot.
+        if (options.rate <= 0) due = clock.nsecsElapsed() / 1000;
+
+        const QByteArray& manifest = manifests.at(index);
+        dueUs.insert(++seq, due);
+        socket.write(Wire::frame(Wire::Frame::Manifest, seq, manifest));
+        socket.flush();
+        ++out.sent;
+        out.bytes += manifest.size();
+        usable = collect(0);
+        if (!usable) break;
+    }
+
+    // Waits for the replies still outstanding.
+    while (usable && !dueUs.isEmpty()) {
+        usable = awaitReply();
+    }
+    if (!dueUs.isEmpty()) {
+        const QString why = socket.state() == QAbstractSocket::ConnectedState
+                            ? QStringLiteral("no reply within %1 ms").arg(options.timeoutMs)
+                            : QStringLiteral("connection: %1").arg(socket.errorString());
+        out.errors[why] += dueUs.size();
+    }
+    socket.disconnectFromHost();
+}
+
+} // namespace
+
+// This method picks the nearest-rank percentile from the sorted latencies.
+qint64 LoadReport::percentileUs(double fraction) const {
+    if (latenciesUs.isEmpty()) return 0;
+    const qsizetype rank = qsizetype(std::ceil(fraction * latenciesUs.size()));
+    return latenciesUs.at(qBound<qsizetype>(0, rank - 1, latenciesUs.size() - 1));
+}
+
+// This method starts one thread per connection, waits for all of them and merges their reports.
+LoadReport LoadRunner::run(const QVector<QByteArray>& manifests) {
+    const int connections = qMax(1, options.connections);
+    std::vector<LoadReport> partial(size_t(connections));
+    std::vector<std::unique_ptr<QThread>> threads;
+    std::atomic<int> next{0};
+    QElapsedTimer clock;
+    clock.start();
+
+    for (int c = 0; c < connections; ++c) {
+        LoadReport& out = partial[size_t(c)];
+        threads.emplace_back(QThread::create([this, &manifests, &next, &clock, &out] {
+            runConnection(options, manifests, next, clock, out);
+        }));
+        threads.back()->start();
+    }
+    for (auto& thread : threads) {
+        thread->wait();
+    }
+
+    LoadReport report;
+    report.seconds = clock.nsecsElapsed() / 1e9;
+    for (const LoadReport& p : partial) {
+        report.sent += p.sent;
+        report.acked += p.acked;
+        report.nacked += p.nacked;
+        report.containers += p.containers;
+        report.bytes += p.bytes;
+        report.latenciesUs += p.latenciesUs;
+        for (auto it = p.errors.cbegin(); it != p.errors.cend(); ++it) {
+            report.errors[it.key()] += it.value();
+        }
+    }
+    // Whatever was neither acknowledged nor rejected was lost with its connection or never sent.
+    report.failed = manifests.size() - report.acked - report.nacked;
+    if (report.sent < manifests.size()) {
+        report.errors[QStringLiteral("not sent")] += manifests.size() - report.sent;
+    }
+    std::sort(report.latenciesUs.begin(), report.latenciesUs.end());
+    return report;
+}
@@ -0,0 +1,53 @@
+#ifndef LOADRUNNER_H
+#define LOADRUNNER_H
+#include <QByteArray>
+#include <QMap>
+#include <QString>
+#include <QVector>
+#include "WireProtocol.h"
+
+// The LoadOptions struct describes how LoadRunner sends manifests.
+struct LoadOptions{
+    QString host{"127.0.0.1"};
+    quint16 port{Wire::DefaultManifestPort};
+    int connections{4};              // Parallel connections, each on its own thread.
+    double rate{0};                  // Manifests per second over all connections; 0 sends as fast as acks allow.
+    int window{16};                  // Manifests one connection may have unacknowledged at a time.
+    int timeoutMs{30000};            // How long a connection waits for a reply before giving up.
+};
+
+// The LoadReport struct is the outcome of one run.
+struct LoadReport{
+    qint64 sent{0};                  // Manifests written to a socket.
+    qint64 acked{0};                 // Manifests the server acknowledged.
+    qint64 nacked{0};                // Manifests the server rejected.
+    qint64 failed{0};                // Manifests never answered (connection lost or timed out) or never sent.
+    qint64 containers{0};            // Containers the server reported as accepted.
+    qint64 bytes{0};                 // Manifest bytes written.
+    double seconds{0};               // Wall time from the first send to the last reply.
+    QVector<qint64> latenciesUs;     // Send-to-Ack latency of every acknowledged manifest, sorted.
+    QMap<QString, qint64> errors;    // Nack reasons and connection errors with their counts.
+
+    // This method returns the latency at or below which the given fraction (0-1) of manifests were acknowledged.
+    qint64 percentileUs(double fraction) const;
+};
+
+// The LoadRunner class posts a list of manifests to the ingest port over several framed connections
+// and measures how the server keeps up. Each connection takes the next manifest from a shared counter,
+// so the list is sent once in total, and pipelines up to window manifests before waiting for replies.
+// With a target rate, manifest n is due at n / rate seconds and its latency is measured from that due
+// time rather than from the actual write, so a server that falls behind shows up in the percentiles
+// instead of silently slowing the senders down. Without a rate, latency is measured from the write.
+class LoadRunner{
+public:
+    // This is the constructor. It only stores the options.
+    explicit LoadRunner(const LoadOptions& options): options(options) {}
+
+    // This method sends every manifest and returns once all of them were answered or given up on.
+    LoadReport run(const QVector<QByteArray>& manifests);
+
+private:
+    LoadOptions options;
+};
+
+#endif // LOADRUNNER_H
@@ -0,0 +1,67 @@
+#ifndef LOCKFREEQUEUE_H
+#define LOCKFREEQUEUE_H
+#include <atomic>
+#include <utility>
+
+// The LockFreeQueue class is an unbounded multi-producer, single-consumer FIFO queue.
+// Any number of threads may call push() at the same time without taking a lock; exactly one
+// thread (for the server, the GUI thread) may call tryPop(). Each push is a single atomic exchange,
+// so producers never wait for the consumer or for each other.
+template <typename T>
+class LockFreeQueue{
+public:
+    // The constructor creates the empty stub node the queue always keeps at its tail.
+    LockFreeQueue(){
+        Node* stub = new Node;
+        m_head.store(stub, std::memory_order_relaxed);
+        m_tail = stub;
+    }
+
+    // The destructor frees every node still in the queue. No producer may be running at this point.
+    ~LockFreeQueue(){
+        T discard;
+        while (tryPop(discard)) {}
+        delete m_tail;
+    }
+
+    LockFreeQueue(const LockFreeQueue&) = delete;
+    LockFreeQueue& operator=(const LockFreeQueue&) = delete;
+
+    // This method appends a value. It may be called from any thread.
+    void push(T value){
+        Node* n = new Node;
+        n->value = std::move(value);
+        // Publishes the node as the newest one, then links the previous newest node to it.
+        Node* prev = m_head.exchange(n, std::memory_order_acq_rel);
+        prev->next.store(n, std::memory_order_release);
+        m_size.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // This method removes the oldest value into out. It returns false if the queue is empty.
+    // Only the single consumer thread may call it.
+    bool tryPop(T& out){
+        Node* tail = m_tail;
+        Node* next = tail->next.load(std::memory_order_acquire);
+        if (!next) return false;
+        out = std::move(next->value);
+        m_tail = next;
+        delete tail;
+        m_size.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // This method returns an approximate number of queued values, for statistics only.
+    long long sizeApprox() const { return m_size.load(std::memory_order_relaxed); }
+
+private:
+    struct Node{
+        std::atomic<Node*> next{nullptr};
+        T value{};
+    };
+
+    std::atomic<Node*> m_head;            // The most recently pushed node; written by producers.
+    Node* m_tail;                         // The already-consumed stub node; owned by the consumer.
+    std::atomic<long long> m_size{0};
+};
+
+#endif // LOCKFREEQUEUE_H
@@ -0,0 +1,77 @@
+#include "ManifestParser.h"
+#include <QXmlStreamReader>
+
+// This method parses the received XML data into records that can be merged into the container store.
+// A streaming reader is used so that large manifests are never expanded into a DOM tree in memory.
+ParsedManifest ManifestParser::parse(const QByteArray& xml) const {
+    ParsedManifest out;
+    QXmlStreamReader r(xml);
+
+    // Gets the root element, which should be "pallets". Any other document is accepted but carries no rows.
+    if (r.readNextStartElement() && r.name() == QLatin1String("pallets")) {
+        out.traceId = r.attributes().value(QLatin1String("traceId")).toULongLong(nullptr, 16);
+        // Iterates through each pallet element; unknown elements are skipped.
+        while (r.readNextStartElement()) {
+            if (r.name() == QLatin1String("pallet")) {
+                parsePallet(r, out.rows);
+            } else {
+                r.skipCurrentElement();
+            }
+        }
+    }
+
+    if (r.hasError()) {
+        out.rows.clear();
+        out.error = QString("Parse error %1 at %2:%3")
+                        .arg(r.errorString())
+                        .arg(r.lineNumber())
+                        .arg(r.columnNumber());
+        return out;
+    }
+    for (const ContainerRecord& rec : out.rows) {
+        out.invalidCodes += rec.code == 0;
+    }
+    out.ok = true;
+    return out;
+}
+
+// This helper reads every container element inside the current <pallet> element.
+void ManifestParser::parsePallet(QXmlStreamReader& r, QVector<ContainerRecord>& out) const {
+    const qint32 pnum = r.attributes().value(QLatin1String("number")).toInt();
+
+    // Iterates through each container element.
+    while (r.readNextStartElement()) {
+        ContainerRecord rec;
+        rec.pallet = pnum;
+        if (r.name() == QLatin1String("Box")) rec.type = ContainerType::Box;
+        else if (r.name() == QLatin1String("Cylinder")) rec.type = ContainerType::Cylinder;
+
+        // Extracts container data from the XML text elements. Only the first occurrence of each field counts.
+        bool haveCode = false;
+        while (r.readNextStartElement()) {
+            // Resolves the field before reading its text, because reading invalidates the element name.
+            const QStringView name = r.name();
+            qint32* slot = nullptr;
+            const bool isCode = name == QLatin1String("code");
+            if (name == QLatin1String("height"))        slot = &rec.height;
+            else if (name == QLatin1String("weight"))   slot = &rec.weight;
+            else if (name == QLatin1String("length"))   slot = &rec.length;
+            else if (name == QLatin1String("breadth"))  slot = &rec.breadth;
+            else if (name == QLatin1String("diameter")) slot = &rec.diameter;
+
+            const QString text = r.readElementText(QXmlStreamReader::SkipChildElements);
+            if (isCode) {
+                // Validates and packs the container code; invalid codes are stored as 0 and shown masked.
+                if (!haveCode) rec.code = ContainerCode::pack(text);
+                haveCode = true;
+            } else if (slot && *slot == ContainerRecord::NoValue) {
+                bool ok = false;
+                const int v = text.toInt(&ok);
+                if (ok) *slot = v;
+            }
+        }
+
+        // Adds the extracted record to the result.
+        out.push_back(rec);
+    }
+}
@@ -0,0 +1,31 @@
+#ifndef MANIFESTPARSER_H
+#define MANIFESTPARSER_H
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+#include "ContainerRecord.h"
+
+class QXmlStreamReader;
+
+// The ParsedManifest struct holds the result of parsing one XML manifest received from a client.
+struct ParsedManifest{
+    bool ok{false};                   // True when the document was parsed successfully.
+    QString error;                    // A human readable message describing why parsing failed.
+    QVector<ContainerRecord> rows;    // One typed record per container found in the manifest.
+    int invalidCodes{0};              // How many of the rows have an invalid code, stored masked as 0.
+    quint64 traceId{0};               // The client's trace id from the root element, or 0 (see Trace.h).
+};
+
+// The ManifestParser class turns an XML manifest into typed container records.
+// It does not touch any GUI object, so worker threads can each run their own instance.
+class ManifestParser{
+public:
+    // This method parses a complete XML document and returns the extracted records or an error.
+    ParsedManifest parse(const QByteArray& xml) const;
+
+private:
+    // This helper reads the containers of one <pallet> element into the result.
+    void parsePallet(QXmlStreamReader& r, QVector<ContainerRecord>& out) const;
+};
+
+#endif // MANIFESTPARSER_H
@@ -0,0 +1,102 @@
+#include "ManifestSynth.h"
+#include <QRandomGenerator>
+#include <QString>
+#include <QVector>
+#include <QXmlStreamWriter>
+#include <QtMath>
+#include <algorithm>
+
+namespace {
+
+// One synthetic container.
+struct Item{
+    bool cylinder{false};
+    QString code;
+    int height{0};
+    int weight{0};
+    int length{0};
+    int breadth{0};
+    int diameter{0};
+};
+
+// This helper draws a well-formed code of the given type, or one of the malformed shapes seen in practice.
+QString makeCode(QRandomGenerator& rng, bool cylinder, bool valid) {
+    const QChar type = cylinder ? QLatin1Char('C') : QLatin1Char('B');
+    const int year = 2020 + rng.bounded(11);
+    const int month = 1 + rng.bounded(12);
+    const int serial = 1 + rng.bounded(9999);
+    if (valid) {
+        return QString("%1/%2/%3%4").arg(year).arg(month, 2, 10, QLatin1Char('0')).arg(type).arg(serial);
+    }
+    switch (rng.bounded(4)) {
+    case 0:  return QString("%1/%2/%3%4").arg(year).arg(13 + rng.bounded(87)).arg(type).arg(serial);
+    case 1:  return QString("%1-%2-%3%4").arg(year).arg(month, 2, 10, QLatin1Char('0')).arg(type).arg(serial);
+    case 2:  return QString("%1/%2/X%3").arg(year).arg(month, 2, 10, QLatin1Char('0')).arg(serial);
+    default: return QString();
+    }
+}
+
+} // namespace
+
+// This method draws the containers from a generator seeded with the seed and the index, then writes
+// them the way SerializationWorker does, pallet by pallet with the pallet totals as attributes.
+QByteArray ManifestSynth::manifest(int index) const {
+    QRandomGenerator rng(options.seed * 0x9E3779B9u ^ quint32(index) * 0x85EBCA6Bu);
+    const int palletCount = qBound(1, options.palletsPerManifest, qMax(1, options.containersPerManifest));
+    QVector<QVector<Item>> pallets(palletCount);
+    for (int i = 0; i < options.containersPerManifest; ++i) {
+        Item item;
+        item.cylinder = rng.generateDouble() < options.cylinderShare;
+        item.code = makeCode(rng, item.cylinder, rng.generateDouble() < options.validCodeShare);
+        item.height = 10 + rng.bounded(290);
+        item.weight = 1 + rng.bounded(2000);
+        if (item.cylinder) {
+            item.diameter = 10 + rng.bounded(140);
+        } else {
+            item.length = 10 + rng.bounded(190);
+            item.breadth = 10 + rng.bounded(190);
+        }
+        pallets[i % palletCount].push_back(item);
+    }
+
+    QByteArray out;
+    out.reserve(options.containersPerManifest * 160 + 256);
+    QXmlStreamWriter w(&out);
+    w.setAutoFormatting(true);
+    w.writeStartDocument();
+    w.writeStartElement("pallets");
+    w.writeAttribute("NumberOfPallets", QString::number(palletCount));
+    for (int p = 0; p < palletCount; ++p) {
+        double volume = 0;
+        qint64 weight = 0;
+        for (const Item& item : pallets.at(p)) {
+            weight += item.weight;
+            volume += item.cylinder ? M_PI / 4.0 * item.diameter * item.diameter * item.height
+                                    : double(item.length) * item.breadth * item.height;
+        }
+        // Consecutive manifests move on through the pallet numbers, wrapping at options.pallets.
+        const qint64 number = (qint64(index) * palletCount + p) % qMax(1, options.pallets) + 1;
+
+        w.writeStartElement("pallet");
+        w.writeAttribute("weight", QString::number(weight));
+        w.writeAttribute("volume", QString::number(volume));
+        w.writeAttribute("number", QString::number(number));
+        for (const Item& item : pallets.at(p)) {
+            w.writeStartElement(item.cylinder ? "Cylinder" : "Box");
+            w.writeTextElement("code", item.code);
+            w.writeTextElement("height", QString::number(item.height));
+            w.writeTextElement("weight", QString::number(item.weight));
+            if (item.cylinder) {
+                w.writeTextElement("diameter", QString::number(item.diameter));
+            } else {
+                w.writeTextElement("length", QString::number(item.length));
+                w.writeTextElement("breadth", QString::number(item.breadth));
+            }
+            w.writeEndElement();
+        }
+        w.writeEndElement();
+    }
+    w.writeEndElement();
+    w.writeEndDocument();
+    return out;
+}
@@ -0,0 +1,31 @@
+#ifndef MANIFESTSYNTH_H
+#define MANIFESTSYNTH_H
+#include <QByteArray>
+#include <QtGlobal>
+
+// The SynthOptions struct describes the manifests ManifestSynth generates.
+struct SynthOptions{
+    int containersPerManifest{500};   // The size of each manifest.
+    int palletsPerManifest{25};       // How many pallets each manifest's containers are spread over.
+    int pallets{1000};                // Pallet numbers run from 1 to this; manifests cycle through them.
+    double cylinderShare{0.5};        // The fraction of containers that are cylinders.
+    double validCodeShare{0.95};      // The fraction of containers with a well-formed code.
+    quint32 seed{1};                  // Equal seeds give byte-identical manifests.
+};
+
+// The ManifestSynth class produces synthetic manifests in the client's XML format, for load testing.
+// Manifest n depends only on the options and n, so a run can be repeated exactly and manifests can be
+// generated in any order or in parallel.
+class ManifestSynth{
+public:
+    // This is the constructor. It only stores the options.
+    explicit ManifestSynth(const SynthOptions& options): options(options) {}
+
+    // This method returns manifest number index as UTF-8 XML.
+    QByteArray manifest(int index) const;
+
+private:
+    SynthOptions options;
+};
+
+#endif // MANIFESTSYNTH_H
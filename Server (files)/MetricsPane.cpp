@@ -0,0 +1,75 @@
+#include "MetricsPane.h"
+#include <QHeaderView>
+#include <QLabel>
+#include <QTableWidget>
+#include <QVBoxLayout>
+
+namespace {
+
+// This helper creates a read-only table with the given column headers and row labels.
+QTableWidget* makeTable(const QStringList& headers, const QStringList& rows, QWidget* parent){
+    auto* table = new QTableWidget(rows.size(), headers.size(), parent);
+    table->setHorizontalHeaderLabels(headers);
+    table->setVerticalHeaderLabels(rows);
+    table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    table->horizontalHeader()->setStretchLastSection(true);
+    return table;
+}
+
+// This helper formats microseconds as milliseconds.
+QString millis(qint64 us){
+    return QString::number(us / 1000.0, 'f', 2);
+}
+
+// This helper writes the texts of one row, creating the items on first use.
+void fillRow(QTableWidget* table, int row, const QStringList& texts){
+    for(int column = 0; column < texts.size(); ++column){
+        QTableWidgetItem* item = table->item(row, column);
+        if(!item){
+            item = new QTableWidgetItem;
+            item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+            table->setItem(row, column, item);
+        }
+        item->setText(texts.at(column));
+    }
+}
+
+} // namespace
+
+// The constructor lays out the counter and latency tables.
+MetricsPane::MetricsPane(QWidget* parent)
+    : QWidget(parent)
+{
+    counters = makeTable({"Total", "Per second"},
+                         {"Open connections", "Connections", "KB received", "Manifests parsed",
+                          "Manifests rejected", "Rows ingested", "Invalid codes"}, this);
+    latencies = makeTable({"p50 ms", "p99 ms", "Max ms"}, {"Parse", "Commit"}, this);
+
+    auto* layout = new QVBoxLayout(this);
+    layout->addWidget(counters);
+    layout->addWidget(new QLabel("Time per manifest", this));
+    layout->addWidget(latencies);
+
+    showMetrics(MetricsSnapshot());
+}
+
+// This method refreshes every figure. Rates cover the time since the previous call.
+void MetricsPane::showMetrics(const MetricsSnapshot& m){
+    const double seconds = (m.uptimeMs - previous.uptimeMs) / 1000.0;
+    auto rate = [seconds](qint64 now, qint64 before){
+        return seconds > 0 ? QString::number((now - before) / seconds, 'f', 1) : QString();
+    };
+
+    fillRow(counters, 0, {QString::number(m.activeConnections), QString()});
+    fillRow(counters, 1, {QString::number(m.connectionsAccepted), rate(m.connectionsAccepted, previous.connectionsAccepted)});
+    fillRow(counters, 2, {QString::number(m.bytesReceived / 1024), rate(m.bytesReceived / 1024, previous.bytesReceived / 1024)});
+    fillRow(counters, 3, {QString::number(m.manifestsParsed), rate(m.manifestsParsed, previous.manifestsParsed)});
+    fillRow(counters, 4, {QString::number(m.manifestsRejected), rate(m.manifestsRejected, previous.manifestsRejected)});
+    fillRow(counters, 5, {QString::number(m.rowsIngested), rate(m.rowsIngested, previous.rowsIngested)});
+    fillRow(counters, 6, {QString::number(m.invalidCodes), rate(m.invalidCodes, previous.invalidCodes)});
+
+    // The percentiles cover everything since start; recent spikes show in the log line and the scrape.
+    fillRow(latencies, 0, {millis(m.parseUs.percentile(0.5)), millis(m.parseUs.percentile(0.99)), millis(m.parseUs.max)});
+    fillRow(latencies, 1, {millis(m.commitUs.percentile(0.5)), millis(m.commitUs.percentile(0.99)), millis(m.commitUs.max)});
+    previous = m;
+}
@@ -0,0 +1,27 @@
+#ifndef METRICSPANE_H
+#define METRICSPANE_H
+#include <QWidget>
+#include "IngestMetrics.h"
+
+// Forward declarations to reduce compile time dependencies.
+class QTableWidget;
+
+// The MetricsPane class shows the ingest metrics next to the container table: each counter with its
+// rate since the previous refresh, and the parse and commit latency percentiles. It only displays the
+// snapshots it is handed.
+class MetricsPane : public QWidget{
+    Q_OBJECT
+public:
+    // This is the constructor for the MetricsPane.
+    explicit MetricsPane(QWidget* parent=nullptr);
+
+    // This method replaces the displayed figures; rates are computed against the previous snapshot.
+    void showMetrics(const MetricsSnapshot& metrics);
+
+private:
+    QTableWidget* counters{};       // One row per counter: total and rate.
+    QTableWidget* latencies{};      // One row per histogram: p50, p99 and maximum.
+    MetricsSnapshot previous;       // The snapshot shown last, for the rates.
+};
+
+#endif // METRICSPANE_H
@@ -0,0 +1,86 @@
+#include "MetricsServer.h"
+#include <QTcpServer>
+#include <QTcpSocket>
+#include "IngestMetrics.h"
+#include "MemoryAccounting.h"
+#include "Trace.h"
+
+// The constructor only stores the metrics; the socket is created by listen().
+MetricsServer::MetricsServer(const IngestMetrics* metrics, QObject* parent)
+    : QObject(parent), metrics(metrics)
+{
+}
+
+// This method opens the metrics port on the current thread.
+bool MetricsServer::listen(const QHostAddress& address, quint16 port, QString* error) {
+    server = new QTcpServer(this);
+    connect(server, &QTcpServer::newConnection, this, &MetricsServer::onNewConnection);
+    if (!server->listen(address, port)) {
+        if (error) *error = server->errorString();
+        return false;
+    }
+    return true;
+}
+
+// This slot accepts every pending connection.
+void MetricsServer::onNewConnection() {
+    while (server->hasPendingConnections()) {
+        QTcpSocket* sock = server->nextPendingConnection();
+        requests.insert(sock, QByteArray());
+        connect(sock, &QTcpSocket::readyRead, this, &MetricsServer::onReadyRead);
+        connect(sock, &QTcpSocket::disconnected, this, &MetricsServer::onClientDisconnected);
+    }
+}
+
+// This slot waits for the end of the request header, then answers from the request line alone.
+// Only /, /metrics and, while tracing, /trace exist; anything else gets a 404.
+void MetricsServer::onReadyRead() {
+    auto* sock = qobject_cast<QTcpSocket*>(sender());
+    if (!sock || !requests.contains(sock)) return;
+
+    QByteArray& request = requests[sock];
+    request.append(sock->readAll());
+    if (request.size() > MaxRequestBytes) {
+        requests.remove(sock);
+        respond(sock, "431 Request Header Fields Too Large", QByteArray());
+        return;
+    }
+    if (!request.contains("\r\n\r\n") && !request.contains("\n\n")) return;
+
+    const QList<QByteArray> line = request.left(request.indexOf('\n')).trimmed().split(' ');
+    requests.remove(sock);
+    const QByteArray method = line.value(0);
+    const QByteArray path = line.value(1).split('?').value(0);
+    if (method != "GET") {
+        respond(sock, "405 Method Not Allowed", QByteArray());
+    } else if (path == "/trace" && Trace::enabled()) {
+        respond(sock, "200 OK", Trace::toJson(), "application/json");
+    } else if (path != "/" && path != "/metrics") {
+        respond(sock, "404 Not Found", QByteArray());
+    } else {
+        QByteArray body = IngestMetrics::exposition(metrics->snapshot());
+        if (Memory::enabled()) body += Memory::exposition(Memory::snapshot());
+        respond(sock, "200 OK", body);
+    }
+}
+
+// This slot deletes the socket of a client that has gone.
+void MetricsServer::onClientDisconnected() {
+    auto* sock = qobject_cast<QTcpSocket*>(sender());
+    if (!sock) return;
+    requests.remove(sock);
+    sock->deleteLater();
+}
+
+// This private helper function writes the status line, the headers and the body, then closes the
+// connection once everything has been sent.
+void MetricsServer::respond(QTcpSocket* sock, const QByteArray& status, const QByteArray& body,
+                            const QByteArray& contentType) {
+    QByteArray response = "HTTP/1.1 " + status + "\r\n"
+                          "Content-Type: " + contentType + "\r\n"
+                          "Content-Length: " + QByteArray::number(body.size()) + "\r\n"
+                          "Connection: close\r\n\r\n";
+    response.append(body);
+    sock->write(response);
+    sock->disconnectFromHost();
+}
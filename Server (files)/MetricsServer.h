@@ -0,0 +1,50 @@
+#ifndef METRICSSERVER_H
+#define METRICSSERVER_H
+#include <QObject>
+#include <QHash>
+#include <QByteArray>
+#include <QHostAddress>
+
+// Forward declarations to reduce compile time dependencies.
+class QTcpServer;
+class QTcpSocket;
+class IngestMetrics;
+
+// The MetricsServer class serves the ingest metrics as plain text over HTTP, in the Prometheus text
+// format, so a monitoring system can scrape them (GET /metrics). While tracing is on (see Trace.h),
+// GET /trace returns the recorded spans as Chrome trace JSON. With memory accounting on, /metrics also
+// lists the memory of each accounted subsystem. It understands just enough HTTP to
+// answer one GET per connection and then closes it. It runs on the ingest thread next to IngestServer,
+// which creates it; building the text only reads the metrics' atomic counters.
+class MetricsServer : public QObject{
+    Q_OBJECT
+public:
+    // The largest request header accepted before the connection is dropped.
+    static constexpr int MaxRequestBytes = 8 * 1024;
+
+    // This is the constructor. The metrics must outlive the server.
+    explicit MetricsServer(const IngestMetrics* metrics, QObject* parent=nullptr);
+
+    // This method starts listening. It returns false and sets error if the port cannot be bound.
+    bool listen(const QHostAddress& address, quint16 port, QString* error);
+
+private slots:
+    // This slot accepts new scrape connections.
+    void onNewConnection();
+    // This slot collects the request and answers it once the header is complete.
+    void onReadyRead();
+    // This slot forgets a client that has disconnected.
+    void onClientDisconnected();
+
+private:
+    // This private helper function writes a complete response and closes the connection.
+    static void respond(QTcpSocket* sock, const QByteArray& status, const QByteArray& body,
+                        const QByteArray& contentType = "text/plain; version=0.0.4; charset=utf-8");
+
+private:
+    const IngestMetrics* metrics{};             // The metrics that are served.
+    QTcpServer* server{};                       // The listening socket.
+    QHash<QTcpSocket*, QByteArray> requests;    // The request bytes received so far, per client.
+};
+
+#endif // METRICSSERVER_H
@@ -0,0 +1,172 @@
+#include "QueryServer.h"
+#include <QTcpServer>
+#include <QTcpSocket>
+#include "ContainerStore.h"
+#include "IngestLog.h"
+
+namespace {
+
+// This helper converts a stored record into its wire form.
+Wire::Row toWire(const ContainerRecord& r){
+    Wire::Row w;
+    w.pallet = r.pallet;
+    w.type = quint8(r.type);
+    w.code = r.code;
+    w.height = r.height;
+    w.weight = r.weight;
+    w.length = r.length;
+    w.breadth = r.breadth;
+    w.diameter = r.diameter;
+    return w;
+}
+
+// This helper converts the store's totals into the wire form, keeping the first topCount pallets.
+Wire::Aggregates toWire(const AggregateSummary& s, quint32 topCount){
+    Wire::Aggregates a;
+    a.containers = s.containers;
+    a.pallets = s.pallets;
+    a.weight = s.weight;
+    for(size_t i = 0; i < a.types.size(); ++i){
+        a.types[i] = {s.types[i].containers, s.types[i].volume.total()};
+    }
+    for(const MonthCount& m: s.months){
+        a.months.push_back({quint16(m.year), quint8(m.month), m.containers});
+    }
+    for(const auto& p: s.heaviest){
+        if(quint32(a.heaviest.size()) >= topCount) break;
+        a.heaviest.push_back({p.first, p.second.containers, p.second.weight, p.second.volume.total()});
+    }
+    return a;
+}
+
+} // namespace
+
+// The constructor only stores the store; the socket is created by listen().
+QueryServer::QueryServer(ContainerStore* store, QObject* parent)
+    : QObject(parent), store(store)
+{
+}
+
+// This method opens the query port on the current thread.
+bool QueryServer::listen(const QHostAddress& address, quint16 port, QString* error){
+    server = new QTcpServer(this);
+    connect(server, &QTcpServer::newConnection, this, &QueryServer::onNewConnection);
+    if(!server->listen(address, port)){
+        if(error) *error = server->errorString();
+        return false;
+    }
+    return true;
+}
+
+// This slot accepts every pending query connection.
+void QueryServer::onNewConnection(){
+    while(server->hasPendingConnections()){
+        QTcpSocket* sock = server->nextPendingConnection();
+        buffers.insert(sock, QByteArray());
+        connect(sock, &QTcpSocket::readyRead, this, &QueryServer::onReadyRead);
+        connect(sock, &QTcpSocket::disconnected, this, &QueryServer::onClientDisconnected);
+    }
+}
+
+// This slot answers every request frame that has arrived completely; a client may send several at once.
+void QueryServer::onReadyRead(){
+    auto* sock = qobject_cast<QTcpSocket*>(sender());
+    if(!sock || !buffers.contains(sock)) return;
+
+    QByteArray& buffer = buffers[sock];
+    buffer.append(sock->readAll());
+    Wire::Frame type;
+    quint32 id = 0;
+    QByteArray payload;
+    for(;;){
+        const Wire::TakeResult result = Wire::takeFrame(buffer, type, id, payload);
+        if(result == Wire::TakeResult::NeedMore) break;
+        if(result == Wire::TakeResult::Malformed){
+            // The stream cannot be resynchronised after a bad length, so the connection is dropped.
+            qCWarning(lcIngest) << "Dropping query client" << sock->peerAddress().toString() << "after a malformed frame";
+            sendError(sock, 0, "Malformed frame");
+            buffers.remove(sock);
+            sock->disconnectFromHost();
+            return;
+        }
+        answer(sock, type, id, payload);
+    }
+}
+
+// This slot drops the buffer of a client that has gone away.
+void QueryServer::onClientDisconnected(){
+    auto* sock = qobject_cast<QTcpSocket*>(sender());
+    if(!sock) return;
+    buffers.remove(sock);
+    sock->deleteLater();
+}
+
+// This private helper function decodes one request and answers it from the current snapshot.
+void QueryServer::answer(QTcpSocket* sock, Wire::Frame type, quint32 id, const QByteArray& payload){
+    const std::shared_ptr<const StoreSnapshot> snap = store->readSnapshot();
+    Wire::Reader in(payload);
+
+    switch(type){
+    case Wire::Frame::QueryPallet: {
+        const qint32 pallet = in.i32();
+        if(!in.ok()) break;
+        const QPair<int, int> range = snap->pallets.value(pallet, {0, 0});
+        sendRows(sock, id, *snap, range.first, range.second);
+        return;
+    }
+    case Wire::Frame::QueryCode: {
+        const quint32 code = in.u32();
+        if(!in.ok()) break;
+        const qsizetype row = code != 0 ? snap->byCode.find(code) : CodeIndex::NotFound;
+        sendRows(sock, id, *snap, int(qMax<qsizetype>(row, 0)), row == CodeIndex::NotFound ? 0 : 1);
+        return;
+    }
+    case Wire::Frame::QueryAggregates: {
+        const quint32 topCount = in.u32();
+        if(!in.ok()) break;
+        sock->write(Wire::frame(Wire::Frame::Aggregates, id, Wire::writeAggregates(toWire(snap->totals, topCount))));
+        return;
+    }
+    case Wire::Frame::QueryPage: {
+        const quint32 first = in.u32();
+        const quint32 count = in.u32();
+        if(!in.ok()) break;
+        // Clamps the page to the rows that exist and to the largest page a client may ask for.
+        const int total = int(snap->rows.size());
+        const int from = int(qMin<quint32>(first, quint32(total)));
+        const int n = int(qMin<quint32>(qMin(count, Wire::MaxPageRows), quint32(total - from)));
+        sendRows(sock, id, *snap, from, n);
+        return;
+    }
+    default:
+        sendError(sock, id, QString("Unknown request type %1").arg(int(type)));
+        return;
+    }
+    sendError(sock, id, "Truncated request");
+}
+
+// This private helper function writes the rows in frames of at most RowsPerFrame rows.
+// An empty result is still answered with one (empty, last) frame.
+void QueryServer::sendRows(QTcpSocket* sock, quint32 id, const StoreSnapshot& snap, int first, int count){
+    int sent = 0;
+    do{
+        const int n = int(qMin<quint32>(Wire::RowsPerFrame, quint32(count - sent)));
+        QByteArray payload;
+        payload.reserve(13 + n * Wire::RowBytes);
+        Wire::Writer w(payload);
+        w.u32(quint32(count));
+        w.u32(quint32(sent));
+        w.u8(sent + n == count ? 1 : 0);
+        w.u32(quint32(n));
+        for(int i = first + sent; i < first + sent + n; ++i){
+            w.row(toWire(snap.rows.at(i)));
+        }
+        sock->write(Wire::frame(Wire::Frame::Rows, id, payload));
+        sent += n;
+    } while(sent < count);
+}
+
+// This private helper function reports a failed request to the client.
+void QueryServer::sendError(QTcpSocket* sock, quint32 id, const QString& message){
+    sock->write(Wire::frame(Wire::Frame::Error, id, message.toUtf8()));
+}
@@ -0,0 +1,51 @@
+#ifndef QUERYSERVER_H
+#define QUERYSERVER_H
+#include <QObject>
+#include <QHash>
+#include <QByteArray>
+#include <QHostAddress>
+#include <memory>
+#include "WireProtocol.h"
+
+// Forward declarations to reduce compile time dependencies.
+class QTcpServer;
+class QTcpSocket;
+class ContainerStore;
+struct StoreSnapshot;
+
+// The QueryServer class answers client queries (a pallet, a code, the aggregates or a page of rows)
+// using the binary protocol in WireProtocol.h. Every query is served from the store's published
+// snapshot, so answering never takes the lock that manifest merges use. It runs on the ingest thread
+// next to IngestServer, which creates it.
+class QueryServer : public QObject{
+    Q_OBJECT
+public:
+    // This is the constructor. The store must outlive the server.
+    explicit QueryServer(ContainerStore* store, QObject* parent=nullptr);
+
+    // This method starts listening. It returns false and sets error if the port cannot be bound.
+    bool listen(const QHostAddress& address, quint16 port, QString* error);
+
+private slots:
+    // This slot accepts new query connections.
+    void onNewConnection();
+    // This slot collects request bytes and answers every complete request frame.
+    void onReadyRead();
+    // This slot forgets a client that has disconnected.
+    void onClientDisconnected();
+
+private:
+    // This private helper function answers one request frame.
+    void answer(QTcpSocket* sock, Wire::Frame type, quint32 id, const QByteArray& payload);
+    // This private helper function streams a range of snapshot rows as Rows frames.
+    void sendRows(QTcpSocket* sock, quint32 id, const StoreSnapshot& snap, int first, int count);
+    // This private helper function sends an Error frame.
+    void sendError(QTcpSocket* sock, quint32 id, const QString& message);
+
+private:
+    ContainerStore* store{};                    // The store whose snapshots are queried.
+    QTcpServer* server{};                       // The listening socket for queries.
+    QHash<QTcpSocket*, QByteArray> buffers;     // One receive buffer per connected client socket.
+};
+
+#endif // QUERYSERVER_H
@@ -1,133 +1,167 @@
 #include "ServerWindow.h"
-#include <QTcpServer>
-#include <QTcpSocket>
+#include <QDockWidget>
+#include <QLabel>
+#include <QLineEdit>
 #include <QTableView>
+#include <QStatusBar>
+#include <QThread>
+#include <QTimer>
 #include <QVBoxLayout>
-#include <QMessageBox>
-#include <QDomDocument>
-#include <QRegularExpression>
 #include "ContainerTableModel.h"
-
-// The constructor sets up the TCP server and the UI.
-ServerWindow::ServerWindow(QWidget* parent)
-    : QMainWindow(parent),
-    current(nullptr),
-    codeRx("^[A-Z0-9]{4}$")   // Example regex: 4 alphanumeric chars
+#include "IngestServer.h"
+#include "MetricsPane.h"
+#include "SummaryPane.h"
+#include "Trace.h"
+
+// The constructor sets up the UI, starts the ingest thread and the drain timer.
+ServerWindow::ServerWindow(const IngestConfig& config, QWidget* parent)
+    : QMainWindow(parent)
 {
-    // Creates a new QTcpServer instance.
-    server = new QTcpServer(this);
-
-    // Connects the server's newConnection signal to a slot that handles incoming connections.
-    connect(server, &QTcpServer::newConnection, this, &ServerWindow::onNewConnection);
-
-    // Attempts to start the server listening on the local host and port 6164.
-    if (!server->listen(QHostAddress::LocalHost, 6164)) {
-        QMessageBox::critical(this, "Server", "Cannot listen on 6164");
-    }
+    // Creates the shared store that parsed manifests are merged into.
+    store = new ContainerStore();
 
-    // Initializes the data model and table view, and sets the table view as the central widget.
+    // Initializes the data model, the filter box and the table view below it.
     model = new ContainerTableModel(this);
-    view = new QTableView(this);
+    auto* central = new QWidget(this);
+    filterEdit = new QLineEdit(central);
+    filterEdit->setPlaceholderText("Filter, e.g. weight > 500, code 2026/10/B");
+    filterEdit->setClearButtonEnabled(true);
+    connect(filterEdit, &QLineEdit::returnPressed, this, &ServerWindow::applyFilter);
+    view = new QTableView(central);
     view->setModel(model);
-    setCentralWidget(view);
-
-    // Sets the window title.
-    setWindowTitle("Container Server (127.0.0.1:6164)");
-}
-
-// The destructor ensures that the current socket is properly cleaned up when the server window is closed.
-ServerWindow::~ServerWindow() {
-    if (current) {
-        current->disconnectFromHost();
-        current->deleteLater();
-        current = nullptr;
+    // Clicking a header sorts through ContainerTableModel::sort, which compares typed values.
+    view->setSortingEnabled(true);
+    auto* layout = new QVBoxLayout(central);
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->addWidget(filterEdit);
+    layout->addWidget(view);
+    setCentralWidget(central);
+
+    // Docks the summary pane on the right; it is refreshed from the store's totals, not from the rows.
+    summaryPane = new SummaryPane(this);
+    auto* summaryDock = new QDockWidget("Summary", this);
+    summaryDock->setWidget(summaryPane);
+    addDockWidget(Qt::RightDockWidgetArea, summaryDock);
+
+    // Docks the ingest metrics below the summary; they are read from atomic counters, never under a lock.
+    metricsPane = new MetricsPane(this);
+    auto* metricsDock = new QDockWidget("Ingest", this);
+    metricsDock->setWidget(metricsPane);
+    addDockWidget(Qt::RightDockWidgetArea, metricsDock);
+
+    // Moves the ingest server onto its own thread; it is deleted there when the thread finishes.
+    ingestThread = new QThread(this);
+    ingest = new IngestServer(store, config);
+    ingest->moveToThread(ingestThread);
+    connect(ingestThread, &QThread::started, ingest, &IngestServer::start);
+    connect(ingestThread, &QThread::finished, ingest, &QObject::deleteLater);
+    connect(ingest, &IngestServer::ingestError, this, &ServerWindow::onIngestError);
+    ingestThread->start();
+
+    // Drains parsed batches into the model at a fixed rate instead of once per manifest.
+    drainTimer = new QTimer(this);
+    drainTimer->setInterval(DrainIntervalMs);
+    connect(drainTimer, &QTimer::timeout, this, &ServerWindow::drainChanges);
+    drainTimer->start();
+
+    // Refreshes the summary at a slower rate; reading the totals is cheap but people cannot read faster.
+    summaryTimer = new QTimer(this);
+    summaryTimer->setInterval(SummaryIntervalMs);
+    connect(summaryTimer, &QTimer::timeout, this, &ServerWindow::refreshSummary);
+    summaryTimer->start();
+
+    // Sets the window title, naming the local socket too when same-host clients can use it.
+    QString title = QString("Container Server (%1:%2").arg(config.address.toString()).arg(config.port);
+    if (!config.localName.isEmpty()) title += QString(", local %1").arg(config.localName);
+    setWindowTitle(title + ")");
+    statusBar()->showMessage("Ready");
+    if (Memory::enabled()) {
+        memoryLabel = new QLabel(this);
+        statusBar()->addPermanentWidget(memoryLabel);
     }
 }
 
-// This slot is triggered when a new client connects to the server.
-void ServerWindow::onNewConnection() {
-    // Disconnects and deletes any previous connection before accepting a new one.
-    if (current) {
-        current->disconnect(this);
-        current->deleteLater();
-    }
-
-    // Accepts the new connection.
-    current = server->nextPendingConnection();
-
-    // Connects the new socket's readyRead signal to a slot to process incoming data.
-    connect(current, &QTcpSocket::readyRead, this, &ServerWindow::onReadyRead);
+// The destructor stops the ingest thread; the ingest server and its parser tasks finish before the store goes.
+ServerWindow::~ServerWindow() {
+    drainTimer->stop();
+    summaryTimer->stop();
+    ingestThread->quit();
+    ingestThread->wait();
+    delete store;
+    store = nullptr;
 }
 
-// This slot is triggered when data is available to be read from the socket.
-void ServerWindow::onReadyRead() {
-    if (!current) return;
-
-    // Reads all available data from the socket.
-    QByteArray data = current->readAll();
-
-    // Calls a helper function to parse the XML and populate the table.
-    parseXmlAndPopulate(data);
+// This slot shows an ingest error in the status bar. The core has already logged it, and a modal box
+// per rejected manifest would block the window while many clients are posting.
+void ServerWindow::onIngestError(const QString& message) {
+    statusBar()->showMessage(message, 10000);
 }
 
-// This private helper function parses the received XML data and populates the table model.
-void ServerWindow::parseXmlAndPopulate(const QByteArray& xml) {
-    QDomDocument doc;
-
-    // Use the new overload that returns a ParseResult (Qt 6.5+).
-    QDomDocument::ParseResult result = doc.setContent(xml);
-
-    if (!result) {
-        QMessageBox::warning(this, "XML",
-                             QString("Parse error %1 at %2:%3")
-                                 .arg(result.errorMessage)
-                                 .arg(result.errorLine)
-                                 .arg(result.errorColumn));
+// This slot filters the table by the conditions in the filter box; an empty box shows every row.
+void ServerWindow::applyFilter() {
+    ContainerFilter filter;
+    QString error;
+    if (!ContainerFilter::parse(filterEdit->text(), filter, &error)) {
+        statusBar()->showMessage(error, 10000);
         return;
     }
+    model->setFilter(filter);
+    statusBar()->showMessage(QString("%1 of %2 containers shown").arg(model->visibleRows()).arg(model->totalRows()), 10000);
+}
 
-    // Gets the root element, which should be "pallets".
-    auto pallets = doc.documentElement();
-    if (pallets.tagName() != "pallets") return;
-
-    QVector<QVector<QString>> rows;
-    // Finds all "pallet" elements within the document.
-    auto palletNodes = pallets.elementsByTagName("pallet");
-
-    // Iterates through each pallet element.
-    for (int i = 0; i < palletNodes.count(); ++i) {
-        auto pElem = palletNodes.at(i).toElement();
-        const QString pnum = pElem.attribute("number");
-
-        // Gets the child nodes (containers) of the current pallet element.
-        auto children = pElem.childNodes();
-
-        // Iterates through each container element.
-        for (int j = 0; j < children.count(); ++j) {
-            auto e = children.at(j).toElement();
-            if (e.isNull()) continue;
-
-            const QString type = e.tagName();
-
-            // Extracts container data from XML text elements.
-            QString code = e.firstChildElement("code").text();
-
-            // Validates the container code using a regular expression.
-            if (!codeRx.match(code).hasMatch()) {
-                code = "****"; // Masks invalid codes.
-            }
-
-            QString height   = e.firstChildElement("height").text();
-            QString weight   = e.firstChildElement("weight").text();
-            QString length   = e.firstChildElement("length").text();
-            QString breadth  = e.firstChildElement("breadth").text();
-            QString diameter = e.firstChildElement("diameter").text();
+// This slot copies the current totals from the store into the summary pane and the ingest metrics into theirs.
+void ServerWindow::refreshSummary() {
+    TRACE_SPAN("refreshSummary");
+    summaryPane->showSummary(store->summary(HeaviestPallets));
+    metricsPane->showMetrics(ingest->metrics().snapshot());
+    if (memoryLabel) {
+        const Memory::Snapshot now = Memory::snapshot();
+        memoryLabel->setText(Memory::summary(now, shownMemory));
+        shownMemory = now;
+    }
+}
 
-            // Adds the extracted data as a new row to the data vector.
-            rows.push_back({pnum, type, code, height, weight, length, breadth, diameter});
+// This slot moves up to MaxRowsPerTick changes from the store's queue into the model.
+void ServerWindow::drainChanges() {
+    const qint64 startUs = Trace::enabled() ? Trace::nowUs() : 0;
+    int budget = MaxRowsPerTick;
+    while (budget > 0) {
+        // Fetches the next batch once the previous one has been applied completely.
+        if (carryPos >= carry.size()) {
+            carry.clear();
+            carryPos = 0;
+            if (!store->popChanges(carry)) break;
         }
+        const int take = qMin(budget, int(carry.size()) - carryPos);
+        applyChanges(carry.mid(carryPos, take));
+        carryPos += take;
+        budget -= take;
+    }
+    // Idle ticks are not recorded, so they do not push real work out of the trace buffer.
+    if (startUs != 0 && budget < MaxRowsPerTick) {
+        Trace::record("drainChanges", startUs, Trace::nowUs() - startUs, 0);
     }
+}
 
-    // Sets the new data on the table model to refresh the view.
-    model->setRows(rows);
+// This private helper function replays store changes on the model, batching consecutive upserts and removals.
+void ServerWindow::applyChanges(const QVector<StoreChange>& changes) {
+    QVector<ContainerRecord> upserts;
+    QVector<quint64> removals;
+    auto flush = [&] {
+        model->upsertRows(upserts);
+        model->removeKeys(removals);
+        upserts.clear();
+        removals.clear();
+    };
+    for (const StoreChange& c : changes) {
+        // Keeps the original order whenever an upsert and a removal of the same batch could interact.
+        if (c.removed) {
+            if (!upserts.isEmpty()) flush();
+            removals.push_back(c.record.key);
+        } else {
+            if (!removals.isEmpty()) flush();
+            upserts.push_back(c.record);
+        }
+    }
+    flush();
 }
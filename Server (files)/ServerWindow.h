@@ -2,41 +2,73 @@
 #define SERVERWINDOW_H
 #include <QMainWindow>
 #include <QVector>
-#include <QRegularExpression>
+#include "ContainerStore.h"
+#include "IngestConfig.h"
+#include "MemoryAccounting.h"
 
 // Forward declarations to reduce compile time dependencies.
-class QTcpServer;
-class QTcpSocket;
+class QLabel;
+class QLineEdit;
 class QTableView;
+class QThread;
+class QTimer;
 class ContainerTableModel;
+class IngestServer;
+class MetricsPane;
+class SummaryPane;
 
-// The ServerWindow class represents the main window for a simple TCP server.
-// It is responsible for listening for incoming connections, receiving data, and displaying it.
+// The ServerWindow class is the optional windowed viewer of the ingest core.
+// Receiving and parsing manifests runs on background threads (see IngestServer); this window only
+// drains the store's change queue into the table model at a fixed frame rate, so a large manifest
+// never freezes the UI. The same core runs without any window in the ServerDaemon target.
 class ServerWindow : public QMainWindow{
     Q_OBJECT
 public:
+    // How often the change queue is drained, in milliseconds (about 60 times per second).
+    static constexpr int DrainIntervalMs = 16;
+    // The most rows applied to the model in one tick. Larger batches are spread over several ticks.
+    static constexpr int MaxRowsPerTick = 20000;
+    // How often the summary pane is refreshed, in milliseconds.
+    static constexpr int SummaryIntervalMs = 500;
+    // How many of the heaviest pallets the summary pane lists.
+    static constexpr int HeaviestPallets = 10;
+
     // This is the constructor for the ServerWindow.
-    explicit ServerWindow(QWidget* parent=nullptr);
-    // The destructor ensures that the TCP server and other allocated resources are properly cleaned up.
+    explicit ServerWindow(const IngestConfig& config = IngestConfig(), QWidget* parent=nullptr);
+    // The destructor stops the ingest thread before the store it writes into is deleted.
     ~ServerWindow() override;
 
 private slots:
-    // This slot is automatically called by the QTcpServer when a new client connects.
-    void onNewConnection();
-    // This slot is automatically called by the QTcpSocket when new data is available to be read.
-    void onReadyRead();
+    // This slot applies at most MaxRowsPerTick queued changes to the model.
+    void drainChanges();
+    // This slot reports an ingest error raised on one of the background threads.
+    void onIngestError(const QString& message);
+    // This slot shows the store's current totals in the summary pane, the ingest metrics in theirs and,
+    // with memory accounting on, the accounted memory in the status bar.
+    void refreshSummary();
+    // This slot parses the filter box and applies it to the table.
+    void applyFilter();
 
 private:
-    // This private helper function parses an XML byte array and populates the table model with the data.
-    void parseXmlAndPopulate(const QByteArray& xml);
+    // This private helper function applies store changes to the table model.
+    void applyChanges(const QVector<StoreChange>& changes);
 
 private:
     // Private member variables for the server's functionality.
-    QTcpServer* server{};             // The TCP server object that listens for connections.
-    QTcpSocket* current{};            // A pointer to the currently connected client socket.
-    QTableView* view{};               // The table view widget for displaying container data.
-    ContainerTableModel* model{};     // The custom data model for the table view.
-    QRegularExpression codeRx{QRegularExpression(R"(^(20\d{2})/(0[1-9]|1[0-2])/[BC](\d{1,4})$)")}; // A regular expression for validating container codes.
+    ContainerStore* store{};                    // The store the ingest threads merge their results into.
+    QThread* ingestThread{};                    // The thread that owns the sockets.
+    IngestServer* ingest{};                     // Accepts clients and parses manifests; lives on ingestThread.
+    QTimer* drainTimer{};                       // Fires every DrainIntervalMs to drain the change queue.
+    QVector<StoreChange> carry;                 // A popped batch that did not fit into the previous tick.
+    int carryPos{0};                            // The next unapplied change in carry.
+    QLineEdit* filterEdit{};                    // The filter conditions typed above the table.
+    QTableView* view{};                         // The table view widget for displaying container data.
+    ContainerTableModel* model{};               // The custom data model for the table view.
+    SummaryPane* summaryPane{};                 // The running totals, docked beside the table.
+    MetricsPane* metricsPane{};                 // The ingest counters and latencies, docked below the totals.
+    QTimer* summaryTimer{};                     // Fires every SummaryIntervalMs to refresh the summary pane.
+    QLabel* memoryLabel{};                      // The accounted memory; only created when accounting is on.
+    Memory::Snapshot shownMemory;               // The memory counters shown last, for the allocation rates.
 };
 
 #endif // SERVERWINDOW_H
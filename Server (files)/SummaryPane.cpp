@@ -0,0 +1,89 @@
+#include "SummaryPane.h"
+#include <QHeaderView>
+#include <QLabel>
+#include <QTableWidget>
+#include <QVBoxLayout>
+
+namespace {
+
+// This helper creates a read-only table with the given column headers.
+QTableWidget* makeTable(const QStringList& headers, QWidget* parent){
+    auto* table = new QTableWidget(0, headers.size(), parent);
+    table->setHorizontalHeaderLabels(headers);
+    table->verticalHeader()->hide();
+    table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    table->horizontalHeader()->setStretchLastSection(true);
+    return table;
+}
+
+// This helper formats a volume without decimals, which the posted whole-number dimensions do not have.
+QString volumeText(const VolumeSum& v){
+    return QString::number(v.total(), 'f', 0);
+}
+
+} // namespace
+
+// The constructor lays out the totals line and the three tables.
+SummaryPane::SummaryPane(QWidget* parent)
+    : QWidget(parent)
+{
+    totals = new QLabel(this);
+    types = makeTable({"Type", "Containers", "Volume"}, this);
+    heaviest = makeTable({"Pallet", "Containers", "Weight", "Volume"}, this);
+    months = makeTable({"Month", "Containers"}, this);
+
+    // The type table always has one row per container type.
+    types->setRowCount(3);
+
+    auto* layout = new QVBoxLayout(this);
+    layout->addWidget(totals);
+    layout->addWidget(new QLabel("By type", this));
+    layout->addWidget(types);
+    layout->addWidget(new QLabel("Heaviest pallets", this));
+    layout->addWidget(heaviest);
+    layout->addWidget(new QLabel("By month", this));
+    layout->addWidget(months);
+
+    showSummary(AggregateSummary());
+}
+
+// This private helper function writes the texts of one row, creating the items on first use.
+void SummaryPane::setRow(QTableWidget* table, int row, const QStringList& texts){
+    for(int column = 0; column < texts.size(); ++column){
+        QTableWidgetItem* item = table->item(row, column);
+        if(!item){
+            item = new QTableWidgetItem;
+            table->setItem(row, column, item);
+        }
+        item->setText(texts.at(column));
+    }
+}
+
+// This method refreshes every figure from the summary.
+void SummaryPane::showSummary(const AggregateSummary& summary){
+    if(summary.revision == shownRevision && summary.revision != 0) return;
+    shownRevision = summary.revision;
+
+    totals->setText(QString("%1 containers on %2 pallets, total weight %3")
+                        .arg(summary.containers).arg(summary.pallets).arg(summary.weight));
+
+    const ContainerType order[] = {ContainerType::Box, ContainerType::Cylinder, ContainerType::Unknown};
+    for(int row = 0; row < 3; ++row){
+        const TypeTotals& t = summary.types[size_t(order[row])];
+        setRow(types, row, {typeName(order[row]), QString::number(t.containers), volumeText(t.volume)});
+    }
+
+    heaviest->setRowCount(summary.heaviest.size());
+    for(int row = 0; row < summary.heaviest.size(); ++row){
+        const auto& p = summary.heaviest.at(row);
+        setRow(heaviest, row, {QString::number(p.first), QString::number(p.second.containers),
+                               QString::number(p.second.weight), volumeText(p.second.volume)});
+    }
+
+    months->setRowCount(summary.months.size());
+    for(int row = 0; row < summary.months.size(); ++row){
+        const MonthCount& m = summary.months.at(row);
+        setRow(months, row, {QString("%1/%2").arg(m.year).arg(m.month, 2, 10, QLatin1Char('0')),
+                             QString::number(m.containers)});
+    }
+}
@@ -0,0 +1,34 @@
+#ifndef SUMMARYPANE_H
+#define SUMMARYPANE_H
+#include <QWidget>
+#include "ContainerAggregates.h"
+
+// Forward declarations to reduce compile time dependencies.
+class QLabel;
+class QTableWidget;
+
+// The SummaryPane class shows the store's running totals next to the container table:
+// overall counts, totals per container type, the heaviest pallets and containers per month.
+// It only displays an AggregateSummary it is handed and never reads the rows itself.
+class SummaryPane : public QWidget{
+    Q_OBJECT
+public:
+    // This is the constructor for the SummaryPane.
+    explicit SummaryPane(QWidget* parent=nullptr);
+
+    // This method replaces the displayed figures. A summary with an unchanged revision is ignored.
+    void showSummary(const AggregateSummary& summary);
+
+private:
+    // This private helper function fills one table row with the given texts.
+    static void setRow(QTableWidget* table, int row, const QStringList& texts);
+
+private:
+    QLabel* totals{};               // The grand totals line.
+    QTableWidget* types{};          // One row per container type.
+    QTableWidget* heaviest{};       // The heaviest pallets, heaviest first.
+    QTableWidget* months{};         // Containers per code month, oldest first.
+    quint64 shownRevision{0};       // The revision of the summary on display.
+};
+
+#endif // SUMMARYPANE_H
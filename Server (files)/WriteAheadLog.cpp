@@ -0,0 +1,390 @@
+#include "WriteAheadLog.h"
+#include <QDir>
+#include <QElapsedTimer>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QtEndian>
+#include <algorithm>
+#include <utility>
+#include "Crc32.h"
+#include "IngestLog.h"
+#ifdef Q_OS_WIN
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+
+// On-disk layout. All integers are little-endian.
+// Record:   magic "CTW1" | payload bytes | CRC-32 of payload | row count | payload
+// Payload:  pallet (i32) followed by row count rows of 25 bytes:
+//           type (u8) | code (u32) | height | weight | length | breadth | diameter (i32 each)
+// Snapshot: magic "CTSN" | format version | first segment to replay | reserved | records...
+constexpr quint32 RecordMagic = 0x31575443;    // "CTW1"
+constexpr quint32 SnapshotMagic = 0x4E535443;  // "CTSN"
+constexpr quint32 SnapshotVersion = 1;
+constexpr int HeaderBytes = 16;
+constexpr int RowBytes = 25;
+
+// This helper writes a 32-bit value and advances the output pointer.
+inline void put32(char*& p, quint32 v){ qToLittleEndian(v, p); p += 4; }
+// This helper reads a 32-bit value and advances the input pointer.
+inline quint32 get32(const char*& p){ const quint32 v = qFromLittleEndian<quint32>(p); p += 4; return v; }
+
+// This function encodes one pallet replacement as a complete record.
+QByteArray encodeRecord(qint32 pallet, const QVector<ContainerRecord>& rows){
+    const qsizetype payload = 4 + rows.size() * RowBytes;
+    QByteArray out(HeaderBytes + payload, Qt::Uninitialized);
+    char* p = out.data() + HeaderBytes;
+    put32(p, quint32(pallet));
+    for (const ContainerRecord& r : rows) {
+        *p++ = char(quint8(r.type));
+        put32(p, r.code);
+        put32(p, quint32(r.height));
+        put32(p, quint32(r.weight));
+        put32(p, quint32(r.length));
+        put32(p, quint32(r.breadth));
+        put32(p, quint32(r.diameter));
+    }
+    char* h = out.data();
+    put32(h, RecordMagic);
+    put32(h, quint32(payload));
+    put32(h, Crc32::of(out.constData() + HeaderBytes, payload));
+    put32(h, quint32(rows.size()));
+    return out;
+}
+
+// This function decodes the record at offset. It returns the offset just past the record, or -1 if the
+// bytes there are not a complete, intact record (for example the tail of an interrupted write).
+qint64 decodeRecord(const char* data, qint64 size, qint64 offset, qint32& pallet, QVector<ContainerRecord>& rows){
+    if (size - offset < HeaderBytes) return -1;
+    const char* h = data + offset;
+    const quint32 magic = get32(h);
+    const quint32 payload = get32(h);
+    const quint32 crc = get32(h);
+    const quint32 count = get32(h);
+    if (magic != RecordMagic || payload != 4 + quint64(count) * RowBytes) return -1;
+    if (size - offset - HeaderBytes < qint64(payload)) return -1;
+    const char* p = data + offset + HeaderBytes;
+    if (Crc32::of(p, payload) != crc) return -1;
+
+    pallet = qint32(get32(p));
+    rows.resize(count);
+    for (ContainerRecord& r : rows) {
+        r.pallet = pallet;
+        r.type = ContainerType(quint8(*p++));
+        r.code = get32(p);
+        r.height = qint32(get32(p));
+        r.weight = qint32(get32(p));
+        r.length = qint32(get32(p));
+        r.breadth = qint32(get32(p));
+        r.diameter = qint32(get32(p));
+    }
+    return offset + HeaderBytes + payload;
+}
+
+// This function forces written data onto the disk. QFile::flush() only empties Qt's own buffer.
+bool syncFile(QFile& f){
+    if (!f.flush()) return false;
+#ifdef Q_OS_WIN
+    return _commit(f.handle()) == 0;
+#else
+    return ::fsync(f.handle()) == 0;
+#endif
+}
+
+} // namespace
+
+// The constructor only records the options; nothing touches the disk until replay() or open().
+WriteAheadLog::WriteAheadLog(const Options& options)
+    : m_options(options)
+{
+}
+
+// The destructor lets the writer drain and sync the pending bytes, then stops both threads.
+WriteAheadLog::~WriteAheadLog(){
+    {
+        QMutexLocker locker(&m_mutex);
+        m_running = false;
+        m_wakeWriter.wakeAll();
+        m_durable.wakeAll();
+    }
+    if (m_writer.joinable()) m_writer.join();
+    if (m_compactor.joinable()) m_compactor.join();
+    m_segment.close();
+}
+
+// This helper builds the file name of a segment.
+QString WriteAheadLog::segmentPath(quint32 index) const{
+    return QDir(m_options.directory).filePath(QString("wal-%1.log").arg(index, 8, 10, QLatin1Char('0')));
+}
+
+// This helper finds the existing segment files and returns their numbers in ascending order.
+QVector<quint32> WriteAheadLog::segmentIndexes() const{
+    QVector<quint32> out;
+    const QStringList names = QDir(m_options.directory).entryList({"wal-*.log"}, QDir::Files, QDir::Name);
+    for (const QString& name : names) {
+        bool ok = false;
+        const quint32 index = name.mid(4, name.size() - 8).toUInt(&ok);
+        if (ok) out.push_back(index);
+    }
+    std::sort(out.begin(), out.end());
+    return out;
+}
+
+// This method rebuilds the store from the snapshot and the segments written after it.
+qint64 WriteAheadLog::replay(const ApplyFn& apply, QString* error){
+    QElapsedTimer timer;
+    timer.start();
+    const QDir dir(m_options.directory);
+    if (!dir.exists()) return 0;
+
+    qint64 rowsReplayed = 0;
+    quint32 firstSegment = 0;
+    qint32 pallet = 0;
+    QVector<ContainerRecord> rows;
+
+    // Loads the snapshot first. It is written atomically, so any damage in it is a real error.
+    QFile snap(dir.filePath("snapshot.bin"));
+    if (snap.exists()) {
+        if (!snap.open(QIODevice::ReadOnly)) {
+            if (error) *error = QString("Cannot open %1: %2").arg(snap.fileName(), snap.errorString());
+            return -1;
+        }
+        const qint64 size = snap.size();
+        const uchar* map = size > 0 ? snap.map(0, size) : nullptr;
+        const char* data = reinterpret_cast<const char*>(map);
+        const char* h = data;
+        if (!map || size < HeaderBytes || get32(h) != SnapshotMagic || get32(h) != SnapshotVersion) {
+            if (error) *error = QString("%1 is not a valid snapshot").arg(snap.fileName());
+            return -1;
+        }
+        firstSegment = get32(h);
+        qint64 offset = HeaderBytes;
+        while (offset < size) {
+            offset = decodeRecord(data, size, offset, pallet, rows);
+            if (offset < 0) {
+                if (error) *error = QString("%1 is damaged").arg(snap.fileName());
+                return -1;
+            }
+            rowsReplayed += rows.size();
+            apply(pallet, std::move(rows));
+            rows = {};
+        }
+        snap.unmap(const_cast<uchar*>(map));
+    }
+
+    // Replays the segments written after the snapshot, oldest first.
+    const QVector<quint32> segments = segmentIndexes();
+    for (int i = 0; i < segments.size(); ++i) {
+        const quint32 index = segments.at(i);
+        if (index < firstSegment) {
+            // Left over from a compaction that was interrupted before it could delete it.
+            QFile::remove(segmentPath(index));
+            continue;
+        }
+        m_segmentIndex = qMax(m_segmentIndex, index);
+
+        QFile seg(segmentPath(index));
+        if (!seg.open(QIODevice::ReadWrite)) {
+            if (error) *error = QString("Cannot open %1: %2").arg(seg.fileName(), seg.errorString());
+            return -1;
+        }
+        const qint64 size = seg.size();
+        if (size == 0) continue;
+        const uchar* map = seg.map(0, size);
+        if (!map) {
+            if (error) *error = QString("Cannot map %1: %2").arg(seg.fileName(), seg.errorString());
+            return -1;
+        }
+        const char* data = reinterpret_cast<const char*>(map);
+        qint64 offset = 0;
+        while (offset < size) {
+            const qint64 next = decodeRecord(data, size, offset, pallet, rows);
+            if (next < 0) break;
+            offset = next;
+            rowsReplayed += rows.size();
+            apply(pallet, std::move(rows));
+            rows = {};
+        }
+        seg.unmap(const_cast<uchar*>(map));
+
+        if (offset < size) {
+            // A crash during a write leaves a partial record at the very end of the newest segment.
+            // Anywhere else, the rest of the segment is unreadable and is skipped.
+            qCWarning(lcIngest) << "Discarding" << (size - offset) << "damaged bytes at the end of" << seg.fileName();
+            if (i == segments.size() - 1) seg.resize(offset);
+        }
+    }
+    m_segmentIndex = qMax(m_segmentIndex, firstSegment > 0 ? firstSegment - 1 : 0u);
+
+    qCInfo(lcIngest) << "Replayed" << rowsReplayed << "rows from" << m_options.directory
+                     << "in" << timer.elapsed() << "ms";
+    return rowsReplayed;
+}
+
+// This method creates the directory if needed, starts a new segment and the writer thread.
+bool WriteAheadLog::open(const SnapshotFn& snapshotSource, QString* error){
+    if (!QDir().mkpath(m_options.directory)) {
+        if (error) *error = QString("Cannot create %1").arg(m_options.directory);
+        return false;
+    }
+    m_snapshotSource = snapshotSource;
+    const QVector<quint32> existing = segmentIndexes();
+    if (!existing.isEmpty()) m_segmentIndex = qMax(m_segmentIndex, existing.last());
+    if (!rotate()) {
+        if (error) *error = QString("Cannot create %1: %2").arg(m_segment.fileName(), m_segment.errorString());
+        return false;
+    }
+    m_running = true;
+    m_writer = std::thread(&WriteAheadLog::writerLoop, this);
+    return true;
+}
+
+// This method copies an encoded record into the pending buffer and wakes the writer.
+quint64 WriteAheadLog::append(qint32 pallet, const QVector<ContainerRecord>& rows){
+    // Encodes outside the lock so appenders only contend for the copy.
+    const QByteArray record = encodeRecord(pallet, rows);
+    QMutexLocker locker(&m_mutex);
+    if (m_failed) return 0;
+    m_pending += record;
+    m_wakeWriter.wakeOne();
+    return ++m_appendedSeq;
+}
+
+// This method waits for the writer to report that seq has been synced, or that it never will be.
+bool WriteAheadLog::waitDurable(quint64 seq){
+    QMutexLocker locker(&m_mutex);
+    while (m_durableSeq < seq && m_running && !m_failed) {
+        m_durable.wait(&m_mutex);
+    }
+    return m_durableSeq >= seq;
+}
+
+// This helper closes the current segment and starts the next one.
+bool WriteAheadLog::rotate(){
+    if (m_segment.isOpen()) {
+        syncFile(m_segment);
+        m_segment.close();
+    }
+    QMutexLocker locker(&m_mutex);
+    ++m_segmentIndex;
+    m_segment.setFileName(segmentPath(m_segmentIndex));
+    return m_segment.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Unbuffered);
+}
+
+// The writer thread. Whatever was appended while the previous fsync was running is written as one
+// batch and synced once; that is what makes the commit a group commit.
+void WriteAheadLog::writerLoop(){
+    QMutexLocker locker(&m_mutex);
+    for (;;) {
+        while (m_running && m_pending.isEmpty() && m_rotateTo == 0) {
+            m_wakeWriter.wait(&m_mutex);
+        }
+        if (!m_running && m_pending.isEmpty()) break;
+
+        const QByteArray batch = std::exchange(m_pending, QByteArray());
+        const quint64 upto = m_appendedSeq;
+        const bool rotateRequested = m_rotateTo != 0;
+        locker.unlock();
+
+        bool written = true;
+        bool rotated = true;
+        if (!batch.isEmpty()) {
+            written = m_segment.write(batch) == batch.size() && syncFile(m_segment);
+            if (written) m_bytesSinceSnapshot += batch.size();
+            else qCCritical(lcIngest) << "Write-ahead log write failed:" << m_segment.errorString();
+        }
+        if (written && (rotateRequested || m_segment.size() >= m_options.segmentBytes)) {
+            rotated = rotate();
+            if (!rotated) qCCritical(lcIngest) << "Cannot start new log segment:" << m_segment.errorString();
+        }
+
+        locker.relock();
+        if (written) m_durableSeq = upto;
+        if (!written || !rotated) {
+            // A failed batch may be partly on disk, and later records cannot be placed after it safely,
+            // so the log stops here: the batch stays not durable and appenders are refused from now on.
+            m_failed = true;
+            m_pending.clear();
+            qCCritical(lcIngest) << "Write-ahead log stopped; changes are no longer made durable";
+            break;
+        }
+        if (m_rotateTo != 0 && m_segmentIndex >= m_rotateTo) m_rotateTo = 0;
+        m_durable.wakeAll();
+
+        // Starts a background compaction once enough log has accumulated since the last snapshot.
+        if (m_running && !m_compacting && m_snapshotSource && m_bytesSinceSnapshot >= m_options.compactBytes) {
+            m_compacting = true;
+            m_bytesSinceSnapshot = 0;
+            if (m_compactor.joinable()) m_compactor.join();
+            m_compactor = std::thread([this] { compact(); });
+        }
+    }
+    m_durable.wakeAll();
+}
+
+// This method writes the current store contents to snapshot.bin and deletes the segments before it.
+void WriteAheadLog::compact(){
+    QElapsedTimer timer;
+    timer.start();
+    quint32 firstSegment = 0;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (!m_running) {
+            m_compacting = false;
+            return;
+        }
+        // Everything appended from now on goes to a new segment, which the snapshot will not replace.
+        firstSegment = m_segmentIndex + 1;
+        m_rotateTo = firstSegment;
+        m_wakeWriter.wakeOne();
+        while (m_segmentIndex < firstSegment && m_running && !m_failed) {
+            m_durable.wait(&m_mutex);
+        }
+        if (!m_running || m_failed) {
+            m_compacting = false;
+            return;
+        }
+    }
+
+    // Every change logged before the rotation is already in the store, so the snapshot covers it.
+    // Changes made while the snapshot is taken are also in the new segment; replaying them again is
+    // harmless because each record replaces a whole pallet.
+    const QVector<ContainerRecord> rows = m_snapshotSource();
+
+    QSaveFile out(QDir(m_options.directory).filePath("snapshot.bin"));
+    bool ok = out.open(QIODevice::WriteOnly);
+    if (ok) {
+        QByteArray header(HeaderBytes, Qt::Uninitialized);
+        char* h = header.data();
+        put32(h, SnapshotMagic);
+        put32(h, SnapshotVersion);
+        put32(h, firstSegment);
+        put32(h, 0);
+        ok = out.write(header) == header.size();
+        // The store returns rows ordered by pallet, so each pallet is one contiguous run.
+        for (qsizetype i = 0; ok && i < rows.size();) {
+            qsizetype j = i;
+            while (j < rows.size() && rows.at(j).pallet == rows.at(i).pallet) ++j;
+            const QByteArray record = encodeRecord(rows.at(i).pallet, rows.mid(i, j - i));
+            ok = out.write(record) == record.size();
+            i = j;
+        }
+        // QSaveFile syncs and atomically renames on commit, so a crash leaves the old snapshot intact.
+        ok = ok && out.commit();
+    }
+
+    if (ok) {
+        for (quint32 index : segmentIndexes()) {
+            if (index < firstSegment) QFile::remove(segmentPath(index));
+        }
+        qCInfo(lcIngest) << "Compacted" << rows.size() << "rows into a snapshot in" << timer.elapsed() << "ms";
+    } else {
+        qCWarning(lcIngest) << "Snapshot failed:" << out.errorString();
+    }
+
+    QMutexLocker locker(&m_mutex);
+    m_compacting = false;
+}
@@ -0,0 +1,101 @@
+#ifndef WRITEAHEADLOG_H
+#define WRITEAHEADLOG_H
+#include <QByteArray>
+#include <QFile>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+#include <QWaitCondition>
+#include <functional>
+#include <thread>
+#include "ContainerRecord.h"
+
+// The WriteAheadLog class makes the server's store survive restarts.
+// Every pallet replacement accepted by ContainerStore is appended as one checksummed binary record to
+// the current segment file (wal-00000001.log, wal-00000002.log, ...). A single writer thread writes
+// everything appended while the previous fsync was running and then syncs once (group commit), so
+// many parser threads share the cost of each fsync.
+// When enough log has accumulated, the current store contents are written to snapshot.bin and the
+// segments it covers are deleted. At startup replay() maps the snapshot and the remaining segments
+// into memory and feeds every record back into the store.
+// If a write, an fsync or the start of a new segment fails, the log is broken for good: nothing more is
+// written, append() refuses records and waitDurable() reports failure for anything not already synced.
+class WriteAheadLog{
+public:
+    // A sequence number that never becomes durable, for callers that must report a refused append.
+    static constexpr quint64 NeverDurable = ~quint64(0);
+
+    // The tunable limits of the log.
+    struct Options{
+        QString directory;                        // Where segments and the snapshot are kept.
+        qint64 segmentBytes{64 * 1024 * 1024};    // A new segment is started once the current one is this big.
+        qint64 compactBytes{512 * 1024 * 1024};   // Log written since the last snapshot that triggers compaction.
+    };
+
+    // The callback replay() uses to hand one logged pallet back to the store.
+    using ApplyFn = std::function<void(qint32 pallet, QVector<ContainerRecord>&& rows)>;
+    // The callback compaction uses to obtain the current store contents.
+    using SnapshotFn = std::function<QVector<ContainerRecord>()>;
+
+    explicit WriteAheadLog(const Options& options);
+    // The destructor writes and syncs everything appended so far before returning.
+    ~WriteAheadLog();
+
+    WriteAheadLog(const WriteAheadLog&) = delete;
+    WriteAheadLog& operator=(const WriteAheadLog&) = delete;
+
+    // This method replays the snapshot and every segment, in order. A torn record at the end of the
+    // last segment (from a crash mid-write) is cut off. It must be called before open().
+    // It returns the number of container rows replayed, or -1 on error.
+    qint64 replay(const ApplyFn& apply, QString* error);
+
+    // This method starts a fresh segment and the writer thread. It returns false on error.
+    bool open(const SnapshotFn& snapshotSource, QString* error);
+
+    // This method queues one pallet replacement. It only copies bytes and never waits for the disk.
+    // The returned sequence number can be passed to waitDurable(); it is 0 if the log is broken.
+    quint64 append(qint32 pallet, const QVector<ContainerRecord>& rows);
+
+    // This method blocks until everything up to the given sequence number has been synced to disk.
+    // It returns false if that will never happen because the log broke or was closed first.
+    bool waitDurable(quint64 seq);
+
+private:
+    // This helper writes a snapshot and deletes the segments it makes redundant. It runs on its own
+    // thread, started by the writer once compactBytes of log have been written since the last snapshot.
+    void compact();
+    // The writer thread's loop: write pending bytes, rotate if needed, fsync, wake waiters.
+    void writerLoop();
+    // This helper closes the current segment and opens the next one. Called with m_mutex unlocked.
+    bool rotate();
+    // This helper returns the path of a segment file.
+    QString segmentPath(quint32 index) const;
+    // This helper lists the indexes of the segment files on disk, in ascending order.
+    QVector<quint32> segmentIndexes() const;
+
+private:
+    Options m_options;
+    SnapshotFn m_snapshotSource;
+
+    // State shared between appenders, the writer thread and compaction.
+    QMutex m_mutex;
+    QWaitCondition m_wakeWriter;           // Signalled when bytes are appended or a rotation is requested.
+    QWaitCondition m_durable;              // Signalled after each fsync.
+    QByteArray m_pending;                  // Encoded records not yet handed to the writer.
+    quint64 m_appendedSeq{0};              // Sequence number of the last appended record.
+    quint64 m_durableSeq{0};               // Sequence number of the last synced record.
+    quint32 m_rotateTo{0};                 // When non-zero, the writer must switch to at least this segment.
+    bool m_running{false};
+    bool m_compacting{false};              // Set by the writer when it starts a compaction thread.
+    bool m_failed{false};                  // Set by the writer when a write, fsync or rotation fails.
+
+    // State owned by the writer thread.
+    QFile m_segment;
+    quint32 m_segmentIndex{0};
+    qint64 m_bytesSinceSnapshot{0};
+
+    std::thread m_writer;
+    std::thread m_compactor;
+};
+
+#endif // WRITEAHEADLOG_H
@@ -0,0 +1,56 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include "ContainerStore.h"
+#include "IngestConfig.h"
+#include "IngestLog.h"
+#include "IngestServer.h"
+#include "Trace.h"
+#include "MemoryAccounting.h"
+
+// Entry point of the headless server. It runs the ingest core on a QCoreApplication event loop,
+// takes its configuration from the command line and reports everything through the log.
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("Container Server Daemon");
+
+    // Prefixes every log line with a timestamp and category so the output can go straight to a log file.
+    qSetMessagePattern("%{time yyyy-MM-ddThh:mm:ss.zzz} %{type} %{category}: %{message}");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Headless container ingest server.");
+    parser.addHelpOption();
+    IngestConfig::addOptions(parser);
+    parser.process(app);
+
+    IngestConfig config;
+    QString error;
+    if (!IngestConfig::fromParser(parser, config, &error)) {
+        qCCritical(lcIngest).noquote() << error;
+        return 2;
+    }
+
+    // With CARGO_MEMORY=1 set, counts memory per subsystem for the metrics port and the log.
+    Memory::enableFromEnvironment();
+
+    // With CARGO_TRACE=<file> set, records trace spans and writes them to that file on exit; while
+    // running, they can also be fetched from the metrics port.
+    const QString tracePath = Trace::enableFromEnvironment("Container Server Daemon");
+    if (!tracePath.isEmpty()) {
+        QObject::connect(&app, &QCoreApplication::aboutToQuit, [tracePath] {
+            QString error;
+            if (!Trace::dump(tracePath, &error)) qCWarning(lcIngest).noquote() << "Cannot write the trace:" << error;
+        });
+    }
+
+    // Without a viewer nobody consumes the change queue, so the store does not fill it.
+    ContainerStore store;
+    store.setPublishChanges(false);
+
+    // The ingest server lives on the main thread here; parsing still happens on its worker pool.
+    IngestServer server(&store, config);
+    if (!server.start()) {
+        return 1;
+    }
+    return app.exec();
+}
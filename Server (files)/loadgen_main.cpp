@@ -0,0 +1,200 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QFile>
+#include <QTcpSocket>
+#include <QTextStream>
+#include "LoadRunner.h"
+#include "ManifestSynth.h"
+
+namespace {
+
+// This helper reads every *.xml file of a directory, in name order, as one manifest each.
+bool loadReplay(const QString& dirPath, QVector<QByteArray>& out, QString* error) {
+    QDir dir(dirPath);
+    const QStringList names = dir.entryList({"*.xml"}, QDir::Files, QDir::Name);
+    if (names.isEmpty()) {
+        *error = QString("No .xml manifests in %1").arg(QDir::toNativeSeparators(dir.absolutePath()));
+        return false;
+    }
+    for (const QString& name : names) {
+        QFile file(dir.filePath(name));
+        if (!file.open(QIODevice::ReadOnly)) {
+            *error = QString("Cannot read %1: %2").arg(file.fileName(), file.errorString());
+            return false;
+        }
+        out.push_back(file.readAll());
+    }
+    return true;
+}
+
+// This helper writes the manifests to a directory as manifest-NNNNNN.xml, so a synthetic run can be
+// replayed later or posted with other tools.
+bool saveManifests(const QString& dirPath, const QVector<QByteArray>& manifests, QString* error) {
+    QDir dir;
+    if (!dir.mkpath(dirPath)) {
+        *error = QString("Cannot create %1").arg(dirPath);
+        return false;
+    }
+    for (int i = 0; i < manifests.size(); ++i) {
+        QFile file(QDir(dirPath).filePath(QString("manifest-%1.xml").arg(i, 6, 10, QLatin1Char('0'))));
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) || file.write(manifests.at(i)) != manifests.at(i).size()) {
+            *error = QString("Cannot write %1: %2").arg(file.fileName(), file.errorString());
+            return false;
+        }
+    }
+    return true;
+}
+
+// This helper asks the server's metrics port for its memory counters and returns the cargo_memory_
+// lines. It returns nothing if the port does not answer or the server runs without CARGO_MEMORY.
+QStringList fetchMemory(const QString& host, quint16 port, int timeoutMs) {
+    QTcpSocket sock;
+    sock.connectToHost(host, port);
+    if (!sock.waitForConnected(timeoutMs)) return {};
+    sock.write("GET /metrics HTTP/1.1\r\nHost: " + host.toUtf8() + "\r\nConnection: close\r\n\r\n");
+    QByteArray response;
+    while (sock.waitForReadyRead(timeoutMs)) response += sock.readAll();
+    response += sock.readAll();
+
+    QStringList lines;
+    for (const QByteArray& line : response.split('\n')) {
+        if (line.startsWith("cargo_memory_")) lines.push_back(QString::fromUtf8(line.trimmed()));
+    }
+    return lines;
+}
+
+// This helper reads a numeric option and checks its range.
+template<typename T>
+bool readNumber(const QCommandLineParser& parser, const QCommandLineOption& option, T low, T high, T& value, QString* error) {
+    if (!parser.isSet(option)) return true;
+    bool ok = false;
+    const double v = parser.value(option).toDouble(&ok);
+    if (!ok || v < double(low) || v > double(high)) {
+        *error = QString("--%1 must be between %2 and %3").arg(option.names().constFirst()).arg(low).arg(high);
+        return false;
+    }
+    value = T(v);
+    return true;
+}
+
+} // namespace
+
+// Entry point of the load generator. It builds the manifests first (synthetic or replayed from disk),
+// so generating them is not part of the measurement, then posts them and prints a report.
+// The exit code is 0 if every manifest was acknowledged, 1 otherwise and 2 for bad arguments.
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("Container Server Load");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Posts synthetic or recorded manifests to a container server and reports "
+                                     "throughput and latency.");
+    parser.addHelpOption();
+    const QCommandLineOption hostOption("host", "Server address (default 127.0.0.1).", "address", "127.0.0.1");
+    const QCommandLineOption portOption("port", "Manifest port (default 6164).", "port");
+    const QCommandLineOption connectionsOption("connections", "Parallel connections (default 4).", "count");
+    const QCommandLineOption rateOption("rate", "Target manifests per second over all connections (default 0, "
+                                        "as fast as the server answers).", "per-second");
+    const QCommandLineOption windowOption("window", "Unacknowledged manifests per connection (default 16).", "count");
+    const QCommandLineOption timeoutOption("timeout-ms", "Reply timeout (default 30000).", "ms");
+    const QCommandLineOption manifestsOption("manifests", "Manifests to post (default 1000, or every replayed file "
+                                             "once; replayed files repeat to reach the count).", "count");
+    const QCommandLineOption containersOption("containers", "Containers per synthetic manifest (default 500).", "count");
+    const QCommandLineOption palletsPerOption("pallets-per-manifest", "Pallets per synthetic manifest (default 25).", "count");
+    const QCommandLineOption palletsOption("pallets", "Distinct pallet numbers to cycle through (default 1000).", "count");
+    const QCommandLineOption cylindersOption("cylinders", "Fraction of cylinders, 0-1 (default 0.5).", "fraction");
+    const QCommandLineOption validOption("valid", "Fraction of well-formed codes, 0-1 (default 0.95).", "fraction");
+    const QCommandLineOption seedOption("seed", "Seed of the synthetic manifests (default 1).", "seed");
+    const QCommandLineOption replayOption("replay", "Post the *.xml manifests of a directory instead.", "directory");
+    const QCommandLineOption saveOption("save", "Also write the manifests to a directory.", "directory");
+    const QCommandLineOption dryRunOption("dry-run", "Build (and save) the manifests without posting them.");
+    const QCommandLineOption metricsPortOption("metrics-port", "Metrics port to read the server's memory counters "
+                                               "from after the run (default 6166, 0 to skip).", "port");
+    parser.addOptions({hostOption, portOption, connectionsOption, rateOption, windowOption, timeoutOption,
+                       manifestsOption, containersOption, palletsPerOption, palletsOption, cylindersOption,
+                       validOption, seedOption, replayOption, saveOption, dryRunOption, metricsPortOption});
+    parser.process(app);
+
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+    LoadOptions load;
+    SynthOptions synth;
+    int manifestCount = parser.isSet(replayOption) ? 0 : 1000;
+    quint16 metricsPort = 6166;
+    QString error;
+    load.host = parser.value(hostOption);
+    const bool ok = readNumber<quint16>(parser, portOption, 1, 65535, load.port, &error)
+                    && readNumber(parser, connectionsOption, 1, 1024, load.connections, &error)
+                    && readNumber(parser, rateOption, 0.0, 1e7, load.rate, &error)
+                    && readNumber(parser, windowOption, 1, 4096, load.window, &error)
+                    && readNumber(parser, timeoutOption, 100, 3600000, load.timeoutMs, &error)
+                    && readNumber(parser, manifestsOption, 1, 100000000, manifestCount, &error)
+                    && readNumber(parser, containersOption, 1, 10000000, synth.containersPerManifest, &error)
+                    && readNumber(parser, palletsPerOption, 1, 100000, synth.palletsPerManifest, &error)
+                    && readNumber(parser, palletsOption, 1, 100000000, synth.pallets, &error)
+                    && readNumber(parser, cylindersOption, 0.0, 1.0, synth.cylinderShare, &error)
+                    && readNumber(parser, validOption, 0.0, 1.0, synth.validCodeShare, &error)
+                    && readNumber<quint32>(parser, seedOption, 0, 0xFFFFFFFFu, synth.seed, &error)
+                    && readNumber<quint16>(parser, metricsPortOption, 0, 65535, metricsPort, &error);
+    if (!ok) {
+        err << error << Qt::endl;
+        return 2;
+    }
+
+    QVector<QByteArray> manifests;
+    if (parser.isSet(replayOption)) {
+        QVector<QByteArray> files;
+        if (!loadReplay(parser.value(replayOption), files, &error)) {
+            err << error << Qt::endl;
+            return 2;
+        }
+        const int count = manifestCount > 0 ? manifestCount : files.size();
+        manifests.reserve(count);
+        for (int i = 0; i < count; ++i) manifests.push_back(files.at(i % files.size()));
+    } else {
+        const ManifestSynth synthesizer(synth);
+        manifests.reserve(manifestCount);
+        for (int i = 0; i < manifestCount; ++i) manifests.push_back(synthesizer.manifest(i));
+    }
+    qint64 totalBytes = 0;
+    for (const QByteArray& m : manifests) totalBytes += m.size();
+    out << QString("Prepared %1 manifests, %2 MB").arg(manifests.size()).arg(totalBytes / 1e6, 0, 'f', 1) << Qt::endl;
+
+    if (parser.isSet(saveOption)) {
+        if (!saveManifests(parser.value(saveOption), manifests, &error)) {
+            err << error << Qt::endl;
+            return 2;
+        }
+        out << "Saved to " << QDir::toNativeSeparators(parser.value(saveOption)) << Qt::endl;
+    }
+    if (parser.isSet(dryRunOption)) return 0;
+
+    out << QString("Posting to %1:%2 over %3 connections").arg(load.host).arg(load.port).arg(load.connections);
+    if (load.rate > 0) out << QString(" at %1 manifests/s").arg(load.rate);
+    out << Qt::endl;
+
+    const LoadReport r = LoadRunner(load).run(manifests);
+    const double seconds = qMax(r.seconds, 1e-9);
+    out << QString("Manifests: %1 sent, %2 acknowledged, %3 rejected, %4 failed")
+               .arg(r.sent).arg(r.acked).arg(r.nacked).arg(r.failed) << Qt::endl;
+    out << QString("Elapsed: %1 s").arg(r.seconds, 0, 'f', 3) << Qt::endl;
+    out << QString("Throughput: %1 manifests/s, %2 containers/s, %3 MB/s")
+               .arg(r.acked / seconds, 0, 'f', 1)
+               .arg(r.containers / seconds, 0, 'f', 0)
+               .arg(r.bytes / seconds / 1e6, 0, 'f', 2) << Qt::endl;
+    out << QString("Latency: p50 %1 ms, p99 %2 ms, max %3 ms")
+               .arg(r.percentileUs(0.50) / 1000.0, 0, 'f', 2)
+               .arg(r.percentileUs(0.99) / 1000.0, 0, 'f', 2)
+               .arg(r.percentileUs(1.0) / 1000.0, 0, 'f', 2) << Qt::endl;
+    for (auto it = r.errors.cbegin(); it != r.errors.cend(); ++it) {
+        out << QString("  %1: %2").arg(it.key()).arg(it.value()) << Qt::endl;
+    }
+    if (metricsPort != 0) {
+        const QStringList memory = fetchMemory(load.host, metricsPort, 2000);
+        if (!memory.isEmpty()) out << "Server memory:" << Qt::endl;
+        for (const QString& line : memory) out << "  " << line << Qt::endl;
+    }
+    return r.acked == manifests.size() ? 0 : 1;
+}
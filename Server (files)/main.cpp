@@ -1,7 +1,38 @@
 #include <QApplication>
+#include <QCommandLineParser>
+#include <QMessageBox>
 #include "ServerWindow.h"
+#include "IngestConfig.h"
+#include "Trace.h"
+#include "MemoryAccounting.h"
 
 int main(int argc, char* argv[])
-{ QApplication app(argc, argv); ServerWindow w; w.show();
+{ QApplication app(argc, argv);
+    QApplication::setApplicationName("Container Server");
+
+    // Accepts the same options as the headless daemon so both can be pointed at the same port.
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Container server with a live table of received manifests.");
+    parser.addHelpOption();
+    IngestConfig::addOptions(parser);
+    parser.process(app);
+
+    IngestConfig config;
+    QString error;
+    if (!IngestConfig::fromParser(parser, config, &error)) {
+        QMessageBox::critical(nullptr, "Server", error);
+        return 2;
+    }
+
+    // With CARGO_MEMORY=1 set, counts the table model's memory; the status bar and the metrics port show it.
+    Memory::enableFromEnvironment();
+
+    // With CARGO_TRACE=<file> set, records trace spans and writes them to that file on exit.
+    const QString tracePath = Trace::enableFromEnvironment("Container Server");
+    if (!tracePath.isEmpty()) {
+        QObject::connect(&app, &QCoreApplication::aboutToQuit, [tracePath] { Trace::dump(tracePath, nullptr); });
+    }
+
+    ServerWindow w(config); w.show();
     return app.exec();
 }
@@ -0,0 +1,60 @@
+#ifndef CONTAINERCODE_H
+#define CONTAINERCODE_H
+#include <QString>
+#include <QStringView>
+#include <QtGlobal>
+
+// The ContainerCode namespace packs codes of the form YYYY/MM/[BC]NNNN into 32 bits.
+// Bit layout, most significant first: year-2000 (7 bits), month (4), type (1), serial (14),
+// serial digit count - 1 (2). Packed values therefore sort by year, month, type and serial,
+// and 0 is never a valid code, which lets it stand for "invalid".
+// The client and the server share this header because the query protocol carries packed codes.
+namespace ContainerCode{
+
+// This function validates and packs a code. It returns 0 when the text is not a valid code.
+inline quint32 pack(QStringView s){
+    // The shortest valid code is YYYY/MM/B1 and the longest YYYY/MM/B1234.
+    if (s.size() < 10 || s.size() > 13) return 0;
+    auto digit = [&](int i) {
+        const char16_t u = s[i].unicode();
+        return (u >= u'0' && u <= u'9') ? int(u - u'0') : -1;
+    };
+    const int y2 = digit(2), y3 = digit(3), m0 = digit(5), m1 = digit(6);
+    if (digit(0) != 2 || digit(1) != 0 || y2 < 0 || y3 < 0) return 0;
+    if (s[4] != QLatin1Char('/') || s[7] != QLatin1Char('/')) return 0;
+    if (m0 < 0 || m1 < 0) return 0;
+    const int month = m0 * 10 + m1;
+    if (month < 1 || month > 12) return 0;
+    quint32 type;
+    if (s[8] == QLatin1Char('B')) type = 0;
+    else if (s[8] == QLatin1Char('C')) type = 1;
+    else return 0;
+    const int digits = s.size() - 9;
+    int serial = 0;
+    for (int i = 9; i < s.size(); ++i) {
+        const int d = digit(i);
+        if (d < 0) return 0;
+        serial = serial * 10 + d;
+    }
+    return (quint32(y2 * 10 + y3) << 21) | (quint32(month) << 17) | (type << 16)
+         | (quint32(serial) << 2) | quint32(digits - 1);
+}
+
+// These helpers decode the individual fields of a packed (valid) code.
+inline int year(quint32 c) { return 2000 + int(c >> 21); }
+inline int month(quint32 c) { return int((c >> 17) & 0xF); }
+inline QChar typeChar(quint32 c) { return (c >> 16) & 1 ? QLatin1Char('C') : QLatin1Char('B'); }
+inline int serial(quint32 c) { return int((c >> 2) & 0x3FFF); }
+
+// This function turns a packed code back into its text form. Invalid codes are shown masked.
+inline QString format(quint32 c){
+    if (c == 0) return QStringLiteral("****");
+    const int digits = int(c & 3) + 1;
+    return QString::number(year(c)) + QLatin1Char('/')
+         + QString::number(month(c)).rightJustified(2, QLatin1Char('0')) + QLatin1Char('/')
+         + typeChar(c) + QString::number(serial(c)).rightJustified(digits, QLatin1Char('0'));
+}
+
+} // namespace ContainerCode
+
+#endif // CONTAINERCODE_H
@@ -0,0 +1,39 @@
+#ifndef CRC32_H
+#define CRC32_H
+#include <QtGlobal>
+#include <array>
+
+// The Crc32 namespace computes the standard CRC-32 (IEEE 802.3, as used by zlib and PNG).
+// qChecksum() only offers CRC-16, which is too weak to detect torn writes in large log records.
+namespace Crc32{
+
+// This function builds the 256-entry lookup table once, at compile time.
+constexpr std::array<quint32, 256> makeTable(){
+    std::array<quint32, 256> t{};
+    for (quint32 i = 0; i < 256; ++i) {
+        quint32 c = i;
+        for (int k = 0; k < 8; ++k) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        t[i] = c;
+    }
+    return t;
+}
+
+inline constexpr std::array<quint32, 256> table = makeTable();
+
+// This function continues a checksum over more data. Start with crc = 0.
+inline quint32 update(quint32 crc, const char* data, qsizetype len){
+    crc = ~crc;
+    for (qsizetype i = 0; i < len; ++i) {
+        crc = table[(crc ^ quint8(data[i])) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+// This function returns the checksum of one buffer.
+inline quint32 of(const char* data, qsizetype len){
+    return update(0, data, len);
+}
+
+} // namespace Crc32
+
+#endif // CRC32_H
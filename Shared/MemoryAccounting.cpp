@@ -0,0 +1,170 @@
+#include "MemoryAccounting.h"
+#include <QElapsedTimer>
+#include <QStringList>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+// The counters of one domain. Only live is updated with a read-modify-write; peak follows it loosely.
+struct Counters{
+    std::atomic<qint64> live{0};
+    std::atomic<qint64> peak{0};
+    std::atomic<qint64> allocations{0};
+    std::atomic<qint64> allocatedBytes{0};
+};
+
+std::array<Counters, Memory::DomainCount>& counters(){
+    static std::array<Counters, Memory::DomainCount> c;
+    return c;
+}
+
+const QElapsedTimer& uptime(){
+    static const QElapsedTimer timer = []{ QElapsedTimer t; t.start(); return t; }();
+    return timer;
+}
+
+// The innermost Scope's domain on this thread, or -1.
+thread_local int scopeDomain = -1;
+
+// The header in front of every Tracked object. Its size keeps the object aligned like malloc's blocks.
+struct alignas(alignof(std::max_align_t)) Header{
+    qint64 size;
+    quint8 domain;
+    bool counted;
+};
+
+} // namespace
+
+// This function reads CARGO_MEMORY.
+bool Memory::enableFromEnvironment(){
+    const QByteArray value = qgetenv(EnvironmentVariable);
+    const bool on = !value.isEmpty() && value != "0";
+    active.store(on, std::memory_order_relaxed);
+    uptime();
+    return on;
+}
+
+// This function names a domain.
+const char* Memory::domainName(Domain d){
+    switch(d){
+    case Domain::Containers: return "containers";
+    case Domain::Snapshots:  return "snapshots";
+    case Domain::XmlBuffers: return "xml_buffers";
+    case Domain::ModelRows:  return "model_rows";
+    case Domain::Store:      return "store";
+    case Domain::StoreSnapshots: return "store_snapshots";
+    case Domain::Uploads:    return "uploads";
+    }
+    return "unknown";
+}
+
+// This function counts an allocation and raises the peak if needed.
+void Memory::charge(Domain d, qint64 bytes){
+    Counters& c = counters()[size_t(d)];
+    const qint64 live = c.live.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    c.allocations.fetch_add(1, std::memory_order_relaxed);
+    c.allocatedBytes.fetch_add(bytes, std::memory_order_relaxed);
+    qint64 peak = c.peak.load(std::memory_order_relaxed);
+    while(live > peak && !c.peak.compare_exchange_weak(peak, live, std::memory_order_relaxed)){
+    }
+}
+
+// This function counts a release.
+void Memory::release(Domain d, qint64 bytes){
+    counters()[size_t(d)].live.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+// This function copies every domain's counters.
+Memory::Snapshot Memory::snapshot(){
+    Snapshot s;
+    s.uptimeMs = uptime().elapsed();
+    for(int i = 0; i < DomainCount; ++i){
+        const Counters& c = counters()[size_t(i)];
+        DomainStats& d = s.domains[size_t(i)];
+        d.live = c.live.load(std::memory_order_relaxed);
+        d.peak = c.peak.load(std::memory_order_relaxed);
+        d.allocations = c.allocations.load(std::memory_order_relaxed);
+        d.allocatedBytes = c.allocatedBytes.load(std::memory_order_relaxed);
+    }
+    return s;
+}
+
+// This function lists the domains that have allocated anything, in KB, with allocations per second.
+QString Memory::summary(const Snapshot& now, const Snapshot& before){
+    const double seconds = (now.uptimeMs - before.uptimeMs) / 1000.0;
+    QStringList parts;
+    for(int i = 0; i < DomainCount; ++i){
+        const DomainStats& d = now.domains[size_t(i)];
+        if(d.allocations == 0) continue;
+        const qint64 allocations = d.allocations - before.domains[size_t(i)].allocations;
+        parts.push_back(QString("%1 %2 KB (peak %3 KB, %4 alloc/s)")
+                            .arg(QString::fromLatin1(domainName(Domain(i))))
+                            .arg(d.live / 1024).arg(d.peak / 1024)
+                            .arg(seconds > 0 ? allocations / seconds : 0.0, 0, 'f', 1));
+    }
+    return parts.isEmpty() ? QString("no accounted memory") : parts.join(", ");
+}
+
+// This function writes one labelled series per domain for each counter.
+QByteArray Memory::exposition(const Snapshot& s){
+    struct Series{ const char* name; const char* type; const char* help; qint64 DomainStats::*field; };
+    static const Series series[] = {
+        {"cargo_memory_live_bytes", "gauge", "Bytes allocated and not yet released, per subsystem.", &DomainStats::live},
+        {"cargo_memory_peak_bytes", "gauge", "Highest live bytes so far, per subsystem.", &DomainStats::peak},
+        {"cargo_memory_allocations_total", "counter", "Allocations so far, per subsystem.", &DomainStats::allocations},
+        {"cargo_memory_allocated_bytes_total", "counter", "Bytes allocated so far, per subsystem.", &DomainStats::allocatedBytes},
+    };
+    QByteArray out;
+    for(const Series& m: series){
+        out += QByteArray("# HELP ") + m.name + ' ' + m.help + "\n# TYPE " + m.name + ' ' + m.type + '\n';
+        for(int i = 0; i < DomainCount; ++i){
+            out += QByteArray(m.name) + "{domain=\"" + domainName(Domain(i)) + "\"} "
+                   + QByteArray::number(s.domains[size_t(i)].*m.field) + '\n';
+        }
+    }
+    return out;
+}
+
+// The constructor overrides the thread's domain; the destructor restores the outer one.
+Memory::Scope::Scope(Domain d): m_previous(scopeDomain){
+    scopeDomain = int(d);
+}
+
+Memory::Scope::~Scope(){
+    scopeDomain = m_previous;
+}
+
+// This function returns the thread's current domain.
+Memory::Domain Memory::currentDomain(Domain fallback){
+    return scopeDomain < 0 ? fallback : Domain(scopeDomain);
+}
+
+// This function allocates the object behind a header, so deallocate() knows what to uncount even if
+// accounting was off when the object was made.
+void* Memory::allocate(std::size_t size, Domain fallback){
+    void* block = std::malloc(sizeof(Header) + size);
+    if(!block) throw std::bad_alloc();
+    Header* h = static_cast<Header*>(block);
+    h->size = qint64(size);
+    h->domain = quint8(currentDomain(fallback));
+    h->counted = enabled();
+    if(h->counted) charge(Domain(h->domain), h->size);
+    return h + 1;
+}
+
+// This function uncounts and frees an object made by allocate().
+void Memory::deallocate(void* p) noexcept{
+    if(!p) return;
+    Header* h = static_cast<Header*>(p) - 1;
+    if(h->counted) release(Domain(h->domain), h->size);
+    std::free(h);
+}
+
+// This method moves the charge to the new size.
+void Memory::Charge::set(qint64 bytes){
+    if(!enabled() || bytes == m_bytes) return;
+    if(bytes > m_bytes) charge(m_domain, bytes - m_bytes);
+    else release(m_domain, m_bytes - bytes);
+    m_bytes = bytes;
+}
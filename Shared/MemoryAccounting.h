@@ -0,0 +1,115 @@
+#ifndef MEMORYACCOUNTING_H
+#define MEMORYACCOUNTING_H
+#include <QByteArray>
+#include <QString>
+#include <QtGlobal>
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+// The Memory namespace attributes memory to a few subsystems ("domains") so that growth can be traced
+// to its owner: live bytes, peak bytes and allocations per domain. It is opt-in: with CARGO_MEMORY unset,
+// nothing is counted and the hooks cost one relaxed load.
+// Objects are counted exactly by deriving from Tracked, which gives the class an operator new that tags
+// each allocation with its domain. The domain can be overridden for a stretch of code with a Scope, so the
+// same class is counted under another domain there (container clones made for a backup count as snapshots).
+// Qt containers allocate with malloc, out of reach of operator new, so their buffers are counted with a
+// Charge kept next to them and updated with their capacity.
+namespace Memory{
+
+// The accounted subsystems.
+enum class Domain : quint8{
+    Containers,     // Client container objects (Box, Cylinder).
+    Snapshots,      // Backups kept by the client's Caretaker.
+    XmlBuffers,     // Manifest XML built by the client.
+    ModelRows,      // The server table model's columns and index.
+    Store,          // The server store's records, indexes and per-pallet blocks.
+    StoreSnapshots, // The copies of the server store that queries read.
+    Uploads,        // Chunked uploads the server is still reassembling.
+};
+constexpr int DomainCount = 7;
+
+// The environment variable that turns accounting on.
+constexpr char EnvironmentVariable[] = "CARGO_MEMORY";
+
+// Whether allocations are counted. Read with enabled().
+inline std::atomic<bool> active{false};
+
+// This function tells whether allocations are counted.
+inline bool enabled(){ return active.load(std::memory_order_relaxed); }
+// This function turns accounting on if CARGO_MEMORY is set (to anything but 0) and returns whether it is on.
+// Call it once at startup, before anything accounted is allocated.
+bool enableFromEnvironment();
+// This function returns a domain's name as used in the metrics, such as "model_rows".
+const char* domainName(Domain d);
+
+// These functions count bytes allocated to and released from a domain.
+void charge(Domain d, qint64 bytes);
+void release(Domain d, qint64 bytes);
+
+// The DomainStats struct holds the counters of one domain.
+struct DomainStats{
+    qint64 live{0};             // Bytes allocated and not yet released.
+    qint64 peak{0};             // The highest live value so far.
+    qint64 allocations{0};      // Allocations (or growths of a Charge) so far.
+    qint64 allocatedBytes{0};   // Bytes allocated so far, released or not.
+};
+
+// The Snapshot struct is a copy of every domain's counters.
+struct Snapshot{
+    qint64 uptimeMs{0};
+    std::array<DomainStats, DomainCount> domains;
+};
+
+// This function copies the counters.
+Snapshot snapshot();
+// This function describes the domains in use in one line, with allocation rates since the earlier snapshot.
+QString summary(const Snapshot& now, const Snapshot& before);
+// This function renders the counters in the Prometheus text format.
+QByteArray exposition(const Snapshot& s);
+
+// The Scope class makes the calling thread count Tracked objects under another domain while it lives.
+class Scope{
+public:
+    explicit Scope(Domain d);
+    ~Scope();
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+private:
+    int m_previous;
+};
+
+// This function returns the domain set by the innermost Scope on this thread, or fallback without one.
+Domain currentDomain(Domain fallback);
+
+// These functions allocate and free a block with a header recording its size and domain.
+void* allocate(std::size_t size, Domain fallback);
+void deallocate(void* p) noexcept;
+
+// The Tracked struct gives a class (and every class derived from it) an accounted operator new.
+template<Domain D>
+struct Tracked{
+    static void* operator new(std::size_t size){ return allocate(size, D); }
+    static void operator delete(void* p) noexcept{ deallocate(p); }
+};
+
+// The Charge class accounts a buffer it does not own, such as a Qt container's storage. Set it to the
+// buffer's size whenever that changes; it releases whatever it holds when destroyed.
+class Charge{
+public:
+    explicit Charge(Domain d, qint64 bytes = 0): m_domain(d){ set(bytes); }
+    ~Charge(){ if(m_bytes) release(m_domain, m_bytes); }
+    Charge(const Charge&) = delete;
+    Charge& operator=(const Charge&) = delete;
+
+    // This method changes the accounted size; growing counts as an allocation.
+    void set(qint64 bytes);
+
+private:
+    Domain m_domain;
+    qint64 m_bytes{0};
+};
+
+} // namespace Memory
+
+#endif // MEMORYACCOUNTING_H
@@ -0,0 +1,193 @@
+#include "Trace.h"
+#include <QCoreApplication>
+#include <QRandomGenerator>
+#include <QSaveFile>
+#include <QThread>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+// One recorded event: a complete span ('X'), or the start ('s') or end ('f') of a flow.
+struct Event{
+    const char* name{};
+    qint64 startUs{0};
+    qint64 durationUs{0};
+    quint64 traceId{0};
+    char phase{'X'};
+};
+
+// The ring buffer of one thread. Only its thread writes to it; the lock is there for toJson().
+struct ThreadBuffer{
+    std::mutex lock;
+    std::vector<Event> events;
+    quint64 written{0};
+    int tid{0};
+    QString name;
+};
+
+// Every thread's buffer, kept after the thread has finished so its events can still be dumped.
+struct Registry{
+    std::mutex lock;
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    QString processName;
+    int nextTid{1};
+};
+
+Registry& registry(){
+    static Registry r;
+    return r;
+}
+
+// The wall-clock time at the first use and the monotonic clock measured from there.
+struct Clock{
+    std::chrono::steady_clock::time_point steady0{std::chrono::steady_clock::now()};
+    qint64 epochUs{std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count()};
+};
+
+const Clock& traceClock(){
+    static const Clock c;
+    return c;
+}
+
+// This helper returns the calling thread's buffer, registering it on first use.
+ThreadBuffer& threadBuffer(){
+    thread_local const std::shared_ptr<ThreadBuffer> buffer = []{
+        auto b = std::make_shared<ThreadBuffer>();
+        b->events.reserve(1024);
+        QThread* thread = QThread::currentThread();
+        b->name = thread ? thread->objectName() : QString();
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.lock);
+        b->tid = r.nextTid++;
+        if(b->name.isEmpty()){
+            const bool main = QCoreApplication::instance() && thread == QCoreApplication::instance()->thread();
+            b->name = main ? QStringLiteral("main") : QStringLiteral("thread %1").arg(b->tid);
+        }
+        r.buffers.push_back(b);
+        return b;
+    }();
+    return *buffer;
+}
+
+// This helper appends an event to the calling thread's ring, overwriting the oldest once it is full.
+void push(const Event& e){
+    ThreadBuffer& b = threadBuffer();
+    std::lock_guard<std::mutex> lock(b.lock);
+    if(b.events.size() < size_t(Trace::EventsPerThread)) b.events.push_back(e);
+    else b.events[size_t(b.written % Trace::EventsPerThread)] = e;
+    ++b.written;
+}
+
+// This helper quotes a string for JSON.
+QByteArray quoted(const QString& text){
+    QByteArray out = "\"";
+    for(const QChar c: text){
+        if(c == QLatin1Char('"') || c == QLatin1Char('\\')) out += '\\';
+        if(c.unicode() < 0x20) out += ' ';
+        else out += QString(c).toUtf8();
+    }
+    return out + '"';
+}
+
+} // namespace
+
+// This function turns recording on or off.
+void Trace::setEnabled(bool on){
+    active.store(on, std::memory_order_relaxed);
+}
+
+// This function names the process in the dump.
+void Trace::setProcessName(const QString& name){
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.lock);
+    r.processName = name;
+}
+
+// This function looks at CARGO_TRACE once at startup.
+QString Trace::enableFromEnvironment(const QString& processName){
+    const QString path = qEnvironmentVariable(EnvironmentVariable);
+    if(path.isEmpty()) return QString();
+    setProcessName(processName);
+    setEnabled(true);
+    return path;
+}
+
+// This function draws a random id; zero means "no trace id".
+quint64 Trace::newId(){
+    return QRandomGenerator::global()->generate64() | 1u;
+}
+
+// This function adds the monotonic time since the first call to the wall-clock time of that call, so
+// timestamps never jump but still compare across processes.
+qint64 Trace::nowUs(){
+    const Clock& c = traceClock();
+    return c.epochUs + std::chrono::duration_cast<std::chrono::microseconds>(
+                           std::chrono::steady_clock::now() - c.steady0).count();
+}
+
+// This function records a complete span.
+void Trace::record(const char* name, qint64 startUs, qint64 durationUs, quint64 traceId){
+    push({name, startUs, durationUs, traceId, 'X'});
+}
+
+// This function records the start of a flow at the current time.
+void Trace::flowStart(quint64 traceId){
+    if(enabled() && traceId) push({"manifest", nowUs(), 0, traceId, 's'});
+}
+
+// This function records the end of a flow at the current time.
+void Trace::flowEnd(quint64 traceId){
+    if(enabled() && traceId) push({"manifest", nowUs(), 0, traceId, 'f'});
+}
+
+// This function writes the process and thread names as metadata events, then every buffered event.
+QByteArray Trace::toJson(){
+    const QByteArray pid = QByteArray::number(QCoreApplication::applicationPid());
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    QString processName;
+    {
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.lock);
+        buffers = r.buffers;
+        processName = r.processName.isEmpty() ? QCoreApplication::applicationName() : r.processName;
+    }
+
+    QByteArray out = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    out += "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" + pid + ",\"tid\":0,\"args\":{\"name\":"
+           + quoted(processName) + "}}";
+    for(const auto& b: buffers){
+        std::lock_guard<std::mutex> lock(b->lock);
+        const QByteArray tid = QByteArray::number(b->tid);
+        out += ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" + pid + ",\"tid\":" + tid
+               + ",\"args\":{\"name\":" + quoted(b->name) + "}}";
+        for(const Event& e: b->events){
+            const QByteArray id = "\"0x" + QByteArray::number(e.traceId, 16) + '"';
+            out += ",\n{\"name\":\"" + QByteArray(e.name) + "\",\"cat\":\"cargo\",\"ph\":\"" + e.phase
+                   + "\",\"ts\":" + QByteArray::number(e.startUs) + ",\"pid\":" + pid + ",\"tid\":" + tid;
+            if(e.phase == 'X'){
+                out += ",\"dur\":" + QByteArray::number(e.durationUs);
+                if(e.traceId) out += ",\"args\":{\"trace\":" + id + '}';
+            } else {
+                out += ",\"id\":" + id;
+                if(e.phase == 'f') out += ",\"bp\":\"e\"";
+            }
+            out += '}';
+        }
+    }
+    out += "\n]}\n";
+    return out;
+}
+
+// This function writes the trace atomically, so a viewer never sees half a file.
+bool Trace::dump(const QString& path, QString* error){
+    QSaveFile file(path);
+    if(!file.open(QIODevice::WriteOnly) || file.write(toJson()) < 0 || !file.commit()){
+        if(error) *error = file.errorString();
+        return false;
+    }
+    return true;
+}
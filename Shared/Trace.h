@@ -0,0 +1,76 @@
+#ifndef TRACE_H
+#define TRACE_H
+#include <QByteArray>
+#include <QString>
+#include <QtGlobal>
+#include <atomic>
+
+// The Trace namespace records timed spans into per-thread ring buffers and writes them out in the
+// Chrome trace-event JSON format (open the file in chrome://tracing or ui.perfetto.dev). Recording is
+// off until enabled; a span then costs two clock reads and an uncontended lock on its own thread's
+// buffer, and each buffer keeps only the last EventsPerThread events, so tracing can stay on for hours.
+// Timestamps are wall-clock microseconds, so the client's and the server's dumps line up when merged.
+// A manifest carries its trace id in the traceId attribute (hexadecimal) of its <pallets> element: the
+// client starts a flow with that id where it builds the manifest and the server ends it where it parses
+// it, so the viewer draws an arrow from the client's post to the server's work on it.
+namespace Trace{
+
+// The events kept per thread; older ones are overwritten.
+constexpr int EventsPerThread = 16384;
+// The environment variable that turns tracing on and names the file the trace is written to at exit.
+constexpr char EnvironmentVariable[] = "CARGO_TRACE";
+
+// Whether spans are recorded. Read with enabled(); kept here so the check inlines to one load.
+inline std::atomic<bool> active{false};
+
+// This function tells whether spans are being recorded.
+inline bool enabled(){ return active.load(std::memory_order_relaxed); }
+// This function turns recording on or off. Events already recorded are kept.
+void setEnabled(bool on);
+// This function sets the process name shown in the viewer.
+void setProcessName(const QString& name);
+// This function enables tracing if CARGO_TRACE is set, and returns the file named there (or an empty string).
+QString enableFromEnvironment(const QString& processName);
+
+// This function returns a new, non-zero trace id.
+quint64 newId();
+// This function returns the current time in microseconds since the epoch, on a monotonic clock.
+qint64 nowUs();
+// This function records a finished span. Name must be a string literal (it is kept by pointer).
+void record(const char* name, qint64 startUs, qint64 durationUs, quint64 traceId);
+// These functions start and end the flow arrow of a trace id; call them inside the span to attach to.
+void flowStart(quint64 traceId);
+void flowEnd(quint64 traceId);
+
+// This function returns every thread's recorded events as a Chrome trace-event JSON document.
+QByteArray toJson();
+// This function writes toJson() to a file. It returns false and sets error if the file cannot be written.
+bool dump(const QString& path, QString* error);
+
+// The Span class times the scope it lives in and records it when the scope ends. Use TRACE_SPAN.
+class Span{
+public:
+    // This is the constructor. It reads the clock only if tracing is enabled.
+    explicit Span(const char* name): m_name(enabled() ? name : nullptr), m_startUs(m_name ? nowUs() : 0) {}
+    // The destructor records the span.
+    ~Span(){ if(m_name) record(m_name, m_startUs, nowUs() - m_startUs, m_traceId); }
+    Span(const Span&) = delete;
+    Span& operator=(const Span&) = delete;
+
+    // This method tags the span with the trace id of the manifest it works on.
+    void setTraceId(quint64 traceId){ m_traceId = traceId; }
+
+private:
+    const char* m_name;
+    qint64 m_startUs;
+    quint64 m_traceId{0};
+};
+
+} // namespace Trace
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+// Times the rest of the enclosing scope as a span called name.
+#define TRACE_SPAN(name) Trace::Span TRACE_CONCAT(traceSpan_, __LINE__)(name)
+
+#endif // TRACE_H
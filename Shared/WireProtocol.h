@@ -0,0 +1,294 @@
+#ifndef WIREPROTOCOL_H
+#define WIREPROTOCOL_H
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+#include <QtEndian>
+#include <QtGlobal>
+#include <array>
+#include <cstring>
+#include "Crc32.h"
+
+// The Wire namespace defines the binary protocol between the client and the server.
+// Every message is a frame: payload length (u32) | frame type (u8) | request id (u32) | payload.
+// All integers are little-endian. A client sends one request frame per query or manifest; the server
+// answers with frames carrying the same request id, so several requests can be in flight at once.
+// Row results are streamed as several Rows frames of at most RowsPerFrame rows each, the last one
+// flagged, so a large result never has to be held as one message by either side. A manifest too large
+// for one frame, or too large to resend from scratch after a dropped connection, is uploaded as
+// numbered ManifestChunk frames instead (see ChunkHeader).
+namespace Wire{
+
+// The TCP ports the server accepts manifests and answers queries on.
+constexpr quint16 DefaultManifestPort = 6164;
+constexpr quint16 DefaultQueryPort = 6165;
+
+// The local socket the server also accepts manifests on is named after its manifest port, so servers on
+// different ports on one host each get their own. A client on the same host prefers it to TCP, and over it
+// can hand manifests through shared memory instead of the socket (see AttachRing).
+constexpr char LocalNamePrefix[] = "cargo-tracker-manifests-";
+
+// This function returns the local socket name of the server taking manifests on the given port.
+inline QString localName(quint16 manifestPort){
+    return QLatin1String(LocalNamePrefix) + QString::number(manifestPort);
+}
+
+// The bytes a client sends first on the manifest port to use framed manifests with acknowledgements.
+// Without them the server treats the connection as one bare XML manifest ending at disconnect.
+constexpr char ManifestMagic[4] = {'C', 'T', 'P', '1'};
+
+// The frame header size, and the largest payload a receiver accepts before dropping the connection.
+constexpr int HeaderBytes = 9;
+constexpr quint32 MaxPayloadBytes = 16 * 1024 * 1024;
+
+// The default size of one manifest chunk; manifests larger than the chunk size are uploaded in chunks.
+constexpr qint64 DefaultChunkBytes = 1024 * 1024;
+
+// The most rows in one Rows frame, and the most rows one page query may ask for.
+constexpr quint32 RowsPerFrame = 4096;
+constexpr quint32 MaxPageRows = 65536;
+
+// The frame types. Requests have the high bit clear, responses have it set.
+enum class Frame : quint8{
+    QueryPallet = 0x01,       // i32 pallet number
+    QueryCode = 0x02,         // u32 packed code (see ContainerCode)
+    QueryAggregates = 0x03,   // u32 number of heaviest pallets wanted
+    QueryPage = 0x04,         // u32 first row, u32 row count; rows are ordered by pallet
+    Manifest = 0x10,          // UTF-8 XML manifest; the request id is the client's sequence number
+    ManifestChunk = 0x11,     // ChunkHeader, then the chunk's bytes; the last chunk is answered like a Manifest
+    AttachRing = 0x12,        // UTF-8 shared memory key (local socket only); answered with Ack or Nack
+    RingManifest = 0x13,      // u32 offset, u32 length of a manifest in the attached ring; answered like a Manifest
+    Rows = 0x81,              // u32 total rows, u32 first row of this frame, u8 last frame, u32 count, rows
+    Aggregates = 0x82,        // see writeAggregates()
+    Ack = 0x90,               // u32 containers accepted; the manifest is merged (and logged, if enabled)
+    Nack = 0x91,              // u8 NackReason, UTF-8 message
+    ChunkAck = 0x92,          // u32 chunk index, u32 next chunk the server expects (<= index: chunk refused)
+    Error = 0xFF,             // UTF-8 message
+};
+
+// Why the server rejected a manifest.
+enum class NackReason : quint8{
+    ParseError = 1,           // The XML is not a valid manifest; sending it again will not help.
+    TooLarge = 2,             // The frame exceeds MaxPayloadBytes; the connection is closed.
+    ServerError = 3,          // The server could not store it; a later retry may succeed.
+};
+
+// This function tells whether a manifest rejected for the given reason is worth sending again.
+inline bool isRetryable(NackReason reason){
+    return reason == NackReason::ServerError;
+}
+
+// One container row as it travels on the wire (RowBytes bytes).
+struct Row{
+    qint32 pallet{0};
+    quint8 type{0};           // 0 = Box, 1 = Cylinder, 2 = unknown.
+    quint32 code{0};          // Packed code, 0 when the posted code was invalid.
+    qint32 height{0};
+    qint32 weight{0};
+    qint32 length{0};
+    qint32 breadth{0};
+    qint32 diameter{0};
+};
+constexpr int RowBytes = 29;
+
+// The totals of one container type.
+struct TypeTotal{
+    qint64 containers{0};
+    double volume{0};
+};
+
+// The number of containers with codes from one month.
+struct MonthCount{
+    quint16 year{0};
+    quint8 month{0};
+    qint64 containers{0};
+};
+
+// The totals of one pallet.
+struct PalletTotal{
+    qint32 pallet{0};
+    qint64 containers{0};
+    qint64 weight{0};
+    double volume{0};
+};
+
+// The server-wide aggregates returned by QueryAggregates.
+struct Aggregates{
+    qint64 containers{0};
+    qint64 pallets{0};
+    qint64 weight{0};
+    std::array<TypeTotal, 3> types;          // Box, Cylinder, unknown.
+    QVector<MonthCount> months;              // Oldest first.
+    QVector<PalletTotal> heaviest;           // Heaviest first.
+};
+
+// The Writer class appends little-endian values to a byte array.
+class Writer{
+public:
+    explicit Writer(QByteArray& out): m_out(out) {}
+
+    void u8(quint8 v){ m_out.append(char(v)); }
+    void u16(quint16 v){ put(v); }
+    void u32(quint32 v){ put(v); }
+    void i32(qint32 v){ put(quint32(v)); }
+    void i64(qint64 v){ put(quint64(v)); }
+    void f64(double v){ quint64 bits; std::memcpy(&bits, &v, sizeof bits); put(bits); }
+
+    // This method appends one row.
+    void row(const Row& r){
+        i32(r.pallet); u8(r.type); u32(r.code);
+        i32(r.height); i32(r.weight); i32(r.length); i32(r.breadth); i32(r.diameter);
+    }
+
+private:
+    template<typename T> void put(T v){
+        char bytes[sizeof(T)];
+        qToLittleEndian(v, bytes);
+        m_out.append(bytes, sizeof(T));
+    }
+    QByteArray& m_out;
+};
+
+// The Reader class reads little-endian values from a payload. Reading past the end sets ok() to false
+// and yields zeros, so a decoder can read everything first and check once at the end.
+class Reader{
+public:
+    explicit Reader(const QByteArray& in): m_p(in.constData()), m_end(in.constData() + in.size()) {}
+
+    quint8 u8(){ return get<quint8>(); }
+    quint16 u16(){ return get<quint16>(); }
+    quint32 u32(){ return get<quint32>(); }
+    qint32 i32(){ return qint32(get<quint32>()); }
+    qint64 i64(){ return qint64(get<quint64>()); }
+    double f64(){ const quint64 bits = get<quint64>(); double v; std::memcpy(&v, &bits, sizeof v); return v; }
+
+    // This method reads one row.
+    Row row(){
+        Row r;
+        r.pallet = i32(); r.type = u8(); r.code = u32();
+        r.height = i32(); r.weight = i32(); r.length = i32(); r.breadth = i32(); r.diameter = i32();
+        return r;
+    }
+
+    // This method returns false if any read ran past the end of the payload.
+    bool ok() const{ return m_ok; }
+    // This method returns the number of unread bytes.
+    qsizetype remaining() const{ return m_end - m_p; }
+
+private:
+    template<typename T> T get(){
+        if(m_end - m_p < qsizetype(sizeof(T))){
+            m_ok = false;
+            m_p = m_end;
+            return T(0);
+        }
+        const T v = qFromLittleEndian<T>(m_p);
+        m_p += sizeof(T);
+        return v;
+    }
+    const char* m_p;
+    const char* m_end;
+    bool m_ok{true};
+};
+
+// The ChunkHeader struct starts every ManifestChunk payload (ChunkHeaderBytes bytes).
+// The upload id is chosen by the client and stays the same across reconnects, so the server can keep
+// the chunks it already has and the client resumes from the last acknowledged one. The server accepts
+// chunks strictly in order; it acknowledges a repeated chunk again and refuses a damaged or
+// out-of-order one, after which the client sends again from the chunk the server expects.
+struct ChunkHeader{
+    quint64 upload{0};        // The client's id for this manifest.
+    quint64 totalBytes{0};    // The size of the whole manifest.
+    quint32 index{0};         // This chunk's number, from 0.
+    quint32 count{0};         // The number of chunks.
+    quint32 crc{0};           // CRC-32 of this chunk's bytes.
+};
+constexpr int ChunkHeaderBytes = 28;
+
+// This function encodes one chunk of a manifest.
+inline QByteArray writeChunk(ChunkHeader h, const char* data, qsizetype len){
+    QByteArray out;
+    out.reserve(ChunkHeaderBytes + len);
+    Writer w(out);
+    h.crc = Crc32::of(data, len);
+    w.i64(qint64(h.upload)); w.i64(qint64(h.totalBytes)); w.u32(h.index); w.u32(h.count); w.u32(h.crc);
+    out.append(data, len);
+    return out;
+}
+
+// This function decodes a ManifestChunk payload. It returns false if the header is truncated or the
+// bytes do not match the checksum.
+inline bool readChunk(const QByteArray& payload, ChunkHeader& h, QByteArray& data){
+    Reader r(payload);
+    h.upload = quint64(r.i64()); h.totalBytes = quint64(r.i64());
+    h.index = r.u32(); h.count = r.u32(); h.crc = r.u32();
+    if(!r.ok()) return false;
+    data = payload.mid(ChunkHeaderBytes);
+    return Crc32::of(data.constData(), data.size()) == h.crc;
+}
+
+// This function wraps a payload into a complete frame.
+inline QByteArray frame(Frame type, quint32 id, const QByteArray& payload = QByteArray()){
+    QByteArray out;
+    out.reserve(HeaderBytes + payload.size());
+    Writer w(out);
+    w.u32(quint32(payload.size()));
+    w.u8(quint8(type));
+    w.u32(id);
+    out.append(payload);
+    return out;
+}
+
+// The result of takeFrame().
+enum class TakeResult{ Frame, NeedMore, Malformed };
+
+// This function removes the first complete frame from a receive buffer. It returns NeedMore if the
+// frame has not fully arrived yet and Malformed if the announced length is larger than allowed.
+inline TakeResult takeFrame(QByteArray& buffer, Frame& type, quint32& id, QByteArray& payload){
+    if(buffer.size() < HeaderBytes) return TakeResult::NeedMore;
+    const quint32 length = qFromLittleEndian<quint32>(buffer.constData());
+    if(length > MaxPayloadBytes) return TakeResult::Malformed;
+    if(buffer.size() < HeaderBytes + qsizetype(length)) return TakeResult::NeedMore;
+    type = Frame(quint8(buffer.at(4)));
+    id = qFromLittleEndian<quint32>(buffer.constData() + 5);
+    payload = buffer.mid(HeaderBytes, length);
+    buffer.remove(0, HeaderBytes + length);
+    return TakeResult::Frame;
+}
+
+// This function encodes the aggregates payload:
+// containers, pallets, weight (i64) | per type: containers (i64), volume (f64) |
+// month count (u32), then year (u16), month (u8), containers (i64) each |
+// pallet count (u32), then pallet (i32), containers, weight (i64), volume (f64) each.
+inline QByteArray writeAggregates(const Aggregates& a){
+    QByteArray out;
+    Writer w(out);
+    w.i64(a.containers); w.i64(a.pallets); w.i64(a.weight);
+    for(const TypeTotal& t: a.types){ w.i64(t.containers); w.f64(t.volume); }
+    w.u32(quint32(a.months.size()));
+    for(const MonthCount& m: a.months){ w.u16(m.year); w.u8(m.month); w.i64(m.containers); }
+    w.u32(quint32(a.heaviest.size()));
+    for(const PalletTotal& p: a.heaviest){ w.i32(p.pallet); w.i64(p.containers); w.i64(p.weight); w.f64(p.volume); }
+    return out;
+}
+
+// This function decodes an aggregates payload. It returns false if the payload is truncated.
+inline bool readAggregates(const QByteArray& payload, Aggregates& a){
+    Reader r(payload);
+    a.containers = r.i64(); a.pallets = r.i64(); a.weight = r.i64();
+    for(TypeTotal& t: a.types){ t.containers = r.i64(); t.volume = r.f64(); }
+    // Counts are checked against the bytes left so a corrupt count cannot trigger a huge allocation.
+    const quint32 months = r.u32();
+    if(quint64(months) * 11 > quint64(r.remaining())) return false;
+    a.months.resize(months);
+    for(MonthCount& m: a.months){ m.year = r.u16(); m.month = r.u8(); m.containers = r.i64(); }
+    const quint32 pallets = r.u32();
+    if(quint64(pallets) * 28 > quint64(r.remaining())) return false;
+    a.heaviest.resize(pallets);
+    for(PalletTotal& p: a.heaviest){ p.pallet = r.i32(); p.containers = r.i64(); p.weight = r.i64(); p.volume = r.f64(); }
+    return r.ok();
+}
+
+} // namespace Wire
+
+#endif // WIREPROTOCOL_H